@@ -31,3 +31,37 @@ function(add_aktualizr_test)
     add_dependencies(build_tests ${TEST_TARGET})
     set(TEST_SOURCES ${TEST_SOURCES} ${AKTUALIZR_TEST_SOURCES} PARENT_SCOPE)
 endfunction(add_aktualizr_test)
+
+# Benchmarks are only built if Google Benchmark is available; they are not run
+# by ctest. Build them all with `make libaktualizr_benchmarks`, or build and run
+# them with `make run_libaktualizr_benchmarks`, which writes the aggregated
+# results of each benchmark to benchmarks/<name>.json in the build directory.
+function(add_aktualizr_benchmark)
+    set(oneValueArgs NAME)
+    set(multiValueArgs SOURCES LIBRARIES)
+    cmake_parse_arguments(AKTUALIZR_BENCHMARK "" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+    set(BENCHMARK_TARGET b_${AKTUALIZR_BENCHMARK_NAME})
+
+    if(benchmark_FOUND)
+        add_executable(${BENCHMARK_TARGET} EXCLUDE_FROM_ALL ${AKTUALIZR_BENCHMARK_SOURCES})
+        target_link_libraries(${BENCHMARK_TARGET}
+            ${AKTUALIZR_BENCHMARK_LIBRARIES}
+            benchmark::benchmark
+            testutilities
+            aktualizr_lib)
+        target_include_directories(${BENCHMARK_TARGET} PUBLIC ${PROJECT_SOURCE_DIR}/tests)
+        add_dependencies(libaktualizr_benchmarks ${BENCHMARK_TARGET})
+
+        add_custom_target(run_${BENCHMARK_TARGET}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${PROJECT_BINARY_DIR}/benchmarks
+            COMMAND ${BENCHMARK_TARGET}
+                --benchmark_repetitions=5
+                --benchmark_report_aggregates_only=true
+                --benchmark_out=${PROJECT_BINARY_DIR}/benchmarks/${AKTUALIZR_BENCHMARK_NAME}.json
+                --benchmark_out_format=json
+            WORKING_DIRECTORY ${PROJECT_SOURCE_DIR}
+            DEPENDS ${BENCHMARK_TARGET})
+        add_dependencies(run_libaktualizr_benchmarks run_${BENCHMARK_TARGET})
+    endif()
+    set(BENCHMARK_SOURCES ${BENCHMARK_SOURCES} ${AKTUALIZR_BENCHMARK_SOURCES} PARENT_SCOPE)
+endfunction(add_aktualizr_benchmark)
@@ -17,6 +17,10 @@ namespace api {
 class CommandQueue;
 }
 
+namespace event {
+class AsyncDispatcher;
+}
+
 /**
  * This class provides the main APIs necessary for launching and controlling
  * libaktualizr.
@@ -330,6 +334,13 @@ class Aktualizr {
    */
   boost::signals2::connection SetSignalHandler(const SigHandler& handler);
 
+  /**
+   * Counters of the asynchronous event dispatcher. Only meaningful when
+   * `uptane.event_queue_size` is not zero; otherwise events are delivered
+   * synchronously and all counters are zero.
+   */
+  event::DispatcherStats GetEventDispatcherStats() const;
+
   /**
    * @brief Initialize libcurl based  http client with https://curl.se/libcurl/c/CURLOPT_PROXY.html[CURLOPT_PROXY]. For string format see documentation on https://curl.se/libcurl/c/CURLOPT_PROXY.html[CURLOPT_PROXY]. This options has no effect when downloading OSTREE update. Call it before call to Aktualizr::Initialize()
    * 
@@ -367,6 +378,9 @@ class Aktualizr {
   std::shared_ptr<INvStorage> storage_;
   std::shared_ptr<event::Channel> sig_;
   std::unique_ptr<api::CommandQueue> api_queue_;
+  // Delivers the events of uptane_client_ to sig_ when uptane.event_queue_size is set.
+  std::unique_ptr<event::AsyncDispatcher> event_dispatcher_;
+  boost::signals2::connection event_dispatcher_connection_;
 };
 
 #endif  // AKTUALIZR_H_
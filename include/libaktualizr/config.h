@@ -72,6 +72,12 @@ struct UptaneConfig {
   bool force_install_completion{false};
   boost::filesystem::path secondary_config_file;
   uint64_t secondary_preinstall_wait_sec{600U};
+  uint64_t event_queue_size{0U};
+  uint64_t secondary_metadata_concurrency{8U};
+  uint64_t secondary_install_concurrency{0U};
+  std::string secondary_type_concurrency;
+  std::string secondary_install_order{"default"};
+  std::string secondary_critical_ecus;
 
   void updateFromPropertyTree(const boost::property_tree::ptree& pt);
   void writeToStream(std::ostream& out_stream) const;
@@ -2,6 +2,7 @@
 #define EVENTS_H_
 /** \file */
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -192,6 +193,20 @@ class CampaignPostponeComplete : public BaseEvent {
 
 using Channel = boost::signals2::signal<void(std::shared_ptr<event::BaseEvent>)>;
 
+/**
+ * Counters of the asynchronous event dispatcher (see `uptane.event_queue_size`).
+ */
+struct DispatcherStats {
+  /** Events emitted by libaktualizr. */
+  uint64_t posted{0};
+  /** Progress reports replaced by a more recent one for the same target before being delivered. */
+  uint64_t coalesced{0};
+  /** Progress reports discarded because the queue was full. */
+  uint64_t dropped{0};
+  /** Largest number of events waiting for delivery at any time. */
+  uint64_t max_queue_size{0};
+};
+
 }  // namespace event
 
 #endif  // EVENTS_H_
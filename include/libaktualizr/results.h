@@ -2,6 +2,7 @@
 #define RESULTS_H_
 /** \file */
 
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -147,6 +148,10 @@ class Install {
     Uptane::Target update;
     Uptane::EcuSerial serial;
     data::InstallationResult install_res;
+    /** Time spent waiting for other Secondary installations to complete before this one could start. */
+    std::chrono::milliseconds queue_time{0};
+    /** Time spent sending the firmware to the Secondary and installing it. */
+    std::chrono::milliseconds active_time{0};
   };
 };
 
@@ -1,6 +1,9 @@
 #ifndef UPTANE_SECONDARY_PROVIDER_H
 #define UPTANE_SECONDARY_PROVIDER_H
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include "libaktualizr/config.h"
@@ -9,6 +12,7 @@
 class INvStorage;
 
 class SecondaryProviderBuilder;
+class SharedTargetReader;
 
 class SecondaryProvider {
  public:
@@ -20,6 +24,18 @@ class SecondaryProvider {
                             std::string* targets) const;
   std::string getTreehubCredentials() const;
   std::ifstream getTargetFileHandle(const Uptane::Target& target) const;
+  /**
+   * Open a target file to send it to a Secondary. If the target is being
+   * shared, the stream reads from the data read once for all the Secondaries
+   * that receive it.
+   */
+  std::unique_ptr<std::istream> getTargetStream(const Uptane::Target& target) const;
+  /**
+   * Read the target file only once for all the Secondaries that open it until
+   * unshareTargets() is called. A file that cannot be opened is not shared.
+   */
+  void shareTarget(const Uptane::Target& target);
+  void unshareTargets();
 
  private:
   SecondaryProvider(Config& config_in, const std::shared_ptr<const INvStorage>& storage_in,
@@ -29,6 +45,8 @@ class SecondaryProvider {
   Config& config_;
   const std::shared_ptr<const INvStorage> storage_;
   const std::shared_ptr<const PackageManagerInterface> package_manager_;
+  mutable std::mutex shared_targets_mutex_;
+  std::map<std::string, std::shared_ptr<SharedTargetReader>> shared_targets_;
 };
 
 #endif  // UPTANE_SECONDARY_PROVIDER_H
@@ -3,6 +3,7 @@
 /** \file */
 
 #include <algorithm>
+#include <memory>
 #include <stdexcept>
 #include <unordered_map>
 
@@ -383,33 +384,37 @@ class Target {
   // Internal use only. Only used for reading installed_versions list and by
   // various tests.
   Target(std::string filename, EcuMap ecus, std::vector<Hash> hashes, uint64_t length, std::string correlation_id = "");
+  // Copying only shares the data. There is no move constructor, so that a
+  // moved-from Target stays usable.
+  Target(const Target &) = default;
+  Target &operator=(const Target &) = default;
 
   static Target Unknown();
 
-  const EcuMap &ecus() const { return ecus_; }
-  std::string filename() const { return filename_; }
+  const EcuMap &ecus() const { return data_->ecus; }
+  std::string filename() const { return data_->filename; }
   std::string sha256Hash() const;
   std::string sha512Hash() const;
-  const std::vector<Hash> &hashes() const { return hashes_; }
-  const std::vector<HardwareIdentifier> &hardwareIds() const { return hwids_; }
+  const std::vector<Hash> &hashes() const { return data_->hashes; }
+  const std::vector<HardwareIdentifier> &hardwareIds() const { return data_->hwids; }
   std::string custom_version() const;
-  Json::Value custom_data() const { return custom_; }
+  Json::Value custom_data() const;
   void updateCustom(const Json::Value &custom);
-  std::string correlation_id() const { return correlation_id_; }
-  void setCorrelationId(std::string correlation_id) { correlation_id_ = std::move(correlation_id); }
-  uint64_t length() const { return length_; }
+  std::string correlation_id() const { return data_->correlation_id; }
+  void setCorrelationId(std::string correlation_id) { mutableData().correlation_id = std::move(correlation_id); }
+  uint64_t length() const { return data_->length; }
   bool IsValid() const { return valid; }
-  std::string uri() const { return uri_; }
-  void setUri(std::string uri) { uri_ = std::move(uri); }
+  std::string uri() const { return data_->uri; }
+  void setUri(std::string uri) { mutableData().uri = std::move(uri); }
   bool MatchHash(const Hash &hash) const;
 
-  void InsertEcu(const std::pair<EcuSerial, HardwareIdentifier> &pair) { ecus_.insert(pair); }
+  void InsertEcu(const std::pair<EcuSerial, HardwareIdentifier> &pair) { mutableData().ecus.insert(pair); }
 
   bool IsForEcu(const EcuSerial &ecuIdentifier) const {
-    return (std::find_if(ecus_.cbegin(), ecus_.cend(),
+    return (std::find_if(data_->ecus.cbegin(), data_->ecus.cend(),
                          [&ecuIdentifier](const std::pair<EcuSerial, HardwareIdentifier> &pair) {
                            return pair.first == ecuIdentifier;
-                         }) != ecus_.cend());
+                         }) != data_->ecus.cend());
   }
 
   /**
@@ -419,7 +424,7 @@ class Target {
    * root commit object.
    */
   bool IsOstree() const;
-  std::string type() const { return type_; }
+  std::string type() const { return data_->type; }
 
   // Comparison is usually not meaningful. Use MatchTarget instead.
   bool operator==(const Target &t2) = delete;
@@ -429,18 +434,24 @@ class Target {
   InstalledImageInfo getTargetImageInfo() const { return {filename(), length(), sha256Hash()}; }
 
  private:
-  bool valid{true};
-  std::string filename_;
-  std::string type_;
-  EcuMap ecus_;  // Director only
-  std::vector<Hash> hashes_;
-  std::vector<HardwareIdentifier> hwids_;  // Image repo only
-  Json::Value custom_;
-  uint64_t length_{0};
-  std::string correlation_id_;
-  std::string uri_;
+  // Copies of a Target share the same data until one of them is modified.
+  struct Data {
+    std::string filename;
+    std::string type;
+    EcuMap ecus;  // Director only
+    std::vector<Hash> hashes;
+    std::vector<HardwareIdentifier> hwids;  // Image repo only
+    Json::Value custom;
+    uint64_t length{0};
+    std::string correlation_id;
+    std::string uri;
+  };
 
+  Data &mutableData();
   std::string hashString(Hash::Type type) const;
+
+  bool valid{true};
+  std::shared_ptr<Data> data_;
 };
 
 std::ostream &operator<<(std::ostream &os, const Target &t);
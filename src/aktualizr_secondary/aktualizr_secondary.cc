@@ -1,5 +1,6 @@
 #include "aktualizr_secondary.h"
 
+#include "crypto/crypto.h"
 #include "crypto/keymanager.h"
 #include "logging/logging.h"
 #include "update_agent.h"
@@ -72,28 +73,19 @@ data::InstallationResult AktualizrSecondary::doFullVerification(const Metadata&
   //    We trust the time that the given system/ECU provides.
   TimeStamp now(TimeStamp::Now());
 
-  // 2. Download and check the Root metadata file from the Director repository.
-  // 3. NOT SUPPORTED: Download and check the Timestamp metadata file from the Director repository.
-  // 4. NOT SUPPORTED: Download and check the Snapshot metadata file from the Director repository.
-  // 5. Download and check the Targets metadata file from the Director repository.
-  try {
-    director_repo_.updateMeta(*storage_, metadata);
-  } catch (const std::exception& e) {
-    LOG_ERROR << "Failed to update Director metadata: " << e.what();
-    return data::InstallationResult(data::ResultCode::Numeric::kVerificationFailed,
-                                    std::string("Failed to update Director metadata: ") + e.what());
-  }
-
-  // 6. Download and check the Root metadata file from the Image repository.
-  // 7. Download and check the Timestamp metadata file from the Image repository.
-  // 8. Download and check the Snapshot metadata file from the Image repository.
-  // 9. Download and check the top-level Targets metadata file from the Image repository.
-  try {
-    image_repo_.updateMeta(*storage_, metadata);
-  } catch (const std::exception& e) {
-    LOG_ERROR << "Failed to update Image repo metadata: " << e.what();
-    return data::InstallationResult(data::ResultCode::Numeric::kVerificationFailed,
-                                    std::string("Failed to update Image repo metadata: ") + e.what());
+  // 2.-9. Download and check the metadata from the Director and Image repositories.
+  // The Primary sends the same metadata again, for example when it retries a
+  // failed installation. The repositories still hold that metadata, so it
+  // only has to be checked for expiration.
+  Uptane::MetaBundle latest_meta;
+  if (isMetadataVerified(metadata, &latest_meta)) {
+    LOG_DEBUG << "Metadata has not changed since it was last verified.";
+  } else {
+    auto result = updateMetadata(metadata);
+    if (!result.isSuccess()) {
+      return result;
+    }
+    verified_meta_ = std::move(latest_meta);
   }
 
   // 10. Verify that Targets metadata from the Director and Image repositories match.
@@ -124,6 +116,59 @@ data::InstallationResult AktualizrSecondary::doFullVerification(const Metadata&
   return data::InstallationResult(data::ResultCode::Numeric::kOk, "");
 }
 
+bool AktualizrSecondary::isMetadataVerified(const Metadata& metadata, Uptane::MetaBundle* latest_meta) {
+  try {
+    *latest_meta = metadata.latestBundle();
+  } catch (const std::exception& e) {
+    // Let the full verification report what is missing.
+    latest_meta->clear();
+  }
+
+  if (verified_meta_.empty() || *latest_meta != verified_meta_) {
+    return false;
+  }
+
+  try {
+    director_repo_.checkMetaExpired();
+    image_repo_.checkMetaExpired();
+  } catch (const std::exception& e) {
+    LOG_INFO << "Verified metadata has expired: " << e.what();
+    return false;
+  }
+  return true;
+}
+
+data::InstallationResult AktualizrSecondary::updateMetadata(const Metadata& metadata) {
+  // Whatever the repositories hold is only partially verified until both
+  // updates succeed.
+  verified_meta_.clear();
+
+  // 2. Download and check the Root metadata file from the Director repository.
+  // 3. NOT SUPPORTED: Download and check the Timestamp metadata file from the Director repository.
+  // 4. NOT SUPPORTED: Download and check the Snapshot metadata file from the Director repository.
+  // 5. Download and check the Targets metadata file from the Director repository.
+  try {
+    director_repo_.updateMeta(*storage_, metadata);
+  } catch (const std::exception& e) {
+    LOG_ERROR << "Failed to update Director metadata: " << e.what();
+    return data::InstallationResult(data::ResultCode::Numeric::kVerificationFailed,
+                                    std::string("Failed to update Director metadata: ") + e.what());
+  }
+
+  // 6. Download and check the Root metadata file from the Image repository.
+  // 7. Download and check the Timestamp metadata file from the Image repository.
+  // 8. Download and check the Snapshot metadata file from the Image repository.
+  // 9. Download and check the top-level Targets metadata file from the Image repository.
+  try {
+    image_repo_.updateMeta(*storage_, metadata);
+  } catch (const std::exception& e) {
+    LOG_ERROR << "Failed to update Image repo metadata: " << e.what();
+    return data::InstallationResult(data::ResultCode::Numeric::kVerificationFailed,
+                                    std::string("Failed to update Image repo metadata: ") + e.what());
+  }
+  return data::InstallationResult(data::ResultCode::Numeric::kOk, "");
+}
+
 void AktualizrSecondary::uptaneInitialize() {
   if (keys_->generateUptaneKeyPair().empty()) {
     throw std::runtime_error("Failed to generate Uptane key pair");
@@ -200,9 +245,15 @@ void AktualizrSecondary::registerHandlers() {
   registerHandler(AKIpUptaneMes_PR_manifestReq,
                   std::bind(&AktualizrSecondary::getManifestHdlr, this, std::placeholders::_1, std::placeholders::_2));
 
+  registerHandler(AKIpUptaneMes_PR_manifestReq3,
+                  std::bind(&AktualizrSecondary::getManifest3Hdlr, this, std::placeholders::_1, std::placeholders::_2));
+
   registerHandler(AKIpUptaneMes_PR_putMetaReq2,
                   std::bind(&AktualizrSecondary::putMetaHdlr, this, std::placeholders::_1, std::placeholders::_2));
 
+  registerHandler(AKIpUptaneMes_PR_putMetaReq3,
+                  std::bind(&AktualizrSecondary::putMeta3Hdlr, this, std::placeholders::_1, std::placeholders::_2));
+
   registerHandler(AKIpUptaneMes_PR_installReq,
                   std::bind(&AktualizrSecondary::installHdlr, this, std::placeholders::_1, std::placeholders::_2));
 }
@@ -223,12 +274,18 @@ MsgHandler::ReturnCode AktualizrSecondary::getInfoHdlr(Asn1Message& in_msg, Asn1
 }
 
 MsgHandler::ReturnCode AktualizrSecondary::versionHdlr(Asn1Message& in_msg, Asn1Message& out_msg) {
-  const uint32_t version = 2;
+  const uint32_t version = 3;
+  // Oldest version that is still supported for older Primaries
+  const uint32_t min_version = 2;
   auto version_req = in_msg.versionReq();
   const auto primary_version = static_cast<uint32_t>(version_req->version);
-  if (primary_version < version) {
+  uint32_t agreed_version = version;
+  if (primary_version < min_version) {
     LOG_ERROR << "Primary protocol version is " << primary_version << " but Secondary version is " << version
               << "! Communication will most likely fail!";
+  } else if (primary_version < version) {
+    LOG_DEBUG << "Primary protocol version is " << primary_version << "; using it instead of version " << version;
+    agreed_version = primary_version;
   } else if (primary_version > version) {
     LOG_INFO << "Primary protocol version is " << primary_version << " but Secondary version is " << version
              << ". Please consider upgrading the Secondary.";
@@ -236,7 +293,7 @@ MsgHandler::ReturnCode AktualizrSecondary::versionHdlr(Asn1Message& in_msg, Asn1
 
   out_msg.present(AKIpUptaneMes_PR_versionResp);
   auto version_resp = out_msg.versionResp();
-  version_resp->version = version;
+  version_resp->version = agreed_version;
 
   return ReturnCode::kOk;
 }
@@ -258,6 +315,30 @@ AktualizrSecondary::ReturnCode AktualizrSecondary::getManifestHdlr(Asn1Message&
   return ReturnCode::kOk;
 }
 
+AktualizrSecondary::ReturnCode AktualizrSecondary::getManifest3Hdlr(Asn1Message& in_msg, Asn1Message& out_msg) const {
+  if (last_msg_ != AKIpUptaneMes_PR_manifestReq3) {
+    LOG_INFO << "Received a manifest request message; sending requested manifest.";
+  } else {
+    LOG_DEBUG << "Received another manifest request message; sending the same manifest.";
+  }
+
+  const std::string manifest = Utils::jsonToStr(getManifest());
+  LOG_TRACE << "Manifest: \n" << manifest;
+
+  auto manifest_resp = out_msg.present(AKIpUptaneMes_PR_manifestResp3).manifestResp3();
+  if (in_msg.manifestReq3()->compression == AKCompression_gzip) {
+    const std::string compressed = Utils::gzipCompress(manifest);
+    if (compressed.size() < manifest.size()) {
+      manifest_resp->compression = AKCompression_gzip;
+      SetString(&manifest_resp->manifest, compressed);
+      return ReturnCode::kOk;
+    }
+  }
+  manifest_resp->compression = AKCompression_none;
+  SetString(&manifest_resp->manifest, manifest);
+  return ReturnCode::kOk;
+}
+
 void AktualizrSecondary::copyMetadata(Uptane::MetaBundle& meta_bundle, const Uptane::RepositoryType repo,
                                       const Uptane::Role& role, std::string& json) {
   auto key = std::make_pair(repo, role);
@@ -328,6 +409,94 @@ AktualizrSecondary::ReturnCode AktualizrSecondary::putMetaHdlr(Asn1Message& in_m
   return ReturnCode::kOk;
 }
 
+// Adds the metadata objects of one repository in a v3 request to meta_bundle.
+// Objects that were left out are taken from the metadata verified last time.
+// Returns false if one of them is not available there.
+bool AktualizrSecondary::readMetaObjects(const AKMetaObjectCollection_t& collection, const Uptane::RepositoryType repo,
+                                         Uptane::MetaBundle& meta_bundle) const {
+  for (int i = 0; i < collection.list.count; i++) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const AKMetaObject_t& object = *collection.list.array[i];
+    const std::string role_name = ToString(object.role);
+    Uptane::Role role = Uptane::Role::InvalidRole();
+    int64_t max_size;
+    if (role_name == Uptane::Role::ROOT) {
+      role = Uptane::Role::Root();
+      max_size = Uptane::kMaxRootSize;
+    } else if (repo == Uptane::RepositoryType::Director() && role_name == Uptane::Role::TARGETS) {
+      role = Uptane::Role::Targets();
+      max_size = Uptane::kMaxDirectorTargetsSize;
+    } else if (repo == Uptane::RepositoryType::Image() && role_name == Uptane::Role::TIMESTAMP) {
+      role = Uptane::Role::Timestamp();
+      max_size = Uptane::kMaxTimestampSize;
+    } else if (repo == Uptane::RepositoryType::Image() && role_name == Uptane::Role::SNAPSHOT) {
+      role = Uptane::Role::Snapshot();
+      max_size = Uptane::kMaxSnapshotSize;
+    } else if (repo == Uptane::RepositoryType::Image() && role_name == Uptane::Role::TARGETS) {
+      role = Uptane::Role::Targets();
+      max_size = Uptane::kMaxImageTargetsSize;
+    } else {
+      LOG_WARNING << repo.toString() << " metadata contains an unexpected role: " << role_name;
+      continue;
+    }
+
+    const std::string sha256 = ToString(object.sha256);
+    std::string json = ToString(object.json);
+    if (json.empty()) {
+      const auto verified = verified_meta_.find(std::make_pair(repo, role));
+      if (verified == verified_meta_.end() || Crypto::sha256digest(verified->second) != sha256) {
+        LOG_INFO << repo.toString() << " " << role_name << " metadata was left out but is not known.";
+        return false;
+      }
+      json = verified->second;
+    } else {
+      if (object.compression == AKCompression_gzip) {
+        json = Utils::gzipDecompress(json, static_cast<size_t>(max_size));
+      } else if (object.compression != AKCompression_none) {
+        throw std::runtime_error(role_name + " metadata has an unknown compression");
+      }
+      if (Crypto::sha256digest(json) != sha256) {
+        throw std::runtime_error(role_name + " metadata does not match its hash");
+      }
+    }
+    LOG_DEBUG << "Received " << repo.toString() << " repo " << role_name << " metadata:\n" << json;
+    copyMetadata(meta_bundle, repo, role, json);
+  }
+  return true;
+}
+
+AktualizrSecondary::ReturnCode AktualizrSecondary::putMeta3Hdlr(Asn1Message& in_msg, Asn1Message& out_msg) {
+  LOG_INFO << "Received a put metadata request message; verifying contents...";
+  auto md = in_msg.putMetaReq3();
+  auto m = out_msg.present(AKIpUptaneMes_PR_putMetaResp3).putMetaResp3();
+  m->missingMeta = 0;
+
+  Uptane::MetaBundle meta_bundle;
+  data::InstallationResult result;
+  try {
+    if (readMetaObjects(md->directorRepo, Uptane::RepositoryType::Director(), meta_bundle) &&
+        readMetaObjects(md->imageRepo, Uptane::RepositoryType::Image(), meta_bundle)) {
+      if (meta_bundle.size() != 6) {
+        LOG_WARNING << "Metadata received from Primary is incomplete";
+      }
+      result = putMetadata(meta_bundle);
+    } else {
+      m->missingMeta = 1;
+      result = data::InstallationResult(data::ResultCode::Numeric::kVerificationFailed,
+                                        "Metadata that is not known to the Secondary was left out");
+    }
+  } catch (const std::exception& e) {
+    const std::string err = std::string("Failed to read the metadata received from the Primary: ") + e.what();
+    LOG_ERROR << err;
+    result = data::InstallationResult(data::ResultCode::Numeric::kVerificationFailed, err);
+  }
+
+  m->result = static_cast<AKInstallationResultCode_t>(result.result_code.num_code);
+  SetString(&m->description, result.description);
+
+  return ReturnCode::kOk;
+}
+
 AktualizrSecondary::ReturnCode AktualizrSecondary::installHdlr(Asn1Message& in_msg, Asn1Message& out_msg) {
   (void)in_msg;
   LOG_INFO << "Received an installation request message; attempting installation...";
@@ -52,7 +52,11 @@ class AktualizrSecondary : public MsgDispatcher {
  private:
   static void copyMetadata(Uptane::MetaBundle& meta_bundle, Uptane::RepositoryType repo, const Uptane::Role& role,
                            std::string& json);
+  bool readMetaObjects(const AKMetaObjectCollection_t& collection, Uptane::RepositoryType repo,
+                       Uptane::MetaBundle& meta_bundle) const;
   data::InstallationResult doFullVerification(const Metadata& metadata);
+  bool isMetadataVerified(const Metadata& metadata, Uptane::MetaBundle* latest_meta);
+  data::InstallationResult updateMetadata(const Metadata& metadata);
   void uptaneInitialize();
   void registerHandlers();
 
@@ -60,7 +64,9 @@ class AktualizrSecondary : public MsgDispatcher {
   ReturnCode getInfoHdlr(Asn1Message& in_msg, Asn1Message& out_msg) const;
   static ReturnCode versionHdlr(Asn1Message& in_msg, Asn1Message& out_msg);
   ReturnCode getManifestHdlr(Asn1Message& in_msg, Asn1Message& out_msg) const;
+  ReturnCode getManifest3Hdlr(Asn1Message& in_msg, Asn1Message& out_msg) const;
   ReturnCode putMetaHdlr(Asn1Message& in_msg, Asn1Message& out_msg);
+  ReturnCode putMeta3Hdlr(Asn1Message& in_msg, Asn1Message& out_msg);
   ReturnCode installHdlr(Asn1Message& in_msg, Asn1Message& out_msg);
 
   Uptane::HardwareIdentifier hardware_id_{Uptane::HardwareIdentifier::Unknown()};
@@ -74,6 +80,9 @@ class AktualizrSecondary : public MsgDispatcher {
 
   Uptane::DirectorRepository director_repo_;
   Uptane::ImageRepository image_repo_;
+  // The metadata the repositories have been updated with by the last
+  // successful verification. Empty if there is none.
+  Uptane::MetaBundle verified_meta_;
   Uptane::Target pending_target_{Uptane::Target::Unknown()};
 };
 
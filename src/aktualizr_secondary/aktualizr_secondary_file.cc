@@ -1,5 +1,6 @@
 #include "aktualizr_secondary_file.h"
 #include "update_agent_file.h"
+#include "update_agent_partition.h"
 
 const std::string AktualizrSecondaryFile::FileUpdateDefaultFile{"firmware.txt"};
 
@@ -8,7 +9,7 @@ AktualizrSecondaryFile::AktualizrSecondaryFile(const AktualizrSecondaryConfig& c
 
 AktualizrSecondaryFile::AktualizrSecondaryFile(const AktualizrSecondaryConfig& config,
                                                std::shared_ptr<INvStorage> storage,
-                                               std::shared_ptr<FileUpdateAgent> update_agent)
+                                               std::shared_ptr<UpdateAgent> update_agent)
     : AktualizrSecondary(config, std::move(storage)), update_agent_{std::move(update_agent)} {
   registerHandler(AKIpUptaneMes_PR_uploadDataReq, std::bind(&AktualizrSecondaryFile::uploadDataHdlr, this,
                                                             std::placeholders::_1, std::placeholders::_2));
@@ -26,12 +27,28 @@ AktualizrSecondaryFile::AktualizrSecondaryFile(const AktualizrSecondaryConfig& c
       current_target_name = "unknown";
     }
 
-    update_agent_ = std::make_shared<FileUpdateAgent>(config.storage.path / FileUpdateDefaultFile, current_target_name);
+    if (config.pacman.type == PartitionUpdateAgent::PackageManager) {
+      update_agent_ = std::make_shared<PartitionUpdateAgent>(PartitionUpdateAgent::slotsFromConfig(config.pacman),
+                                                             config.storage.path / PartitionUpdateAgent::StateFile,
+                                                             current_target_name);
+    } else {
+      update_agent_ =
+          std::make_shared<FileUpdateAgent>(config.storage.path / FileUpdateDefaultFile, current_target_name);
+    }
   }
 }
 
 void AktualizrSecondaryFile::initialize() { initPendingTargetIfAny(); }
 
+data::InstallationResult AktualizrSecondaryFile::putMetadata(const Metadata& metadata) {
+  auto result = AktualizrSecondary::putMetadata(metadata);
+  if (result.isSuccess()) {
+    // The image follows the metadata, from its start.
+    update_agent_->discardReceivedData();
+  }
+  return result;
+}
+
 data::InstallationResult AktualizrSecondaryFile::receiveData(const uint8_t* data, size_t size) {
   if (!pendingTarget().IsValid()) {
     LOG_ERROR << "Aborting image download; no valid target found.";
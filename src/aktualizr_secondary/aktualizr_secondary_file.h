@@ -5,7 +5,7 @@
 
 #include "aktualizr_secondary.h"
 
-class FileUpdateAgent;
+class UpdateAgent;
 
 class AktualizrSecondaryFile : public AktualizrSecondary {
  public:
@@ -13,9 +13,11 @@ class AktualizrSecondaryFile : public AktualizrSecondary {
 
   AktualizrSecondaryFile(const AktualizrSecondaryConfig& config);
   AktualizrSecondaryFile(const AktualizrSecondaryConfig& config, std::shared_ptr<INvStorage> storage,
-                         std::shared_ptr<FileUpdateAgent> update_agent = nullptr);
+                         std::shared_ptr<UpdateAgent> update_agent = nullptr);
 
   void initialize() override;
+  using AktualizrSecondary::putMetadata;
+  data::InstallationResult putMetadata(const Metadata& metadata) override;
   data::InstallationResult receiveData(const uint8_t* data, size_t size);
 
  protected:
@@ -28,7 +30,7 @@ class AktualizrSecondaryFile : public AktualizrSecondary {
   ReturnCode uploadDataHdlr(Asn1Message& in_msg, Asn1Message& out_msg);
 
  private:
-  std::shared_ptr<FileUpdateAgent> update_agent_;
+  std::shared_ptr<UpdateAgent> update_agent_;
 };
 
 #endif  // AKTUALIZR_SECONDARY_FILE_H
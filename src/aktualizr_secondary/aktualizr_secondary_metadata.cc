@@ -20,6 +20,20 @@ void Metadata::fetchLatestRole(std::string* result, int64_t maxsize, Uptane::Rep
   getRoleMetadata(result, repo, role, Uptane::Version());
 }
 
+Uptane::MetaBundle Metadata::latestBundle() const {
+  Uptane::MetaBundle bundle;
+  for (const auto& role : {Uptane::Role::Root(), Uptane::Role::Targets()}) {
+    getRoleMetadata(&bundle[std::make_pair(Uptane::RepositoryType::Director(), role)],
+                    Uptane::RepositoryType::Director(), role, Uptane::Version());
+  }
+  for (const auto& role :
+       {Uptane::Role::Root(), Uptane::Role::Timestamp(), Uptane::Role::Snapshot(), Uptane::Role::Targets()}) {
+    getRoleMetadata(&bundle[std::make_pair(Uptane::RepositoryType::Image(), role)], Uptane::RepositoryType::Image(),
+                    role, Uptane::Version());
+  }
+  return bundle;
+}
+
 void Metadata::getRoleMetadata(std::string* result, const Uptane::RepositoryType& repo, const Uptane::Role& role,
                                Uptane::Version version) const {
   if (role == Uptane::Role::Root() && version != Uptane::Version()) {
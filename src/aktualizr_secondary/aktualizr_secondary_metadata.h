@@ -14,6 +14,10 @@ class Metadata : public Uptane::IMetadataFetcher {
   void fetchLatestRole(std::string* result, int64_t maxsize, Uptane::RepositoryType repo,
                        const Uptane::Role& role) const override;
 
+  // The latest metadata of every role that is verified by aktualizr-secondary.
+  // Throws if any of them is missing.
+  Uptane::MetaBundle latestBundle() const;
+
  protected:
   virtual void getRoleMetadata(std::string* result, const Uptane::RepositoryType& repo, const Uptane::Role& role,
                                Uptane::Version version) const;
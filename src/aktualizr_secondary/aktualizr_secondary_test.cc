@@ -1,10 +1,19 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include <boost/process.hpp>
 
 #include "aktualizr_secondary_file.h"
+#include "asn1/asn1_message.h"
+#include "crypto/crypto.h"
 #include "crypto/keymanager.h"
+#include "ipuptanesecondary.h"
+#include "libaktualizr/packagemanagerfactory.h"
+#include "primary/secondary_provider_builder.h"
+#include "secondary_tcp_server.h"
+#include "storage/invstorage.h"
 #include "test_utils.h"
 #include "update_agent.h"
 #include "update_agent_file.h"
@@ -47,6 +56,7 @@ class AktualizrSecondaryWrapper {
   }
 
   std::shared_ptr<AktualizrSecondaryFile>& operator->() { return secondary_; }
+  AktualizrSecondaryFile& operator*() { return *secondary_; }
 
   Uptane::Target getPendingVersion() const {
     boost::optional<Uptane::Target> pending_target;
@@ -223,6 +233,12 @@ class SecondaryTest : public ::testing::Test {
     return result;
   }
 
+  Asn1Message::Ptr handleRequest(const Asn1Message::Ptr& req) {
+    Asn1Message::Ptr resp(Asn1Message::Empty());
+    EXPECT_EQ(secondary_->handleMsg(req, resp), MsgHandler::kOk);
+    return resp;
+  }
+
  protected:
   static constexpr const char* const default_target_{"default-target"};
   static constexpr const char* const bigger_target_{"default-target.bigger"};
@@ -325,6 +341,26 @@ TEST_F(SecondaryTest, fullUptaneVerificationPositive) {
   EXPECT_EQ(manifest.filepath(), target.filename());
 }
 
+/* Metadata that has been verified before is accepted again, and changed
+ * metadata is verified anew. */
+TEST_F(SecondaryTest, MetadataSentAgain) {
+  EXPECT_CALL(update_agent_, receiveData)
+      .Times(target_size / send_buffer_size + (target_size % send_buffer_size ? 1 : 0));
+  EXPECT_CALL(update_agent_, install).Times(1);
+
+  ASSERT_TRUE(secondary_->putMetadata(uptane_repo_.getCurrentMetadata()).isSuccess());
+  ASSERT_TRUE(secondary_->putMetadata(uptane_repo_.getCurrentMetadata()).isSuccess());
+
+  uptane_repo_.refreshRoot(Uptane::RepositoryType::Director());
+  ASSERT_TRUE(secondary_->putMetadata(uptane_repo_.getCurrentMetadata()).isSuccess());
+  ASSERT_TRUE(secondary_->putMetadata(uptane_repo_.getCurrentMetadata()).isSuccess());
+
+  ASSERT_EQ(sendImageFile(), data::ResultCode::Numeric::kOk);
+  ASSERT_TRUE(secondary_->install().isSuccess());
+  EXPECT_EQ(Hash::generate(Hash::Type::kSha256, Utils::readFile(secondary_.targetFilepath())),
+            getDefaultTargetHash());
+}
+
 TEST_F(SecondaryTest, TwoImagesAndOneTarget) {
   // two images for the same ECU, just one of them is added as a target and signed
   // default image and corresponding target has been already added, just add another image
@@ -400,6 +436,279 @@ TEST_F(SecondaryTest, InvalidImageData) {
   EXPECT_FALSE(secondary_->install().isSuccess());
 }
 
+/* The Primary retries an interrupted transfer and sends a complete image again
+ * from its start, each time after the metadata. */
+TEST_F(SecondaryTest, SendImageAgainFromPrimary) {
+  SecondaryTcpServer secondary_server(*secondary_, "", 0);
+  std::thread secondary_server_thread(std::bind(&SecondaryTcpServer::run, &secondary_server));
+  secondary_server.wait_until_running();
+
+  TemporaryDirectory primary_dir;
+  Config config;
+  config.pacman.type = PACKAGE_MANAGER_NONE;
+  config.pacman.images_path = primary_dir.Path() / "images";
+  config.storage.path = primary_dir.Path();
+  auto storage = INvStorage::newStorage(config.storage);
+  const Uptane::MetaBundle meta_bundle = uptane_repo_.getCurrentMetadata();
+  const auto director = Uptane::RepositoryType::Director();
+  const auto image_repo = Uptane::RepositoryType::Image();
+  storage->storeRoot(getMetaFromBundle(meta_bundle, director, Uptane::Role::Root()), director, Uptane::Version(1));
+  storage->storeNonRoot(getMetaFromBundle(meta_bundle, director, Uptane::Role::Targets()), director,
+                        Uptane::Role::Targets());
+  storage->storeRoot(getMetaFromBundle(meta_bundle, image_repo, Uptane::Role::Root()), image_repo, Uptane::Version(1));
+  for (const auto& role : {Uptane::Role::Timestamp(), Uptane::Role::Snapshot(), Uptane::Role::Targets()}) {
+    storage->storeNonRoot(getMetaFromBundle(meta_bundle, image_repo, role), image_repo, role);
+  }
+
+  auto package_manager = PackageManagerFactory::makePackageManager(config.pacman, config.bootloader, storage, nullptr);
+  const Uptane::Target target = getDefaultTarget();
+  const std::string image = Utils::readFile(uptane_repo_.getTargetImagePath(default_target_));
+  auto fhandle = package_manager->createTargetFile(target);
+  fhandle.write(image.c_str(), static_cast<std::streamsize>(image.size()));
+  fhandle.close();
+
+  auto ip_secondary = Uptane::IpUptaneSecondary::connectAndCreate("localhost", secondary_server.port());
+  ASSERT_NE(ip_secondary, nullptr);
+  ip_secondary->init(SecondaryProviderBuilder::Build(config, storage, package_manager));
+
+  // The transfer breaks off after the first chunk.
+  EXPECT_CALL(update_agent_, receiveData)
+      .WillOnce(::testing::DoDefault())
+      .WillOnce(::testing::Return(data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed, "")))
+      .WillRepeatedly(::testing::DoDefault());
+  ASSERT_TRUE(ip_secondary->putMetadata(target).isSuccess());
+  EXPECT_FALSE(ip_secondary->sendFirmware(target).isSuccess());
+
+  ASSERT_TRUE(ip_secondary->putMetadata(target).isSuccess());
+  EXPECT_TRUE(ip_secondary->sendFirmware(target).isSuccess());
+  // The complete image can be sent again as well.
+  ASSERT_TRUE(ip_secondary->putMetadata(target).isSuccess());
+  EXPECT_TRUE(ip_secondary->sendFirmware(target).isSuccess());
+  EXPECT_TRUE(ip_secondary->install(target).isSuccess());
+  EXPECT_EQ(Utils::readFile(secondary_.targetFilepath()), image);
+
+  secondary_server.stop();
+  secondary_server_thread.join();
+}
+
+using MetaKey = std::pair<Uptane::RepositoryType, Uptane::Role>;
+
+static void addMetaObject(AKMetaObjectCollection_t& collection, const std::string& role, const std::string& json,
+                          const std::string& sha256, AKCompression_t compression = AKCompression_none) {
+  auto* object = Asn1Allocation<AKMetaObject_t>();
+  SetString(&object->role, role);
+  SetString(&object->sha256, sha256);
+  object->compression = compression;
+  SetString(&object->json, json);
+  ASN_SEQUENCE_ADD(&collection, object);
+}
+
+/* Builds a v3 put metadata request like IpUptaneSecondary does. The metadata
+ * in left_out is sent with its hash only. */
+static Asn1Message::Ptr putMeta3Request(const Uptane::MetaBundle& meta_bundle, const std::set<MetaKey>& left_out = {}) {
+  Asn1Message::Ptr req(Asn1Message::Empty());
+  auto m = req->present(AKIpUptaneMes_PR_putMetaReq3).putMetaReq3();
+  for (const auto& meta : meta_bundle) {
+    const std::string json = left_out.count(meta.first) == 0 ? meta.second : "";
+    std::string compressed = Utils::gzipCompress(json);
+    const bool gzip = !json.empty() && compressed.size() < json.size();
+    addMetaObject(meta.first.first == Uptane::RepositoryType::Director() ? m->directorRepo : m->imageRepo,
+                  meta.first.second.ToString(), gzip ? compressed : json, Crypto::sha256digest(meta.second),
+                  gzip ? AKCompression_gzip : AKCompression_none);
+  }
+  return req;
+}
+
+/* Metadata left out of a v3 request is taken from the metadata the Secondary
+ * has verified, if its hash matches. */
+TEST_F(SecondaryTest, PutMetadata3LeaveOutKnown) {
+  const auto meta_bundle = uptane_repo_.getCurrentMetadata();
+  auto resp = handleRequest(putMeta3Request(meta_bundle));
+  ASSERT_EQ(resp->present(), AKIpUptaneMes_PR_putMetaResp3);
+  EXPECT_EQ(resp->putMetaResp3()->result, AKInstallationResultCode_ok);
+  EXPECT_EQ(resp->putMetaResp3()->missingMeta, 0);
+
+  std::set<MetaKey> left_out;
+  for (const auto& meta : meta_bundle) {
+    left_out.insert(meta.first);
+  }
+  resp = handleRequest(putMeta3Request(meta_bundle, left_out));
+  ASSERT_EQ(resp->present(), AKIpUptaneMes_PR_putMetaResp3);
+  EXPECT_EQ(resp->putMetaResp3()->result, AKInstallationResultCode_ok);
+  EXPECT_EQ(resp->putMetaResp3()->missingMeta, 0);
+
+  EXPECT_EQ(sendImageFile(), data::ResultCode::Numeric::kOk);
+  EXPECT_TRUE(secondary_->install().isSuccess());
+}
+
+/* Left out metadata that the Secondary does not have, or not with that hash,
+ * is reported as missing so that the Primary sends it in full. */
+TEST_F(SecondaryTest, PutMetadata3LeaveOutUnknown) {
+  const MetaKey director_targets{Uptane::RepositoryType::Director(), Uptane::Role::Targets()};
+  auto meta_bundle = uptane_repo_.getCurrentMetadata();
+  auto resp = handleRequest(putMeta3Request(meta_bundle, {director_targets}));
+  ASSERT_EQ(resp->present(), AKIpUptaneMes_PR_putMetaResp3);
+  EXPECT_NE(resp->putMetaResp3()->result, AKInstallationResultCode_ok);
+  EXPECT_EQ(resp->putMetaResp3()->missingMeta, 1);
+
+  resp = handleRequest(putMeta3Request(meta_bundle));
+  EXPECT_EQ(resp->putMetaResp3()->result, AKInstallationResultCode_ok);
+  EXPECT_EQ(resp->putMetaResp3()->missingMeta, 0);
+
+  // The Secondary has different Director Targets metadata than the one left out.
+  uptane_repo_.addImageFile("second-target", secondary_->hwID().ToString(), secondary_->serial().ToString());
+  meta_bundle = uptane_repo_.getCurrentMetadata();
+  resp = handleRequest(putMeta3Request(meta_bundle, {director_targets}));
+  EXPECT_NE(resp->putMetaResp3()->result, AKInstallationResultCode_ok);
+  EXPECT_EQ(resp->putMetaResp3()->missingMeta, 1);
+}
+
+/* Metadata that does not match the hash sent with it is rejected. */
+TEST_F(SecondaryTest, PutMetadata3HashMismatch) {
+  const auto meta_bundle = uptane_repo_.getCurrentMetadata();
+  Asn1Message::Ptr req(Asn1Message::Empty());
+  auto m = req->present(AKIpUptaneMes_PR_putMetaReq3).putMetaReq3();
+  for (const auto& meta : meta_bundle) {
+    const bool director = meta.first.first == Uptane::RepositoryType::Director();
+    const std::string sha256 = Crypto::sha256digest(
+        director && meta.first.second == Uptane::Role::Targets() ? meta.second + " " : meta.second);
+    addMetaObject(director ? m->directorRepo : m->imageRepo, meta.first.second.ToString(), meta.second, sha256);
+  }
+
+  auto resp = handleRequest(req);
+  ASSERT_EQ(resp->present(), AKIpUptaneMes_PR_putMetaResp3);
+  EXPECT_EQ(resp->putMetaResp3()->result, AKInstallationResultCode_validationFailed);
+  EXPECT_EQ(resp->putMetaResp3()->missingMeta, 0);
+  EXPECT_NE(ToString(resp->putMetaResp3()->description).find("does not match its hash"), std::string::npos);
+  EXPECT_FALSE(secondary_->install().isSuccess());
+}
+
+/* Compressed metadata is not decompressed beyond the size limit of its role. */
+TEST_F(SecondaryTest, PutMetadata3CompressedTooBig) {
+  const auto meta_bundle = uptane_repo_.getCurrentMetadata();
+  const std::string big(static_cast<size_t>(Uptane::kMaxTimestampSize) + 1, ' ');
+  Asn1Message::Ptr req(Asn1Message::Empty());
+  auto m = req->present(AKIpUptaneMes_PR_putMetaReq3).putMetaReq3();
+  for (const auto& meta : meta_bundle) {
+    auto& collection = meta.first.first == Uptane::RepositoryType::Director() ? m->directorRepo : m->imageRepo;
+    if (meta.first.second == Uptane::Role::Timestamp()) {
+      addMetaObject(collection, meta.first.second.ToString(), Utils::gzipCompress(big), Crypto::sha256digest(big),
+                    AKCompression_gzip);
+    } else {
+      addMetaObject(collection, meta.first.second.ToString(), meta.second, Crypto::sha256digest(meta.second));
+    }
+  }
+
+  auto resp = handleRequest(req);
+  ASSERT_EQ(resp->present(), AKIpUptaneMes_PR_putMetaResp3);
+  EXPECT_EQ(resp->putMetaResp3()->result, AKInstallationResultCode_validationFailed);
+  EXPECT_EQ(resp->putMetaResp3()->missingMeta, 0);
+  EXPECT_NE(ToString(resp->putMetaResp3()->description).find("maximum size"), std::string::npos);
+}
+
+/* Metadata with a role that does not belong to its repository is ignored. */
+TEST_F(SecondaryTest, PutMetadata3UnexpectedRole) {
+  const auto meta_bundle = uptane_repo_.getCurrentMetadata();
+  auto req = putMeta3Request(meta_bundle);
+  const std::string snapshot =
+      getMetaFromBundle(meta_bundle, Uptane::RepositoryType::Image(), Uptane::Role::Snapshot());
+  addMetaObject(req->putMetaReq3()->directorRepo, Uptane::Role::SNAPSHOT, snapshot, Crypto::sha256digest(snapshot));
+  addMetaObject(req->putMetaReq3()->imageRepo, "unknown", "{}", Crypto::sha256digest("{}"));
+
+  auto resp = handleRequest(req);
+  ASSERT_EQ(resp->present(), AKIpUptaneMes_PR_putMetaResp3);
+  EXPECT_EQ(resp->putMetaResp3()->result, AKInstallationResultCode_ok);
+  EXPECT_EQ(resp->putMetaResp3()->missingMeta, 0);
+}
+
+/* The manifest is sent gzip-compressed if the Primary asks for it. */
+TEST_F(SecondaryTest, GetManifest3) {
+  // The signature differs every time, so only the signed part is compared.
+  const std::string manifest = Utils::jsonToCanonicalStr(secondary_->getManifest()["signed"]);
+  Asn1Message::Ptr req(Asn1Message::Empty());
+  req->present(AKIpUptaneMes_PR_manifestReq3).manifestReq3()->compression = AKCompression_gzip;
+  auto resp = handleRequest(req);
+  ASSERT_EQ(resp->present(), AKIpUptaneMes_PR_manifestResp3);
+  EXPECT_EQ(resp->manifestResp3()->compression, AKCompression_gzip);
+  const std::string decompressed = Utils::gzipDecompress(ToString(resp->manifestResp3()->manifest), 1024 * 1024);
+  EXPECT_EQ(Utils::jsonToCanonicalStr(Utils::parseJSON(decompressed)["signed"]), manifest);
+
+  req->manifestReq3()->compression = AKCompression_none;
+  resp = handleRequest(req);
+  ASSERT_EQ(resp->present(), AKIpUptaneMes_PR_manifestResp3);
+  EXPECT_EQ(resp->manifestResp3()->compression, AKCompression_none);
+  EXPECT_EQ(Utils::jsonToCanonicalStr(Utils::parseJSON(ToString(resp->manifestResp3()->manifest))["signed"]), manifest);
+}
+
+/* The Secondary answers with the protocol version of an older Primary it still
+ * supports and with its own version otherwise. */
+TEST_F(SecondaryTest, VersionNegotiation) {
+  const std::vector<std::pair<long, long>> versions{{1, 3}, {2, 2}, {3, 3}, {4, 3}};
+  for (const auto& version : versions) {
+    Asn1Message::Ptr req(Asn1Message::Empty());
+    req->present(AKIpUptaneMes_PR_versionReq).versionReq()->version = version.first;
+    auto resp = handleRequest(req);
+    ASSERT_EQ(resp->present(), AKIpUptaneMes_PR_versionResp);
+    EXPECT_EQ(resp->versionResp()->version, version.second) << "Primary version " << version.first;
+  }
+}
+
+/* An image received before a restart can be installed by a new update agent,
+ * and whatever has been received is dropped before the image is sent again. */
+TEST(FileUpdateAgent, ReceiveDataAgain) {
+  TemporaryDirectory temp_dir;
+  std::string image;
+  for (int i = 0; image.size() < 200 * 1024; ++i) {
+    image += std::to_string(i);
+  }
+  const auto* image_data = reinterpret_cast<const uint8_t*>(image.data());
+  const Uptane::Target target("image.bin", Uptane::EcuMap{}, {Hash::generate(Hash::Type::kSha256, image)},
+                              image.size());
+  const size_t chunk_size = 1024;
+  auto send = [&](FileUpdateAgent& update_agent, size_t size) {
+    for (size_t sent = 0; sent < size; sent += chunk_size) {
+      ASSERT_TRUE(update_agent.receiveData(target, image_data + sent, std::min(chunk_size, size - sent)).isSuccess());
+    }
+  };
+
+  {
+    FileUpdateAgent update_agent(temp_dir / "firmware.txt", "");
+    send(update_agent, image.size() / 2);
+    update_agent.discardReceivedData();
+    send(update_agent, image.size());
+    // Nothing more is accepted once the image is complete.
+    EXPECT_FALSE(update_agent.receiveData(target, image_data, 1).isSuccess());
+    update_agent.discardReceivedData();
+    send(update_agent, image.size());
+  }
+
+  FileUpdateAgent update_agent(temp_dir / "firmware.txt", "");
+  ASSERT_TRUE(update_agent.install(target).isSuccess());
+  EXPECT_EQ(Utils::readFile(temp_dir / "firmware.txt"), image);
+}
+
+/* An image that does not match its hash is removed, and a complete image is
+ * not opened again when more data arrives. */
+TEST(FileUpdateAgent, InvalidImage) {
+  TemporaryDirectory temp_dir;
+  const std::string image(3000, 'i');
+  const auto* image_data = reinterpret_cast<const uint8_t*>(image.data());
+  const Uptane::Target target("image.bin", Uptane::EcuMap{},
+                              {Hash::generate(Hash::Type::kSha256, std::string(3000, 'x'))}, image.size());
+
+  FileUpdateAgent update_agent(temp_dir / "firmware.txt", "");
+  ASSERT_TRUE(update_agent.receiveData(target, image_data, image.size()).isSuccess());
+  EXPECT_FALSE(update_agent.install(target).isSuccess());
+  EXPECT_FALSE(boost::filesystem::exists(temp_dir / "firmware.txt.newtarget"));
+  EXPECT_FALSE(boost::filesystem::exists(temp_dir / "firmware.txt"));
+
+  // If the file were opened again, it would be recreated and the data accepted.
+  ASSERT_TRUE(update_agent.receiveData(target, image_data, image.size()).isSuccess());
+  boost::filesystem::remove(temp_dir / "firmware.txt.newtarget");
+  EXPECT_FALSE(update_agent.receiveData(target, image_data, 1).isSuccess());
+  EXPECT_FALSE(boost::filesystem::exists(temp_dir / "firmware.txt.newtarget"));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
 
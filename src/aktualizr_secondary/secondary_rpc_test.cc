@@ -6,6 +6,7 @@
 #include "libaktualizr/packagemanagerfactory.h"
 #include "libaktualizr/packagemanagerinterface.h"
 
+#include "crypto/crypto.h"
 #include "ipuptanesecondary.h"
 #include "logging/logging.h"
 #include "msg_handler.h"
@@ -14,15 +15,15 @@
 #include "storage/invstorage.h"
 #include "test_utils.h"
 
-enum class HandlerVersion { kV1, kV2, kV2Failure };
+enum class HandlerVersion { kV1, kV2, kV2Failure, kV3 };
 
 /* This class allows us to divert messages from the regular handlers in
  * AktualizrSecondary to our own test functions. This lets us test only what was
  * received by the Secondary but not how it was processed.
  *
- * It also has handlers for both the old/v1 and new/v2 versions of the RPC
+ * It also has handlers for the old/v1, v2 and new/v3 versions of the RPC
  * protocol, so this is how we prove that the Primary is still
- * backwards-compatible with older/v1 Secondaries. */
+ * backwards-compatible with older Secondaries. */
 class SecondaryMock : public MsgDispatcher {
  public:
   SecondaryMock(const Uptane::EcuSerial& serial, const Uptane::HardwareIdentifier& hdw_id, const PublicKey& pub_key,
@@ -48,6 +49,10 @@ class SecondaryMock : public MsgDispatcher {
   const PublicKey& publicKey() const { return pub_key_; }
   const Uptane::Manifest& manifest() const { return manifest_; }
   const Uptane::MetaBundle& metadata() const { return meta_bundle_; }
+  // Number of metadata objects the Primary left out of the last v3 request.
+  int leftOutMetaCount() const { return left_out_meta_count_; }
+  // Simulates a restart of the Secondary, which loses track of the metadata.
+  void forgetMetadata() { meta_bundle_.clear(); }
   HandlerVersion handlerVersion() const { return handler_version_; }
   void setHandlerVersion(HandlerVersion handler_version_in) { handler_version_ = handler_version_in; }
   void registerHandlers() {
@@ -56,6 +61,9 @@ class SecondaryMock : public MsgDispatcher {
       registerV1Handlers();
     } else if (handler_version_ == HandlerVersion::kV2) {
       registerV2Handlers();
+    } else if (handler_version_ == HandlerVersion::kV3) {
+      registerV2Handlers();
+      registerV3Handlers();
     } else {
       registerV2FailureHandlers();
     }
@@ -106,6 +114,15 @@ class SecondaryMock : public MsgDispatcher {
                     std::bind(&SecondaryMock::install2Hdlr, this, std::placeholders::_1, std::placeholders::_2));
   }
 
+  // Used by protocol v3 in addition to the v2 handlers:
+  void registerV3Handlers() {
+    registerHandler(AKIpUptaneMes_PR_putMetaReq3,
+                    std::bind(&SecondaryMock::putMeta3Hdlr, this, std::placeholders::_1, std::placeholders::_2));
+
+    registerHandler(AKIpUptaneMes_PR_manifestReq3,
+                    std::bind(&SecondaryMock::getManifest3Hdlr, this, std::placeholders::_1, std::placeholders::_2));
+  }
+
   // Procotol v2 handlers that fail in predictable ways.
   void registerV2FailureHandlers() {
     registerHandler(AKIpUptaneMes_PR_putMetaReq2,
@@ -144,6 +161,8 @@ class SecondaryMock : public MsgDispatcher {
 
     if (handler_version_ == HandlerVersion::kV1) {
       version_resp->version = 1;
+    } else if (handler_version_ == HandlerVersion::kV3) {
+      version_resp->version = 3;
     } else {
       version_resp->version = 2;
     }
@@ -237,6 +256,75 @@ class SecondaryMock : public MsgDispatcher {
     return ReturnCode::kOk;
   }
 
+  MsgHandler::ReturnCode getManifest3Hdlr(Asn1Message& in_msg, Asn1Message& out_msg) {
+    EXPECT_EQ(in_msg.manifestReq3()->compression, AKCompression_gzip);
+
+    auto manifest_resp = out_msg.present(AKIpUptaneMes_PR_manifestResp3).manifestResp3();
+    manifest_resp->compression = AKCompression_gzip;
+    SetString(&manifest_resp->manifest, Utils::gzipCompress(Utils::jsonToStr(manifest())));
+
+    return ReturnCode::kOk;
+  }
+
+  // Reads the metadata objects of one repo like AktualizrSecondary::readMetaObjects().
+  bool readMetaObjects(const AKMetaObjectCollection_t& collection, const Uptane::RepositoryType repo,
+                       Uptane::MetaBundle& meta_bundle) {
+    for (int i = 0; i < collection.list.count; i++) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      const AKMetaObject_t& object = *collection.list.array[i];
+      const std::string role_name = ToString(object.role);
+      Uptane::Role role = Uptane::Role::InvalidRole();
+      if (role_name == Uptane::Role::ROOT) {
+        role = Uptane::Role::Root();
+      } else if (role_name == Uptane::Role::TARGETS) {
+        role = Uptane::Role::Targets();
+      } else if (role_name == Uptane::Role::TIMESTAMP) {
+        role = Uptane::Role::Timestamp();
+      } else if (role_name == Uptane::Role::SNAPSHOT) {
+        role = Uptane::Role::Snapshot();
+      }
+      const auto key = std::make_pair(repo, role);
+      const std::string sha256 = ToString(object.sha256);
+
+      std::string json = ToString(object.json);
+      if (json.empty()) {
+        const auto known = meta_bundle_.find(key);
+        if (known == meta_bundle_.end() || Crypto::sha256digest(known->second) != sha256) {
+          return false;
+        }
+        ++left_out_meta_count_;
+        json = known->second;
+      } else if (object.compression == AKCompression_gzip) {
+        json = Utils::gzipDecompress(json, 1024 * 1024);
+      }
+      EXPECT_EQ(Crypto::sha256digest(json), sha256);
+      meta_bundle.emplace(key, std::move(json));
+    }
+    return true;
+  }
+
+  MsgHandler::ReturnCode putMeta3Hdlr(Asn1Message& in_msg, Asn1Message& out_msg) {
+    auto md = in_msg.putMetaReq3();
+    EXPECT_EQ(md->directorRepo.list.count, 2);
+    EXPECT_EQ(md->imageRepo.list.count, 4);
+
+    Uptane::MetaBundle meta_bundle;
+    left_out_meta_count_ = 0;
+    auto m = out_msg.present(AKIpUptaneMes_PR_putMetaResp3).putMetaResp3();
+    if (readMetaObjects(md->directorRepo, Uptane::RepositoryType::Director(), meta_bundle) &&
+        readMetaObjects(md->imageRepo, Uptane::RepositoryType::Image(), meta_bundle)) {
+      data::InstallationResult result = putMetadata2(meta_bundle);
+      m->result = static_cast<AKInstallationResultCode_t>(result.result_code.num_code);
+      SetString(&m->description, result.description);
+      m->missingMeta = 0;
+    } else {
+      m->result = static_cast<AKInstallationResultCode_t>(data::ResultCode::Numeric::kVerificationFailed);
+      m->missingMeta = 1;
+    }
+
+    return ReturnCode::kOk;
+  }
+
   MsgHandler::ReturnCode putMeta2FailureHdlr(Asn1Message& in_msg, Asn1Message& out_msg) {
     (void)in_msg;
 
@@ -372,6 +460,7 @@ class SecondaryMock : public MsgDispatcher {
   const Uptane::Manifest manifest_;
 
   Uptane::MetaBundle meta_bundle_;
+  int left_out_meta_count_{0};
 
   TemporaryDirectory image_dir_;
   boost::filesystem::path image_filepath_;
@@ -628,7 +717,8 @@ INSTANTIATE_TEST_SUITE_P(
                       std::make_pair(1024 * 10 + 1, HandlerVersion::kV2), std::make_pair(1, HandlerVersion::kV1),
                       std::make_pair(1024, HandlerVersion::kV1), std::make_pair(1024 - 1, HandlerVersion::kV1),
                       std::make_pair(1024 + 1, HandlerVersion::kV1), std::make_pair(1024 * 10 + 1, HandlerVersion::kV1),
-                      std::make_pair(1024, HandlerVersion::kV2Failure)));
+                      std::make_pair(1024, HandlerVersion::kV2Failure), std::make_pair(1, HandlerVersion::kV3),
+                      std::make_pair(1024 * 10 + 1, HandlerVersion::kV3)));
 
 class SecondaryRpcUpgrade : public SecondaryRpcCommon {
  protected:
@@ -656,6 +746,51 @@ TEST_F(SecondaryRpcUpgrade, VersionUpgrade) {
   installOstreeRev();
 }
 
+class SecondaryRpcV3 : public SecondaryRpcCommon {
+ protected:
+  SecondaryRpcV3() : SecondaryRpcCommon(1024, HandlerVersion::kV3) {}
+};
+
+/* With protocol v3, metadata that the Secondary already has is left out, and
+ * sent again in full if the Secondary has lost track of it. */
+TEST_F(SecondaryRpcV3, LeaveOutKnownMetadata) {
+  ASSERT_TRUE(ip_secondary_ != nullptr) << "Failed to create IP Secondary";
+  EXPECT_EQ(ip_secondary_->getManifest(), secondary_.manifest());
+
+  // Large enough to be compressed.
+  std::string image_targets = "{\"targets\": [";
+  for (int i = 0; i < 1000; ++i) {
+    image_targets += "\"target" + std::to_string(i) + "\", ";
+  }
+  image_targets += "]}";
+  storage_->storeNonRoot(image_targets, Uptane::RepositoryType::Image(), Uptane::Role::Targets());
+
+  Uptane::Target target = image_file_.createTarget(package_manager_);
+  ASSERT_TRUE(ip_secondary_->putMetadata(target).isSuccess());
+  EXPECT_EQ(secondary_.leftOutMetaCount(), 0);
+  EXPECT_EQ(Uptane::getMetaFromBundle(secondary_.metadata(), Uptane::RepositoryType::Image(), Uptane::Role::Targets()),
+            image_targets);
+
+  // Only the new Timestamp metadata is sent.
+  const std::string image_timestamp = "image-timestamp-2";
+  storage_->storeNonRoot(image_timestamp, Uptane::RepositoryType::Image(), Uptane::Role::Timestamp());
+  ASSERT_TRUE(ip_secondary_->putMetadata(target).isSuccess());
+  EXPECT_EQ(secondary_.leftOutMetaCount(), 5);
+  EXPECT_EQ(
+      Uptane::getMetaFromBundle(secondary_.metadata(), Uptane::RepositoryType::Image(), Uptane::Role::Timestamp()),
+      image_timestamp);
+  EXPECT_EQ(Uptane::getMetaFromBundle(secondary_.metadata(), Uptane::RepositoryType::Image(), Uptane::Role::Targets()),
+            image_targets);
+
+  secondary_.forgetMetadata();
+  ASSERT_TRUE(ip_secondary_->putMetadata(target).isSuccess());
+  EXPECT_EQ(secondary_.leftOutMetaCount(), 0);
+  EXPECT_EQ(Uptane::getMetaFromBundle(secondary_.metadata(), Uptane::RepositoryType::Director(), Uptane::Role::Root()),
+            director_root_);
+  EXPECT_EQ(Uptane::getMetaFromBundle(secondary_.metadata(), Uptane::RepositoryType::Image(), Uptane::Role::Targets()),
+            image_targets);
+}
+
 TEST(SecondaryTcpServer, TestIpSecondaryIfSecondaryIsNotRunning) {
   in_port_t secondary_port = TestUtils::getFreePortAsInt();
   SecondaryInterface::Ptr ip_secondary;
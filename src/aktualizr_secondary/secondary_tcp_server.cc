@@ -1,7 +1,5 @@
 #include "secondary_tcp_server.h"
 
-#include <netinet/tcp.h>
-
 #include "AKInstallationResultCode.h"
 #include "AKIpUptaneMes.h"
 #include "asn1/asn1_message.h"
@@ -93,7 +91,7 @@ void SecondaryTcpServer::stop() {
 in_port_t SecondaryTcpServer::port() const { return listen_socket_.port(); }
 SecondaryTcpServer::ExitReason SecondaryTcpServer::exit_reason() const { return exit_reason_; }
 
-static bool sendResponseMessage(int socket_fd, const Asn1Message::Ptr &resp_msg);
+static bool sendResponseMessage(Asn1SocketWriter &writer, const Asn1Message::Ptr &resp_msg);
 
 bool SecondaryTcpServer::HandleOneConnection(int socket) {
   // Outside the message loop, because one recv() may have parts of 2 messages
@@ -101,6 +99,7 @@ bool SecondaryTcpServer::HandleOneConnection(int socket) {
   // moment. This shouldn't be a problem until we have messages that aren't
   // strictly request/response
   DequeueBuffer buffer;
+  Asn1SocketWriter writer(socket);
   bool keep_running_server = true;
   bool keep_running_current_session = true;
 
@@ -142,14 +141,14 @@ bool SecondaryTcpServer::HandleOneConnection(int socket) {
     switch (handle_status_code) {
       case MsgHandler::ReturnCode::kRebootRequired: {
         exit_reason_ = ExitReason::kRebootNeeded;
-        keep_running_current_session = sendResponseMessage(socket, response_msg);
+        keep_running_current_session = sendResponseMessage(writer, response_msg);
         if (reboot_after_install_) {
           keep_running_server = keep_running_current_session = false;
         }
         break;
       }
       case MsgHandler::ReturnCode::kOk: {
-        keep_running_current_session = sendResponseMessage(socket, response_msg);
+        keep_running_current_session = sendResponseMessage(writer, response_msg);
         break;
       }
       case MsgHandler::ReturnCode::kUnkownMsg:
@@ -173,19 +172,15 @@ void SecondaryTcpServer::wait_until_running(int timeout) {
   running_condition_.wait_for(lock, std::chrono::seconds(timeout), [&] { return is_running_; });
 }
 
-bool sendResponseMessage(int socket_fd, const Asn1Message::Ptr &resp_msg) {
+bool sendResponseMessage(Asn1SocketWriter &writer, const Asn1Message::Ptr &resp_msg) {
   LOG_DEBUG << "Encoding and sending response message";
 
-  int optval = 0;
-  setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(int));
-  asn_enc_rval_t encode_result = der_encode(&asn_DEF_AKIpUptaneMes, &resp_msg->msg_, Asn1SocketWriteCallback,
-                                            reinterpret_cast<void *>(&socket_fd));
+  asn_enc_rval_t encode_result =
+      der_encode(&asn_DEF_AKIpUptaneMes, &resp_msg->msg_, Asn1SocketWriter::Callback, &writer);
   if (encode_result.encoded == -1) {
     LOG_ERROR << "Failed to encode a response message";
     return false;  // write error
   }
-  optval = 1;
-  setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(int));
 
-  return true;
+  return writer.flush();
 }
@@ -13,6 +13,19 @@ class UpdateAgent {
   virtual bool getInstalledImageInfo(Uptane::InstalledImageInfo& installed_image_info) const = 0;
   virtual data::InstallationResult install(const Uptane::Target& target) = 0;
 
+  // For agents that get the image pushed by the Primary chunk by chunk.
+  virtual data::InstallationResult receiveData(const Uptane::Target& target, const uint8_t* data, size_t size) {
+    (void)target;
+    (void)data;
+    (void)size;
+    return data::InstallationResult(data::ResultCode::Numeric::kInternalError,
+                                    "Receiving image data is not supported by this update agent");
+  }
+
+  // Drops whatever has been received of an image so far. The Primary sends
+  // every image from its start, also when it retries a failed transfer.
+  virtual void discardReceivedData() {}
+
   virtual void completeInstall() = 0;
   virtual data::InstallationResult applyPendingInstall(const Uptane::Target& target) = 0;
 
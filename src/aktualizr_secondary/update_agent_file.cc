@@ -1,9 +1,21 @@
 #include "update_agent_file.h"
-#include <fstream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
 #include "crypto/crypto.h"
 #include "logging/logging.h"
 #include "uptane/manifest.h"
 
+FileUpdateAgent::~FileUpdateAgent() {
+  if (new_target_fd_ >= 0) {
+    closeNewTarget();
+  }
+}
+
 // TODO(OTA-4939): Unify this with the check in
 // SotaUptaneClient::getNewTargets() and make it more generic.
 bool FileUpdateAgent::isTargetSupported(const Uptane::Target& target) const { return target.type() != "OSTREE"; }
@@ -33,24 +45,41 @@ data::InstallationResult FileUpdateAgent::install(const Uptane::Target& target)
                                     "The target image has not been received");
   }
 
+  // After a restart, the image received so far has to be hashed again.
+  if (new_target_fd_ < 0 && !new_target_hasher_) {
+    auto open_result = openNewTarget(target);
+    if (!open_result.isSuccess()) {
+      return open_result;
+    }
+  }
+  if (new_target_fd_ >= 0) {
+    auto close_result = closeNewTarget();
+    if (!close_result.isSuccess()) {
+      return close_result;
+    }
+  }
+
   auto received_target_image_size = boost::filesystem::file_size(new_target_filepath_);
   if (received_target_image_size != target.length()) {
     LOG_ERROR << "Received image size does not match the size specified in Target metadata: "
               << received_target_image_size << " != " << target.length();
     boost::filesystem::remove(new_target_filepath_);
+    new_target_hasher_.reset();
     return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
                                     "Received image size does not match the size specified in Target metadata: " +
                                         std::to_string(received_target_image_size) +
                                         " != " + std::to_string(target.length()));
   }
 
-  if (!target.MatchHash(new_target_hasher_->getHash())) {
-    LOG_ERROR << "The received image's hash does not match the hash specified in Target metadata: "
-              << new_target_hasher_->getHash() << " != " << getTargetHash(target).HashString();
+  const Hash received_hash = new_target_hasher_->getHash();
+  if (!target.MatchHash(received_hash)) {
+    LOG_ERROR << "The received image's hash does not match the hash specified in Target metadata: " << received_hash
+              << " != " << getTargetHash(target).HashString();
+    boost::filesystem::remove(new_target_filepath_);
+    new_target_hasher_.reset();
     return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
                                     "The received image's hash does not match the hash specified in Target metadata: " +
-                                        new_target_hasher_->getHash().HashString() +
-                                        " != " + getTargetHash(target).HashString());
+                                        received_hash.HashString() + " != " + getTargetHash(target).HashString());
   }
 
   boost::filesystem::rename(new_target_filepath_, target_filepath_);
@@ -79,65 +108,148 @@ data::InstallationResult FileUpdateAgent::applyPendingInstall(const Uptane::Targ
 }
 
 data::InstallationResult FileUpdateAgent::receiveData(const Uptane::Target& target, const uint8_t* data, size_t size) {
-  std::ofstream target_file(new_target_filepath_.c_str(),
-                            std::ofstream::out | std::ofstream::binary | std::ofstream::app);
-
-  if (!target_file.good()) {
-    LOG_ERROR << "Failed to open a new target image file";
-    return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
-                                    "Failed to open a new target image file");
+  // A complete image is not opened and hashed again just to reject more data.
+  const bool complete = new_target_hasher_ && new_target_size_ >= target.length();
+  if (new_target_fd_ < 0 && !complete) {
+    auto open_result = openNewTarget(target);
+    if (!open_result.isSuccess()) {
+      return open_result;
+    }
   }
 
-  auto current_new_image_size = target_file.tellp();
-  if (-1 == current_new_image_size) {
-    LOG_ERROR << "Failed to obtain a size of the new target image that is being uploaded";
-    target_file.close();
+  if (new_target_size_ >= target.length()) {
+    LOG_ERROR << "The size of the received image data exceeds the expected Target image size: " << new_target_size_
+              << " != " << target.length();
     return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
-                                    "Failed to obtain a size of the new target image that is being uploaded");
+                                    "The size of the received image data exceeds the expected Target image size: " +
+                                        std::to_string(new_target_size_) + " != " + std::to_string(target.length()));
   }
 
-  if (static_cast<uint64_t>(current_new_image_size) >= target.length()) {
-    LOG_ERROR << "The size of the received image data exceeds the expected Target image size: "
-              << current_new_image_size << " != " << target.length();
-    target_file.close();
-    return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
-                                    "The size of the received image data exceeds the expected Target image size: " +
-                                        std::to_string(current_new_image_size) +
-                                        " != " + std::to_string(target.length()));
+  write_buffer_.insert(write_buffer_.end(), data, data + size);
+  new_target_hasher_->update(data, size);
+  new_target_size_ += size;
+
+  LOG_DEBUG << "Received and stored data of a new target image."
+               " Received in this request (bytes): "
+            << size << "; total received so far: " << new_target_size_ << "; expected total: " << target.length();
+
+  if (new_target_size_ >= target.length()) {
+    auto close_result = closeNewTarget();
+    if (!close_result.isSuccess()) {
+      return close_result;
+    }
+    if (new_target_size_ == target.length()) {
+      LOG_INFO << "Successfully received and stored new target image of " << new_target_size_ << " bytes.";
+    }
+  } else if (write_buffer_.size() >= write_buffer_size) {
+    auto flush_result = flushNewTarget();
+    if (!flush_result.isSuccess()) {
+      return flush_result;
+    }
   }
 
-  if (current_new_image_size == 0) {
-    new_target_hasher_ = MultiPartHasher::create(getTargetHash(target).type());
+  return data::InstallationResult(data::ResultCode::Numeric::kOk, "");
+}
+
+void FileUpdateAgent::discardReceivedData() {
+  if (new_target_fd_ >= 0) {
+    close(new_target_fd_);
+    new_target_fd_ = -1;
   }
+  boost::system::error_code ec;
+  boost::filesystem::remove(new_target_filepath_, ec);
+  if (ec) {
+    LOG_WARNING << "Failed to remove the partially received target image: " << ec.message();
+  }
+  new_target_hasher_.reset();
+  new_target_size_ = 0;
+  write_buffer_.clear();
+}
 
-  target_file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
-  auto written_data_size = target_file.tellp() - current_new_image_size;
+Hash FileUpdateAgent::getTargetHash(const Uptane::Target& target) {
+  // TODO(OTA-4831): check target.hashes() size.
+  return target.hashes()[0];
+}
 
-  if (written_data_size < 0 || static_cast<size_t>(written_data_size) != size) {
-    LOG_ERROR << "The size of data written is not equal to the received data size: " << written_data_size
-              << " != " << size;
-    target_file.close();
+// Opens the new target image for appending and hashes what it already
+// contains, so that an image received before a restart can still be installed.
+data::InstallationResult FileUpdateAgent::openNewTarget(const Uptane::Target& target) {
+  new_target_fd_ = open(new_target_filepath_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC,
+                        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (new_target_fd_ < 0) {
+    LOG_ERROR << "Failed to open a new target image file: " << std::strerror(errno);
     return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
-                                    "The size of data written is not equal to the received data size: " +
-                                        std::to_string(written_data_size) + " != " + std::to_string(size));
+                                    "Failed to open a new target image file");
   }
 
-  target_file.close();
-
-  auto total_size = current_new_image_size + written_data_size;
-  LOG_DEBUG << "Received and stored data of a new target image."
-               " Received in this request (bytes): "
-            << size << "; total received so far: " << total_size << "; expected total: " << target.length();
-  if (static_cast<uint64_t>(total_size) == target.length()) {
-    LOG_INFO << "Successfully received and stored new target image of " << total_size << " bytes.";
+  new_target_hasher_ = MultiPartHasher::create(getTargetHash(target).type());
+  new_target_size_ = 0;
+  write_buffer_.resize(write_buffer_size);
+  ssize_t read_size;
+  while ((read_size = pread(new_target_fd_, write_buffer_.data(), write_buffer_.size(),
+                            static_cast<off_t>(new_target_size_))) != 0) {
+    if (read_size < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_ERROR << "Failed to obtain a size of the new target image that is being uploaded: " << std::strerror(errno);
+      close(new_target_fd_);
+      new_target_fd_ = -1;
+      write_buffer_.clear();
+      return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                      "Failed to obtain a size of the new target image that is being uploaded");
+    }
+    new_target_hasher_->update(write_buffer_.data(), static_cast<uint64_t>(read_size));
+    new_target_size_ += static_cast<uint64_t>(read_size);
   }
+  write_buffer_.clear();
+  write_buffer_.reserve(write_buffer_size);
 
-  new_target_hasher_->update(data, size);
+  if (new_target_size_ > 0) {
+    LOG_INFO << "Found " << new_target_size_ << " bytes of a new target image received earlier.";
+  }
+  return data::InstallationResult(data::ResultCode::Numeric::kOk, "");
+}
 
+data::InstallationResult FileUpdateAgent::flushNewTarget() {
+  size_t written = 0;
+  while (written < write_buffer_.size()) {
+    auto res = write(new_target_fd_, write_buffer_.data() + written, write_buffer_.size() - written);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      const std::string err = std::strerror(errno);
+      LOG_ERROR << "Failed to write the new target image: " << err;
+      // The Primary gives up on the transfer and sends the image again from
+      // its start, after new metadata.
+      close(new_target_fd_);
+      new_target_fd_ = -1;
+      write_buffer_.clear();
+      return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                      "Failed to write the new target image: " + err);
+    }
+    written += static_cast<size_t>(res);
+  }
+  write_buffer_.clear();
   return data::InstallationResult(data::ResultCode::Numeric::kOk, "");
 }
 
-Hash FileUpdateAgent::getTargetHash(const Uptane::Target& target) {
-  // TODO(OTA-4831): check target.hashes() size.
-  return target.hashes()[0];
+// Writes out the buffered data and makes sure the image is on disk before it
+// gets installed.
+data::InstallationResult FileUpdateAgent::closeNewTarget() {
+  auto result = flushNewTarget();
+  if (!result.isSuccess()) {
+    return result;
+  }
+
+  if (fsync(new_target_fd_) != 0) {
+    const std::string err = std::strerror(errno);
+    LOG_ERROR << "Failed to sync the new target image: " << err;
+    result = data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                      "Failed to sync the new target image: " + err);
+  }
+  close(new_target_fd_);
+  new_target_fd_ = -1;
+  return result;
 }
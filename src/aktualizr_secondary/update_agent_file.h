@@ -1,6 +1,8 @@
 #ifndef AKTUALIZR_SECONDARY_UPDATE_AGENT_FILE_H
 #define AKTUALIZR_SECONDARY_UPDATE_AGENT_FILE_H
 
+#include <vector>
+
 #include "update_agent.h"
 
 class FileUpdateAgent : public UpdateAgent {
@@ -9,13 +11,15 @@ class FileUpdateAgent : public UpdateAgent {
       : target_filepath_{std::move(target_filepath)},
         new_target_filepath_{target_filepath_.string() + ".newtarget"},
         current_target_name_{std::move(target_name)} {}
+  ~FileUpdateAgent() override;
 
  public:
   bool isTargetSupported(const Uptane::Target& target) const override;
   bool getInstalledImageInfo(Uptane::InstalledImageInfo& installed_image_info) const override;
 
-  virtual data::InstallationResult receiveData(const Uptane::Target& target, const uint8_t* data, size_t size);
+  data::InstallationResult receiveData(const Uptane::Target& target, const uint8_t* data, size_t size) override;
   data::InstallationResult install(const Uptane::Target& target) override;
+  void discardReceivedData() override;
 
   void completeInstall() override;
   data::InstallationResult applyPendingInstall(const Uptane::Target& target) override;
@@ -23,11 +27,23 @@ class FileUpdateAgent : public UpdateAgent {
  private:
   static Hash getTargetHash(const Uptane::Target& target);
 
+  data::InstallationResult openNewTarget(const Uptane::Target& target);
+  data::InstallationResult flushNewTarget();
+  data::InstallationResult closeNewTarget();
+
  private:
+  // Received data is written out in blocks of this size, not message by message.
+  static const size_t write_buffer_size{64 * 1024};
+
   const boost::filesystem::path target_filepath_;
   const boost::filesystem::path new_target_filepath_;
   std::string current_target_name_;
   std::shared_ptr<MultiPartHasher> new_target_hasher_;
+  // The new target image stays open from the first received chunk until it is
+  // complete or installed.
+  int new_target_fd_{-1};
+  uint64_t new_target_size_{0};
+  std::vector<uint8_t> write_buffer_;
 };
 
 #endif  // AKTUALIZR_SECONDARY_UPDATE_AGENT_FILE_H
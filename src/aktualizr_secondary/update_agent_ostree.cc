@@ -56,7 +56,8 @@ data::InstallationResult OstreeUpdateAgent::downloadTargetRev(const Uptane::Targ
                                     std::string("Error loading Treehub credentials: ") + exc.what());
   }
 
-  auto result = OstreeManager::pull(sysrootPath_, treehub_server, *keyMngr_, target);
+  auto result = OstreeManager::pull(sysrootPath_, treehub_server, *keyMngr_, target, nullptr, nullptr,
+                                    ostreePackMan_->getDeltaBase());
 
   switch (result.result_code.num_code) {
     case data::ResultCode::Numeric::kOk: {
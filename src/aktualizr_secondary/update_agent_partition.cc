@@ -0,0 +1,333 @@
+#include "update_agent_partition.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include "crypto/crypto.h"
+#include "logging/logging.h"
+#include "utilities/utils.h"
+
+// Replaces the file so that a power loss leaves either the old or the new
+// content: the new content is synced before it is renamed over the old file,
+// and the directory is synced after the rename.
+static void writeFileSynced(const boost::filesystem::path& path, const std::string& content) {
+  const boost::filesystem::path tmp_path = path.string() + ".new";
+  const int fd =
+      open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open " + tmp_path.string() + ": " + std::strerror(errno));
+  }
+  size_t written = 0;
+  while (written < content.size()) {
+    auto res = write(fd, content.data() + written, content.size() - written);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      const std::string err = std::strerror(errno);
+      close(fd);
+      throw std::runtime_error("Failed to write " + tmp_path.string() + ": " + err);
+    }
+    written += static_cast<size_t>(res);
+  }
+  if (fsync(fd) != 0) {
+    const std::string err = std::strerror(errno);
+    close(fd);
+    throw std::runtime_error("Failed to sync " + tmp_path.string() + ": " + err);
+  }
+  close(fd);
+
+  if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Failed to rename " + tmp_path.string() + ": " + std::strerror(errno));
+  }
+
+  const boost::filesystem::path dir = path.has_parent_path() ? path.parent_path() : boost::filesystem::path(".");
+  const int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd < 0) {
+    throw std::runtime_error("Failed to open " + dir.string() + ": " + std::strerror(errno));
+  }
+  if (fsync(dir_fd) != 0) {
+    const std::string err = std::strerror(errno);
+    close(dir_fd);
+    throw std::runtime_error("Failed to sync " + dir.string() + ": " + err);
+  }
+  close(dir_fd);
+}
+
+const std::string PartitionUpdateAgent::PackageManager{"partition"};
+const std::string PartitionUpdateAgent::StateFile{"partition_slots.json"};
+
+PartitionUpdateAgent::Slots PartitionUpdateAgent::slotsFromConfig(const PackageConfig& config) {
+  const auto slot_a = config.extra.find("slot_a");
+  const auto slot_b = config.extra.find("slot_b");
+  if (slot_a == config.extra.end() || slot_b == config.extra.end()) {
+    throw std::runtime_error("The partition update agent requires both slot_a and slot_b to be set in [pacman]");
+  }
+  return Slots{boost::filesystem::path(slot_a->second), boost::filesystem::path(slot_b->second)};
+}
+
+PartitionUpdateAgent::PartitionUpdateAgent(Slots slots, boost::filesystem::path state_filepath,
+                                           std::string target_name)
+    : slots_{std::move(slots)},
+      state_filepath_{std::move(state_filepath)},
+      current_target_name_{std::move(target_name)} {
+  if (!boost::filesystem::exists(state_filepath_)) {
+    return;
+  }
+
+  Json::Value state;
+  try {
+    state = Utils::parseJSONFile(state_filepath_);
+  } catch (const std::exception& e) {
+    LOG_ERROR << "Failed to read the partition slot state: " << e.what();
+  }
+  if (!state.isObject()) {
+    LOG_ERROR << "Invalid partition slot state in " << state_filepath_ << "; assuming the first slot is active";
+    return;
+  }
+  active_slot_ = state["active_slot"].asUInt() == 1 ? 1 : 0;
+  installed_length_ = state["length"].asUInt64();
+  installed_hash_ = state["sha256"].asString();
+}
+
+PartitionUpdateAgent::~PartitionUpdateAgent() { resetReceivedImage(); }
+
+// TODO(OTA-4939): Unify this with the check in
+// SotaUptaneClient::getNewTargets() and make it more generic.
+bool PartitionUpdateAgent::isTargetSupported(const Uptane::Target& target) const {
+  // The SHA256 hash of the image is computed while it is received, for both
+  // verification and the manifest.
+  return target.type() != "OSTREE" && !target.sha256Hash().empty();
+}
+
+bool PartitionUpdateAgent::getInstalledImageInfo(Uptane::InstalledImageInfo& installed_image_info) const {
+  if (!installed_hash_.empty()) {
+    installed_image_info.name = current_target_name_;
+    installed_image_info.len = installed_length_;
+    installed_image_info.hash = installed_hash_;
+  } else {
+    // mimic the Primary's fake package manager behavior
+    auto unknown_target = Uptane::Target::Unknown();
+    installed_image_info.name = unknown_target.filename();
+    installed_image_info.len = unknown_target.length();
+    installed_image_info.hash = unknown_target.sha256Hash();
+  }
+
+  return true;
+}
+
+data::InstallationResult PartitionUpdateAgent::receiveData(const Uptane::Target& target, const uint8_t* data,
+                                                           size_t size) {
+  if (new_target_hash_ != target.sha256Hash()) {
+    resetReceivedImage();
+    auto open_result = openSlot(target);
+    if (!open_result.isSuccess()) {
+      return open_result;
+    }
+  }
+
+  if (new_target_size_ + size > target.length()) {
+    LOG_ERROR << "The size of the received image data exceeds the expected Target image size: "
+              << new_target_size_ + size << " != " << target.length();
+    return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                    "The size of the received image data exceeds the expected Target image size: " +
+                                        std::to_string(new_target_size_ + size) +
+                                        " != " + std::to_string(target.length()));
+  }
+
+  write_buffer_.insert(write_buffer_.end(), data, data + size);
+  new_target_hasher_->update(data, size);
+  new_target_size_ += size;
+
+  LOG_DEBUG << "Received and stored data of a new target image."
+               " Received in this request (bytes): "
+            << size << "; total received so far: " << new_target_size_ << "; expected total: " << target.length();
+
+  if (new_target_size_ == target.length()) {
+    auto close_result = closeSlot();
+    if (!close_result.isSuccess()) {
+      return close_result;
+    }
+    LOG_INFO << "Successfully received and stored new target image of " << new_target_size_ << " bytes.";
+  } else if (write_buffer_.size() >= write_buffer_size) {
+    auto write_result = writeSlot(write_buffer_.size() - write_buffer_.size() % write_buffer_size);
+    if (!write_result.isSuccess()) {
+      return write_result;
+    }
+  }
+
+  return data::InstallationResult(data::ResultCode::Numeric::kOk, "");
+}
+
+data::InstallationResult PartitionUpdateAgent::install(const Uptane::Target& target) {
+  if (new_target_hash_.empty() || new_target_hash_ != target.sha256Hash()) {
+    LOG_ERROR << "The target image has not been received";
+    return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                    "The target image has not been received");
+  }
+
+  if (new_target_fd_ >= 0) {
+    auto close_result = closeSlot();
+    if (!close_result.isSuccess()) {
+      resetReceivedImage();
+      return close_result;
+    }
+  }
+
+  if (new_target_size_ != target.length()) {
+    LOG_ERROR << "Received image size does not match the size specified in Target metadata: " << new_target_size_
+              << " != " << target.length();
+    const auto received_size = new_target_size_;
+    resetReceivedImage();
+    return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                    "Received image size does not match the size specified in Target metadata: " +
+                                        std::to_string(received_size) + " != " + std::to_string(target.length()));
+  }
+
+  const Hash received_hash = new_target_hasher_->getHash();
+  resetReceivedImage();
+  if (!target.MatchHash(received_hash)) {
+    LOG_ERROR << "The received image's hash does not match the hash specified in Target metadata: " << received_hash
+              << " != " << target.sha256Hash();
+    return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                    "The received image's hash does not match the hash specified in Target metadata: " +
+                                        received_hash.HashString() + " != " + target.sha256Hash());
+  }
+
+  // The image is complete and synced to the inactive slot, so replacing the
+  // state file is all it takes to switch over to it.
+  const size_t new_slot = 1 - active_slot_;
+  const std::string new_hash = boost::algorithm::to_lower_copy(target.sha256Hash());
+  Json::Value state;
+  state["active_slot"] = static_cast<Json::UInt>(new_slot);
+  state["length"] = static_cast<Json::UInt64>(target.length());
+  state["sha256"] = new_hash;
+  try {
+    writeFileSynced(state_filepath_, Utils::jsonToStr(state));
+  } catch (const std::exception& e) {
+    LOG_ERROR << "Failed to switch to the new slot: " << e.what();
+    return data::InstallationResult(data::ResultCode::Numeric::kInstallFailed,
+                                    std::string("Failed to switch to the new slot: ") + e.what());
+  }
+
+  active_slot_ = new_slot;
+  installed_length_ = target.length();
+  installed_hash_ = new_hash;
+  current_target_name_ = target.filename();
+  LOG_INFO << "Switched to slot " << slots_[active_slot_];
+  return data::InstallationResult(data::ResultCode::Numeric::kOk, "");
+}
+
+void PartitionUpdateAgent::completeInstall() {}
+
+data::InstallationResult PartitionUpdateAgent::applyPendingInstall(const Uptane::Target& target) {
+  (void)target;
+  return data::InstallationResult(data::ResultCode::Numeric::kInternalError,
+                                  "Applying pending updates is not supported by the partition update agent");
+}
+
+data::InstallationResult PartitionUpdateAgent::openSlot(const Uptane::Target& target) {
+  const boost::filesystem::path& slot = slots_[1 - active_slot_];
+  new_target_fd_ = open(slot.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (new_target_fd_ < 0) {
+    const std::string err = std::strerror(errno);
+    LOG_ERROR << "Failed to open the inactive slot " << slot << ": " << err;
+    return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                    "Failed to open the inactive slot " + slot.string() + ": " + err);
+  }
+
+  struct stat st {};
+  if (fstat(new_target_fd_, &st) != 0) {
+    const std::string err = std::strerror(errno);
+    LOG_ERROR << "Failed to get the type of the inactive slot " << slot << ": " << err;
+    resetReceivedImage();
+    return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                    "Failed to get the type of the inactive slot " + slot.string() + ": " + err);
+  }
+  new_target_is_file_ = S_ISREG(st.st_mode);
+  if (!new_target_is_file_) {
+    const off_t capacity = lseek(new_target_fd_, 0, SEEK_END);
+    if (capacity < 0 || static_cast<uint64_t>(capacity) < target.length()) {
+      LOG_ERROR << "The target image does not fit into the inactive slot " << slot << ": " << target.length() << " > "
+                << capacity;
+      resetReceivedImage();
+      return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                      "The target image does not fit into the inactive slot " + slot.string() + ": " +
+                                          std::to_string(target.length()) + " > " + std::to_string(capacity));
+    }
+  }
+
+  LOG_INFO << "Writing the new target image to " << slot;
+  new_target_hash_ = target.sha256Hash();
+  new_target_hasher_ = MultiPartHasher::create(Hash::Type::kSha256);
+  write_buffer_.reserve(write_buffer_size);
+  return data::InstallationResult(data::ResultCode::Numeric::kOk, "");
+}
+
+// Writes out the first size bytes of the buffer.
+data::InstallationResult PartitionUpdateAgent::writeSlot(const size_t size) {
+  size_t written = 0;
+  while (written < size) {
+    auto res = pwrite(new_target_fd_, write_buffer_.data() + written, size - written,
+                      static_cast<off_t>(new_target_written_ + written));
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      const std::string err = std::strerror(errno);
+      LOG_ERROR << "Failed to write the new target image: " << err;
+      resetReceivedImage();
+      return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                      "Failed to write the new target image: " + err);
+    }
+    written += static_cast<size_t>(res);
+  }
+  write_buffer_.erase(write_buffer_.begin(), write_buffer_.begin() + static_cast<std::ptrdiff_t>(size));
+  new_target_written_ += size;
+  return data::InstallationResult(data::ResultCode::Numeric::kOk, "");
+}
+
+// Writes out the rest of the image and makes sure it is on disk before the
+// slots get switched.
+data::InstallationResult PartitionUpdateAgent::closeSlot() {
+  auto result = writeSlot(write_buffer_.size());
+  if (!result.isSuccess()) {
+    return result;
+  }
+
+  // Cut off what is left of a longer image in a file-backed slot.
+  if (new_target_is_file_ && ftruncate(new_target_fd_, static_cast<off_t>(new_target_written_)) != 0) {
+    const std::string err = std::strerror(errno);
+    LOG_ERROR << "Failed to truncate the new target image: " << err;
+    resetReceivedImage();
+    return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                    "Failed to truncate the new target image: " + err);
+  }
+  if (fsync(new_target_fd_) != 0) {
+    const std::string err = std::strerror(errno);
+    LOG_ERROR << "Failed to sync the new target image: " << err;
+    resetReceivedImage();
+    return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                    "Failed to sync the new target image: " + err);
+  }
+  close(new_target_fd_);
+  new_target_fd_ = -1;
+  return result;
+}
+
+void PartitionUpdateAgent::resetReceivedImage() {
+  if (new_target_fd_ >= 0) {
+    close(new_target_fd_);
+    new_target_fd_ = -1;
+  }
+  new_target_hash_.clear();
+  new_target_size_ = 0;
+  new_target_written_ = 0;
+  new_target_hasher_.reset();
+  write_buffer_.clear();
+}
@@ -0,0 +1,75 @@
+#ifndef AKTUALIZR_SECONDARY_UPDATE_AGENT_PARTITION_H
+#define AKTUALIZR_SECONDARY_UPDATE_AGENT_PARTITION_H
+
+#include <array>
+#include <vector>
+
+#include "libaktualizr/config.h"
+#include "update_agent.h"
+
+/**
+ * Update agent for devices with two slots for the firmware image, such as A/B
+ * partitions. The received image is written straight into the inactive slot
+ * and hashed on the fly; installing it only switches the active slot. Unlike
+ * with FileUpdateAgent, no copy of the image is kept on the filesystem.
+ *
+ * A slot is either a block device or a regular file holding the image. The
+ * active slot and the length and hash of the image in it are kept in a state
+ * file that is replaced atomically and synced on install.
+ */
+class PartitionUpdateAgent : public UpdateAgent {
+ public:
+  using Slots = std::array<boost::filesystem::path, 2>;
+
+  // Value of [pacman] type that selects this agent.
+  static const std::string PackageManager;
+  static const std::string StateFile;
+
+  // Reads the slots from the slot_a and slot_b options of the [pacman] section.
+  static Slots slotsFromConfig(const PackageConfig& config);
+
+  PartitionUpdateAgent(Slots slots, boost::filesystem::path state_filepath, std::string target_name);
+  ~PartitionUpdateAgent() override;
+
+ public:
+  bool isTargetSupported(const Uptane::Target& target) const override;
+  bool getInstalledImageInfo(Uptane::InstalledImageInfo& installed_image_info) const override;
+
+  data::InstallationResult receiveData(const Uptane::Target& target, const uint8_t* data, size_t size) override;
+  data::InstallationResult install(const Uptane::Target& target) override;
+  void discardReceivedData() override { resetReceivedImage(); }
+
+  void completeInstall() override;
+  data::InstallationResult applyPendingInstall(const Uptane::Target& target) override;
+
+  const boost::filesystem::path& activeSlot() const { return slots_[active_slot_]; }
+
+ private:
+  data::InstallationResult openSlot(const Uptane::Target& target);
+  data::InstallationResult writeSlot(size_t size);
+  data::InstallationResult closeSlot();
+  void resetReceivedImage();
+
+ private:
+  // Data is written to the slot in blocks of this size, at offsets that are a
+  // multiple of it.
+  static const size_t write_buffer_size{1024 * 1024};
+
+  const Slots slots_;
+  const boost::filesystem::path state_filepath_;
+  std::string current_target_name_;
+  size_t active_slot_{0};
+  uint64_t installed_length_{0};
+  std::string installed_hash_;
+
+  // The image being received into the inactive slot, identified by its hash.
+  std::string new_target_hash_;
+  int new_target_fd_{-1};
+  bool new_target_is_file_{false};
+  uint64_t new_target_size_{0};
+  uint64_t new_target_written_{0};
+  std::shared_ptr<MultiPartHasher> new_target_hasher_;
+  std::vector<uint8_t> write_buffer_;
+};
+
+#endif  // AKTUALIZR_SECONDARY_UPDATE_AGENT_PARTITION_H
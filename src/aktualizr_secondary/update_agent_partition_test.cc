@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include "logging/logging.h"
+#include "update_agent_partition.h"
+#include "utilities/utils.h"
+
+class PartitionUpdateAgentTest : public ::testing::Test {
+ protected:
+  PartitionUpdateAgentTest() {
+    // The slots are regular files, like the image files behind loop devices.
+    Utils::writeFile(slots_[0], std::string("original image"));
+    Utils::writeFile(slots_[1], std::string(3 * 1024 * 1024, 'o'));
+  }
+
+  std::unique_ptr<PartitionUpdateAgent> makeAgent() const {
+    return std_::make_unique<PartitionUpdateAgent>(slots_, temp_dir_ / PartitionUpdateAgent::StateFile, "original");
+  }
+
+  static std::string makeImage(const size_t size, const std::string& seed) {
+    std::string image;
+    for (int i = 0; image.size() < size; ++i) {
+      image += seed + std::to_string(i);
+    }
+    image.resize(size);
+    return image;
+  }
+
+  static Uptane::Target makeTarget(const std::string& name, const std::string& image) {
+    return Uptane::Target(name, Uptane::EcuMap{}, {Hash::generate(Hash::Type::kSha256, image)}, image.size());
+  }
+
+  static data::InstallationResult sendImage(PartitionUpdateAgent& update_agent, const Uptane::Target& target,
+                                            const std::string& image) {
+    const auto* data = reinterpret_cast<const uint8_t*>(image.data());
+    const size_t chunk_size = 1024;
+    data::InstallationResult result(data::ResultCode::Numeric::kOk, "");
+    for (size_t sent = 0; sent < image.size() && result.isSuccess(); sent += chunk_size) {
+      result = update_agent.receiveData(target, data + sent, std::min(chunk_size, image.size() - sent));
+    }
+    return result;
+  }
+
+  TemporaryDirectory temp_dir_;
+  const PartitionUpdateAgent::Slots slots_{temp_dir_ / "slot_a", temp_dir_ / "slot_b"};
+};
+
+/* Images are written to the inactive slot and installing them switches slots. */
+TEST_F(PartitionUpdateAgentTest, InstallSwitchesSlots) {
+  auto update_agent = makeAgent();
+  EXPECT_EQ(update_agent->activeSlot(), slots_[0]);
+  Uptane::InstalledImageInfo info;
+  ASSERT_TRUE(update_agent->getInstalledImageInfo(info));
+  EXPECT_EQ(info.name, Uptane::Target::Unknown().filename());
+
+  const std::string image1 = makeImage(2 * 1024 * 1024 + 100, "first");
+  const auto target1 = makeTarget("image1", image1);
+  ASSERT_TRUE(sendImage(*update_agent, target1, image1).isSuccess());
+  ASSERT_TRUE(update_agent->install(target1).isSuccess());
+  EXPECT_EQ(update_agent->activeSlot(), slots_[1]);
+  // The longer image that was in the slot before has been cut off.
+  EXPECT_EQ(Utils::readFile(slots_[1]), image1);
+  EXPECT_EQ(Utils::readFile(slots_[0]), "original image");
+
+  ASSERT_TRUE(update_agent->getInstalledImageInfo(info));
+  EXPECT_EQ(info.name, "image1");
+  EXPECT_EQ(info.len, image1.size());
+  EXPECT_EQ(info.hash, boost::algorithm::to_lower_copy(target1.sha256Hash()));
+
+  const std::string image2 = makeImage(5000, "second");
+  const auto target2 = makeTarget("image2", image2);
+  ASSERT_TRUE(sendImage(*update_agent, target2, image2).isSuccess());
+  ASSERT_TRUE(update_agent->install(target2).isSuccess());
+  EXPECT_EQ(update_agent->activeSlot(), slots_[0]);
+  EXPECT_EQ(Utils::readFile(slots_[0]), image2);
+  EXPECT_EQ(Utils::readFile(slots_[1]), image1);
+
+  // The active slot is restored on restart.
+  update_agent = makeAgent();
+  EXPECT_EQ(update_agent->activeSlot(), slots_[0]);
+  ASSERT_TRUE(update_agent->getInstalledImageInfo(info));
+  EXPECT_EQ(info.len, image2.size());
+  EXPECT_EQ(info.hash, boost::algorithm::to_lower_copy(target2.sha256Hash()));
+}
+
+/* Images that do not match their Target are not installed. */
+TEST_F(PartitionUpdateAgentTest, InvalidImage) {
+  auto update_agent = makeAgent();
+  const std::string image = makeImage(4096, "image");
+
+  // Nothing received yet
+  const auto target = makeTarget("image", image);
+  EXPECT_FALSE(update_agent->install(target).isSuccess());
+
+  // Incomplete image
+  ASSERT_TRUE(sendImage(*update_agent, target, image.substr(0, 2048)).isSuccess());
+  EXPECT_FALSE(update_agent->install(target).isSuccess());
+
+  // Too much data
+  const auto short_target = makeTarget("image", image.substr(0, 2048));
+  ASSERT_TRUE(sendImage(*update_agent, short_target, image.substr(0, 2048)).isSuccess());
+  EXPECT_FALSE(update_agent->receiveData(short_target, reinterpret_cast<const uint8_t*>(image.data()), 1).isSuccess());
+
+  // Wrong content
+  std::string broken_image = image;
+  broken_image[100] = 'x';
+  ASSERT_TRUE(sendImage(*update_agent, target, broken_image).isSuccess());
+  EXPECT_FALSE(update_agent->install(target).isSuccess());
+
+  EXPECT_EQ(update_agent->activeSlot(), slots_[0]);
+  EXPECT_FALSE(boost::filesystem::exists(temp_dir_ / PartitionUpdateAgent::StateFile));
+
+  ASSERT_TRUE(sendImage(*update_agent, target, image).isSuccess());
+  EXPECT_TRUE(update_agent->install(target).isSuccess());
+  EXPECT_EQ(update_agent->activeSlot(), slots_[1]);
+}
+
+/* The Primary sends an image from its start again when it retries a transfer,
+ * whether it was interrupted or complete. */
+TEST_F(PartitionUpdateAgentTest, ReceiveImageAgain) {
+  auto update_agent = makeAgent();
+  const std::string image = makeImage(2 * 1024 * 1024 + 100, "image");
+  const auto target = makeTarget("image", image);
+
+  ASSERT_TRUE(sendImage(*update_agent, target, image.substr(0, 1024 * 1024 + 10)).isSuccess());
+  update_agent->discardReceivedData();
+  ASSERT_TRUE(sendImage(*update_agent, target, image).isSuccess());
+  update_agent->discardReceivedData();
+  ASSERT_TRUE(sendImage(*update_agent, target, image).isSuccess());
+
+  ASSERT_TRUE(update_agent->install(target).isSuccess());
+  EXPECT_EQ(update_agent->activeSlot(), slots_[1]);
+  EXPECT_EQ(Utils::readFile(slots_[1]), image);
+  EXPECT_FALSE(boost::filesystem::exists(temp_dir_ / (PartitionUpdateAgent::StateFile + ".new")));
+}
+
+/* Both slots have to be configured. */
+TEST(PartitionUpdateAgent, SlotsFromConfig) {
+  PackageConfig config;
+  config.type = PartitionUpdateAgent::PackageManager;
+  config.extra["slot_a"] = "/dev/sda2";
+  EXPECT_THROW(PartitionUpdateAgent::slotsFromConfig(config), std::runtime_error);
+
+  config.extra["slot_b"] = "/dev/sda3";
+  const auto slots = PartitionUpdateAgent::slotsFromConfig(config);
+  EXPECT_EQ(slots[0], "/dev/sda2");
+  EXPECT_EQ(slots[1], "/dev/sda3");
+}
+
+#ifndef __NO_MAIN__
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  logger_init();
+  logger_set_threshold(boost::log::trivial::info);
+  return RUN_ALL_TESTS();
+}
+#endif
@@ -0,0 +1,177 @@
+#include <benchmark/benchmark.h>
+
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "asn1_message.h"
+#include "utilities/utils.h"
+
+namespace {
+
+/* A connected pair of TCP sockets on localhost, with a thread discarding
+ * everything that arrives. */
+class LoopbackConnection {
+ public:
+  LoopbackConnection() : listen_socket_(0), client_("127.0.0.1", listen_socket_.port()) {
+    listen(*listen_socket_, 1);
+    client_.connect();
+    server_fd_ = accept(*listen_socket_, nullptr, nullptr);
+    reader_ = std::thread([this] {
+      std::array<char, 64 * 1024> buf{};
+      while (recv(server_fd_, buf.data(), buf.size(), 0) > 0) {
+      }
+    });
+  }
+  ~LoopbackConnection() {
+    shutdown(*client_, SHUT_WR);
+    reader_.join();
+    close(server_fd_);
+  }
+  int fd() { return *client_; }
+
+ private:
+  ListenSocket listen_socket_;
+  ConnectionSocket client_;
+  int server_fd_{-1};
+  std::thread reader_;
+};
+
+/* Number of TCP segments sent by this network namespace so far, from /proc/net/snmp. */
+double tcpOutSegments() {
+  std::ifstream snmp("/proc/net/snmp");
+  std::string header;
+  std::string values;
+  while (std::getline(snmp, header) && std::getline(snmp, values)) {
+    if (header.compare(0, 4, "Tcp:") != 0) {
+      continue;
+    }
+    std::istringstream names(header);
+    std::istringstream numbers(values);
+    std::string name;
+    std::string number;
+    while (names >> name && numbers >> number) {
+      if (name == "OutSegs") {
+        return std::stod(number);
+      }
+    }
+  }
+  return 0;
+}
+
+/* A putMetaReq2 message as sent to a Secondary, with eight metadata files. */
+Asn1Message::Ptr metadataMessage() {
+  Asn1Message::Ptr req(Asn1Message::Empty());
+  req->present(AKIpUptaneMes_PR_putMetaReq2);
+  auto m = req->putMetaReq2();
+  m->directorRepo.present = directorRepo_PR_collection;
+  m->imageRepo.present = imageRepo_PR_collection;
+  for (const std::string role : {"root", "targets"}) {
+    auto meta = Asn1Allocation<AKMetaJson_t>();
+    SetString(&meta->role, role);
+    SetString(&meta->json, std::string(2048, 'd'));
+    ASN_SEQUENCE_ADD(&m->directorRepo.choice.collection, meta);
+  }
+  for (const std::string role : {"root", "timestamp", "snapshot", "targets", "delegation1", "delegation2"}) {
+    auto meta = Asn1Allocation<AKMetaJson_t>();
+    SetString(&meta->role, role);
+    SetString(&meta->json, std::string(2048, 'i'));
+    ASN_SEQUENCE_ADD(&m->imageRepo.choice.collection, meta);
+  }
+  return req;
+}
+
+benchmark::Counter perMessage(double total) { return benchmark::Counter(total, benchmark::Counter::kAvgIterations); }
+
+struct UnbufferedWriter {
+  int fd;
+  size_t syscalls;
+};
+
+/* What was done before Asn1SocketWriter: one send() per encoder fragment. */
+int unbufferedWrite(const void *buffer, size_t size, void *priv) {
+  auto *writer = static_cast<UnbufferedWriter *>(priv);
+  const auto *b = static_cast<const char *>(buffer);
+  size_t pos = 0;
+  while (pos < size) {
+    ssize_t written = send(writer->fd, b + pos, size - pos, MSG_NOSIGNAL);
+    writer->syscalls++;
+    if (written < 0) {
+      return 1;
+    }
+    pos += static_cast<size_t>(written);
+  }
+  return 0;
+}
+
+void BM_SendUnbuffered(benchmark::State &state) {
+  LoopbackConnection connection;
+  Asn1Message::Ptr msg = metadataMessage();
+  UnbufferedWriter writer{connection.fd(), 0};
+  const double segments_before = tcpOutSegments();
+  for (auto _ : state) {
+    int no_delay = 0;
+    setsockopt(writer.fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(int));
+    der_encode(&asn_DEF_AKIpUptaneMes, &msg->msg_, unbufferedWrite, &writer);
+    no_delay = 1;
+    setsockopt(writer.fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(int));
+    writer.syscalls += 2;
+  }
+  state.counters["syscalls"] = perMessage(static_cast<double>(writer.syscalls));
+  state.counters["segments"] = perMessage(tcpOutSegments() - segments_before);
+}
+BENCHMARK(BM_SendUnbuffered);
+
+void BM_SendBuffered(benchmark::State &state) {
+  LoopbackConnection connection;
+  Asn1Message::Ptr msg = metadataMessage();
+  Asn1SocketWriter writer(connection.fd());
+  const double segments_before = tcpOutSegments();
+  for (auto _ : state) {
+    der_encode(&asn_DEF_AKIpUptaneMes, &msg->msg_, Asn1SocketWriter::Callback, &writer);
+    writer.flush();
+  }
+  state.counters["syscalls"] = perMessage(static_cast<double>(writer.sends()));
+  state.counters["segments"] = perMessage(tcpOutSegments() - segments_before);
+}
+BENCHMARK(BM_SendBuffered);
+
+/* DER-encode a metadata message into memory. */
+void BM_Encode(benchmark::State &state) {
+  Asn1Message::Ptr msg = metadataMessage();
+  std::string buffer;
+  for (auto _ : state) {
+    buffer.clear();
+    der_encode(&asn_DEF_AKIpUptaneMes, &msg->msg_, Asn1StringAppendCallback, &buffer);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * buffer.size()));
+}
+BENCHMARK(BM_Encode);
+
+/* Decode a metadata message the way Asn1Rpc() does it. */
+void BM_Decode(benchmark::State &state) {
+  std::string buffer;
+  der_encode(&asn_DEF_AKIpUptaneMes, &metadataMessage()->msg_, Asn1StringAppendCallback, &buffer);
+  for (auto _ : state) {
+    asn_codec_ctx_t context{};
+    AKIpUptaneMes_t *m = nullptr;
+    asn_dec_rval_t res =
+        ber_decode(&context, &asn_DEF_AKIpUptaneMes, reinterpret_cast<void **>(&m), buffer.c_str(), buffer.size());
+    Asn1Message::Ptr msg = Asn1Message::FromRaw(&m);
+    if (res.code != RC_OK) {
+      state.SkipWithError("Decoding failed");
+      break;
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * buffer.size()));
+}
+BENCHMARK(BM_Decode);
+
+}  // namespace
+
+BENCHMARK_MAIN();
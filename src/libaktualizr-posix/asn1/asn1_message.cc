@@ -1,8 +1,13 @@
 #include <arpa/inet.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <array>
+
+#include "asn1-cer.h"
 #include "asn1_message.h"
 #include "logging/logging.h"
 #include "utilities/dequeue_buffer.h"
@@ -18,30 +23,82 @@ int Asn1StringAppendCallback(const void* buffer, size_t size, void* priv) {
   return 0;
 }
 
-/**
- * Adaptor to write output of der_encode to a socket
- * priv is a SocketHandle
- */
-int Asn1SocketWriteCallback(const void* buffer, size_t size, void* priv) {
-  auto sock = reinterpret_cast<int*>(priv);  // NOLINT
-  assert(sock != nullptr);
-  assert(-1 < *sock);
-
-  const auto* b = static_cast<const char*>(buffer);
-  size_t len = size;
-  size_t pos = 0;
+Asn1SocketWriter::Asn1SocketWriter(int fd, size_t capacity) : fd_(fd), capacity_(capacity) {
+  assert(-1 < fd_);
+  buffer_.reserve(capacity_);
+  int no_delay = 1;
+  setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(int));
+}
+
+int Asn1SocketWriter::Callback(const void* buffer, size_t size, void* priv) {
+  auto* writer = static_cast<Asn1SocketWriter*>(priv);
+  assert(writer != nullptr);
+  return writer->write(static_cast<const char*>(buffer), size) ? 0 : 1;
+}
 
-  while (len > 0) {
+bool Asn1SocketWriter::write(const char* data, size_t size) {
+  if (failed_) {
+    return false;
+  }
+  if (buffer_.size() + size <= capacity_) {
+    buffer_.insert(buffer_.end(), data, data + size);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return true;
+  }
+  // Too big to buffer, e.g. a firmware chunk: send it along with the
+  // buffered data in one call.
+  std::array<iovec, 2> iov{};
+  iov[0].iov_base = buffer_.data();
+  iov[0].iov_len = buffer_.size();
+  iov[1].iov_base = const_cast<char*>(data);
+  iov[1].iov_len = size;
+  msghdr msg{};
+  msg.msg_iov = iov.data();
+  msg.msg_iovlen = iov.size();
+  ssize_t written = sendmsg(fd_, &msg, MSG_NOSIGNAL);
+  ++sends_;
+  if (written < 0) {
+    LOG_ERROR << "write: " << std::strerror(errno);
+    failed_ = true;
+    return false;
+  }
+  auto done = static_cast<size_t>(written);
+  if (done < buffer_.size()) {
+    buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(done));
+    done = 0;
+    if (!sendAll(buffer_.data(), buffer_.size())) {
+      return false;
+    }
+  } else {
+    done -= buffer_.size();
+  }
+  buffer_.clear();
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return sendAll(data + done, size - done);
+}
+
+bool Asn1SocketWriter::flush() {
+  if (failed_) {
+    return false;
+  }
+  bool res = sendAll(buffer_.data(), buffer_.size());
+  buffer_.clear();
+  return res;
+}
+
+bool Asn1SocketWriter::sendAll(const char* data, size_t size) {
+  size_t pos = 0;
+  while (pos < size) {
     // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    ssize_t written = send(*sock, b + pos, len, MSG_NOSIGNAL);
+    ssize_t written = send(fd_, data + pos, size - pos, MSG_NOSIGNAL);
+    ++sends_;
     if (written < 0) {
       LOG_ERROR << "write: " << std::strerror(errno);
-      return 1;
+      failed_ = true;
+      return false;
     }
-    len -= static_cast<size_t>(written);
     pos += static_cast<size_t>(written);
   }
-  return 0;
+  return true;
 }
 
 std::string ToString(const OCTET_STRING_t& octet_str) {
@@ -52,15 +109,45 @@ void SetString(OCTET_STRING_t* dest, const std::string& str) {
   OCTET_STRING_fromBuf(dest, str.c_str(), static_cast<int>(str.size()));
 }
 
-Asn1Message::Ptr Asn1Rpc(const Asn1Message::Ptr& tx, int con_fd) {
-  der_encode(&asn_DEF_AKIpUptaneMes, &tx->msg_, Asn1SocketWriteCallback, &con_fd);
+bool Asn1EncodeSendFirmwareReq(std::istream& firmware, uint64_t size, asn_app_consume_bytes_f* cb, void* priv) {
+  // AKIpUptaneMes ::= CHOICE { ... sendFirmwareReq [6] AKSendFirmwareReqMes ... } with explicit tags, where
+  // AKSendFirmwareReqMes ::= SEQUENCE { firmware OCTET STRING, ... }
+  const auto firmware_size = static_cast<size_t>(size);
+  const std::string firmware_len = cer_encode_length(firmware_size);
+  const size_t sequence_size = 1 + firmware_len.size() + firmware_size;
+  const std::string sequence_len = cer_encode_length(sequence_size);
+  const size_t choice_size = 1 + sequence_len.size() + sequence_size;
 
-  // Bounce TCP_NODELAY to flush the TCP send buffer
-  int no_delay = 1;
-  setsockopt(con_fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(int));
-  no_delay = 0;
-  setsockopt(con_fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(int));
+  std::string header;
+  header.push_back(static_cast<char>(kAsn1Context | 0x20 | 6));
+  header += cer_encode_length(choice_size);
+  header.push_back(static_cast<char>(kAsn1Sequence | 0x20));
+  header += sequence_len;
+  header.push_back(static_cast<char>(kAsn1OctetString));
+  header += firmware_len;
+  if (cb(header.data(), header.size(), priv) != 0) {
+    return false;
+  }
 
+  std::array<char, 64 * 1024> chunk{};
+  uint64_t remaining = size;
+  while (remaining > 0) {
+    const auto to_read = static_cast<std::streamsize>(std::min<uint64_t>(remaining, chunk.size()));
+    firmware.read(chunk.data(), to_read);
+    const std::streamsize got = firmware.gcount();
+    if (got <= 0) {
+      LOG_ERROR << "Firmware stream ended " << remaining << " bytes early";
+      return false;
+    }
+    if (cb(chunk.data(), static_cast<size_t>(got), priv) != 0) {
+      return false;
+    }
+    remaining -= static_cast<uint64_t>(got);
+  }
+  return true;
+}
+
+static Asn1Message::Ptr Asn1ReceiveResponse(int con_fd) {
   AKIpUptaneMes_t* m = nullptr;
   asn_dec_rval_t res;
   asn_codec_ctx_s context{};
@@ -89,6 +176,16 @@ Asn1Message::Ptr Asn1Rpc(const Asn1Message::Ptr& tx, int con_fd) {
   return msg;
 }
 
+Asn1Message::Ptr Asn1Rpc(const Asn1Message::Ptr& tx, int con_fd) {
+  Asn1SocketWriter writer(con_fd);
+  asn_enc_rval_t encode_result = der_encode(&asn_DEF_AKIpUptaneMes, &tx->msg_, Asn1SocketWriter::Callback, &writer);
+  if (encode_result.encoded == -1 || !writer.flush()) {
+    LOG_ERROR << "Failed to send " << tx->toStr();
+    return Asn1Message::Empty();
+  }
+  return Asn1ReceiveResponse(con_fd);
+}
+
 Asn1Message::Ptr Asn1Rpc(const Asn1Message::Ptr& tx, const std::pair<std::string, uint16_t>& addr) {
   ConnectionSocket connection(addr.first, addr.second);
 
@@ -99,3 +196,19 @@ Asn1Message::Ptr Asn1Rpc(const Asn1Message::Ptr& tx, const std::pair<std::string
   }
   return Asn1Rpc(tx, *connection);
 }
+
+Asn1Message::Ptr Asn1RpcSendFirmware(std::istream& firmware, uint64_t size,
+                                     const std::pair<std::string, uint16_t>& addr) {
+  ConnectionSocket connection(addr.first, addr.second);
+
+  if (connection.connect() < 0) {
+    LOG_ERROR << "Failed to connect to the Secondary ( " << addr.first << ":" << addr.second
+              << "): " << std::strerror(errno);
+    return Asn1Message::Empty();
+  }
+  Asn1SocketWriter writer(*connection);
+  if (!Asn1EncodeSendFirmwareReq(firmware, size, Asn1SocketWriter::Callback, &writer) || !writer.flush()) {
+    return Asn1Message::Empty();
+  }
+  return Asn1ReceiveResponse(*connection);
+}
@@ -1,5 +1,8 @@
 #ifndef ASN1_MESSAGE_H_
 #define ASN1_MESSAGE_H_
+#include <istream>
+#include <vector>
+
 #include <boost/intrusive_ptr.hpp>
 
 #include "AKIpUptaneMes.h"
@@ -91,6 +94,10 @@ class Asn1Message {
   ASN1_MESSAGE_DEFINE_ACCESSOR(AKInstallResp2Mes_t, installResp2);
   ASN1_MESSAGE_DEFINE_ACCESSOR(AKVersionReqMes_t, versionReq);
   ASN1_MESSAGE_DEFINE_ACCESSOR(AKVersionRespMes_t, versionResp);
+  ASN1_MESSAGE_DEFINE_ACCESSOR(AKPutMetaReq3Mes_t, putMetaReq3);
+  ASN1_MESSAGE_DEFINE_ACCESSOR(AKPutMetaResp3Mes_t, putMetaResp3);
+  ASN1_MESSAGE_DEFINE_ACCESSOR(AKManifestReq3Mes_t, manifestReq3);
+  ASN1_MESSAGE_DEFINE_ACCESSOR(AKManifestResp3Mes_t, manifestResp3);
 
 #define ASN1_MESSAGE_DEFINE_STR_NAME(MessageID) \
   case MessageID:                               \
@@ -120,6 +127,10 @@ class Asn1Message {
         ASN1_MESSAGE_DEFINE_STR_NAME(AKIpUptaneMes_PR_installResp2);
         ASN1_MESSAGE_DEFINE_STR_NAME(AKIpUptaneMes_PR_versionReq);
         ASN1_MESSAGE_DEFINE_STR_NAME(AKIpUptaneMes_PR_versionResp);
+        ASN1_MESSAGE_DEFINE_STR_NAME(AKIpUptaneMes_PR_putMetaReq3);
+        ASN1_MESSAGE_DEFINE_STR_NAME(AKIpUptaneMes_PR_putMetaResp3);
+        ASN1_MESSAGE_DEFINE_STR_NAME(AKIpUptaneMes_PR_manifestReq3);
+        ASN1_MESSAGE_DEFINE_STR_NAME(AKIpUptaneMes_PR_manifestResp3);
     }
     return "Unknown";
   };
@@ -151,10 +162,37 @@ class Asn1Message {
 int Asn1StringAppendCallback(const void* buffer, size_t size, void* priv);
 
 /**
- * Adaptor to write output of der_encode to a socket
- * priv is a pointer to an int holding the fd
+ * Write-coalescing adaptor from der_encode to a socket: the many small
+ * fragments emitted by the encoder are collected in a buffer, and sent in as
+ * few send() calls as possible. A message that fits in the buffer goes out
+ * with one send() in flush().
+ *
+ * Nagle's algorithm is disabled on the socket, since every flush() sends a
+ * complete message that should not be held back.
+ *
+ * Pass Asn1SocketWriter::Callback with a pointer to the writer as priv. The
+ * buffer is kept between messages, so a writer can be reused for every
+ * message on a connection.
  */
-int Asn1SocketWriteCallback(const void* buffer, size_t size, void* priv);
+class Asn1SocketWriter {
+ public:
+  explicit Asn1SocketWriter(int fd, size_t capacity = 64 * 1024);
+  static int Callback(const void* buffer, size_t size, void* priv);
+  /** Send whatever is buffered. Returns false if any send failed. */
+  bool flush();
+  /** Number of send syscalls so far. */
+  size_t sends() const { return sends_; }
+
+ private:
+  bool write(const char* data, size_t size);
+  bool sendAll(const char* data, size_t size);
+
+  int fd_;
+  size_t capacity_;
+  std::vector<char> buffer_;
+  bool failed_{false};
+  size_t sends_{0};
+};
 
 /**
  * Convert OCTET_STRING_t into std::string
@@ -163,6 +201,15 @@ std::string ToString(const OCTET_STRING_t& octet_str);
 
 void SetString(OCTET_STRING_t* dest, const std::string& str);
 
+/**
+ * DER encode a sendFirmwareReq message whose firmware is read from a stream,
+ * without holding the firmware in memory: the lengths are known up front, so
+ * the header is written first and the contents are copied in chunks. The
+ * output is identical to der_encode() of the same message.
+ * Returns false if the stream ends early or cb fails.
+ */
+bool Asn1EncodeSendFirmwareReq(std::istream& firmware, uint64_t size, asn_app_consume_bytes_f* cb, void* priv);
+
 /**
  * Open a TCP connection to client; send a message and wait for a
  * response.
@@ -170,6 +217,13 @@ void SetString(OCTET_STRING_t* dest, const std::string& str);
 Asn1Message::Ptr Asn1Rpc(const Asn1Message::Ptr& tx, int con_fd);
 Asn1Message::Ptr Asn1Rpc(const Asn1Message::Ptr& tx, const std::pair<std::string, uint16_t>& addr);
 
+/**
+ * Like Asn1Rpc(), but send a sendFirmwareReq message with the firmware read
+ * from a stream; see Asn1EncodeSendFirmwareReq().
+ */
+Asn1Message::Ptr Asn1RpcSendFirmware(std::istream& firmware, uint64_t size,
+                                     const std::pair<std::string, uint16_t>& addr);
+
 /*
  * Helper function for creating pointers to ASN.1 types. Note that the encoder
  * will free these objects for you.
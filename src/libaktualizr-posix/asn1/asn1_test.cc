@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 
 #include <iostream>
+#include <sstream>
 #include <string>
 
 #include "libaktualizr/config.h"
@@ -263,6 +264,35 @@ TEST(asn1_common, parse) {
   EXPECT_EQ(AKIpUptaneMes_PR_sendFirmwareReq, msg->present());
 }
 
+/* A streamed sendFirmwareReq is encoded exactly like der_encode() would do. */
+TEST(asn1_common, EncodeSendFirmwareReqStream) {
+  for (const size_t size : {size_t{0}, size_t{5}, size_t{127}, size_t{128}, size_t{300000}}) {
+    std::string firmware;
+    for (size_t i = 0; i < size; ++i) {
+      firmware.push_back(static_cast<char>(i % 251));
+    }
+
+    Asn1Message::Ptr req(Asn1Message::Empty());
+    req->present(AKIpUptaneMes_PR_sendFirmwareReq);
+    SetString(&req->sendFirmwareReq()->firmware, firmware);
+    std::string expected;
+    der_encode(&asn_DEF_AKIpUptaneMes, &req->msg_, Asn1StringAppendCallback, &expected);
+
+    std::istringstream stream(firmware);
+    std::string streamed;
+    EXPECT_TRUE(Asn1EncodeSendFirmwareReq(stream, firmware.size(), Asn1StringAppendCallback, &streamed));
+    EXPECT_EQ(streamed, expected) << "size " << size;
+  }
+
+  std::istringstream hello("hello");
+  std::string streamed;
+  EXPECT_TRUE(Asn1EncodeSendFirmwareReq(hello, 5, Asn1StringAppendCallback, &streamed));
+  EXPECT_EQ(streamed, Utils::fromBase64("pgkwBwQFaGVsbG8="));
+
+  std::istringstream truncated("hello");
+  EXPECT_FALSE(Asn1EncodeSendFirmwareReq(truncated, 10, Asn1StringAppendCallback, &streamed));
+}
+
 TEST(asn1_common, Asn1MessageFromRawNull) {
   Asn1Message::FromRaw(nullptr);
   AKIpUptaneMes_t* m = nullptr;
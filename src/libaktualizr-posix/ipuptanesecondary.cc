@@ -3,10 +3,13 @@
 
 #include <array>
 #include <memory>
+#include <sstream>
 
+#include "crypto/crypto.h"
 #include "ipuptanesecondary.h"
 #include "logging/logging.h"
 #include "storage/invstorage.h"
+#include "utilities/utils.h"
 
 namespace Uptane {
 
@@ -100,7 +103,7 @@ IpUptaneSecondary::IpUptaneSecondary(const std::string& address, unsigned short
  * installation. */
 void IpUptaneSecondary::getSecondaryVersion() const {
   LOG_DEBUG << "Negotiating the protocol version with Secondary " << getSerial();
-  const uint32_t latest_version = 2;
+  const uint32_t latest_version = 3;
   Asn1Message::Ptr req(Asn1Message::Empty());
   req->present(AKIpUptaneMes_PR_versionReq);
   auto m = req->versionReq();
@@ -143,7 +146,9 @@ data::InstallationResult IpUptaneSecondary::putMetadata(const Target& target) {
 
   LOG_INFO << "Sending Uptane metadata to the Secondary";
   data::InstallationResult put_result;
-  if (protocol_version == 2) {
+  if (protocol_version == 3) {
+    put_result = putMetadata_v3(meta_bundle);
+  } else if (protocol_version == 2) {
     put_result = putMetadata_v2(meta_bundle);
   } else if (protocol_version == 1) {
     put_result = putMetadata_v1(meta_bundle);
@@ -242,10 +247,98 @@ data::InstallationResult IpUptaneSecondary::putMetadata_v2(const Uptane::MetaBun
   return data::InstallationResult(static_cast<data::ResultCode::Numeric>(r->result), ToString(r->description));
 }
 
+void IpUptaneSecondary::addMetadata_v3(const Uptane::MetaBundle& meta_bundle, const Uptane::RepositoryType repo,
+                                       const Uptane::Role& role, const bool leave_out_known,
+                                       AKMetaObjectCollection_t& collection, Uptane::MetaBundle* hashes) const {
+  const auto key = std::make_pair(repo, role);
+  const std::string json = getMetaFromBundle(meta_bundle, repo, role);
+  const std::string sha256 = Crypto::sha256digest(json);
+  (*hashes)[key] = sha256;
+
+  auto* object = Asn1Allocation<AKMetaObject_t>();
+  SetString(&object->role, role.ToString());
+  SetString(&object->sha256, sha256);
+  const auto known = secondary_meta_hashes_.find(key);
+  if (leave_out_known && known != secondary_meta_hashes_.end() && known->second == sha256) {
+    object->compression = AKCompression_none;
+    SetString(&object->json, "");
+  } else {
+    // Small objects, like Timestamp metadata, may not get any smaller.
+    std::string compressed = Utils::gzipCompress(json);
+    if (compressed.size() < json.size()) {
+      object->compression = AKCompression_gzip;
+      SetString(&object->json, compressed);
+    } else {
+      object->compression = AKCompression_none;
+      SetString(&object->json, json);
+    }
+  }
+  ASN_SEQUENCE_ADD(&collection, object);
+}
+
+Asn1Message::Ptr IpUptaneSecondary::putMetadataRpc_v3(const Uptane::MetaBundle& meta_bundle,
+                                                       const bool leave_out_known, Uptane::MetaBundle* hashes) const {
+  Asn1Message::Ptr req(Asn1Message::Empty());
+  req->present(AKIpUptaneMes_PR_putMetaReq3);
+
+  auto m = req->putMetaReq3();
+  addMetadata_v3(meta_bundle, Uptane::RepositoryType::Director(), Uptane::Role::Root(), leave_out_known,
+                 m->directorRepo, hashes);
+  addMetadata_v3(meta_bundle, Uptane::RepositoryType::Director(), Uptane::Role::Targets(), leave_out_known,
+                 m->directorRepo, hashes);
+  addMetadata_v3(meta_bundle, Uptane::RepositoryType::Image(), Uptane::Role::Root(), leave_out_known, m->imageRepo,
+                 hashes);
+  addMetadata_v3(meta_bundle, Uptane::RepositoryType::Image(), Uptane::Role::Timestamp(), leave_out_known,
+                 m->imageRepo, hashes);
+  addMetadata_v3(meta_bundle, Uptane::RepositoryType::Image(), Uptane::Role::Snapshot(), leave_out_known,
+                 m->imageRepo, hashes);
+  addMetadata_v3(meta_bundle, Uptane::RepositoryType::Image(), Uptane::Role::Targets(), leave_out_known,
+                 m->imageRepo, hashes);
+
+  return Asn1Rpc(req, getAddr());
+}
+
+data::InstallationResult IpUptaneSecondary::putMetadata_v3(const Uptane::MetaBundle& meta_bundle) {
+  Uptane::MetaBundle hashes;
+  auto resp = putMetadataRpc_v3(meta_bundle, true, &hashes);
+  if (resp->present() == AKIpUptaneMes_PR_putMetaResp3 && resp->putMetaResp3()->missingMeta != 0) {
+    // The Secondary has probably been restarted since.
+    LOG_DEBUG << "Secondary " << getSerial() << " does not have the metadata that was left out; sending it in full.";
+    resp = putMetadataRpc_v3(meta_bundle, false, &hashes);
+  }
+  secondary_meta_hashes_.clear();
+
+  if (resp->present() != AKIpUptaneMes_PR_putMetaResp3) {
+    LOG_ERROR << "Secondary " << getSerial() << " failed to respond to a request to receive metadata.";
+    return data::InstallationResult(
+        data::ResultCode::Numeric::kInternalError,
+        "Secondary " + getSerial().ToString() + " failed to respond to a request to receive metadata.");
+  }
+
+  auto r = resp->putMetaResp3();
+  if (r->missingMeta != 0) {
+    return data::InstallationResult(
+        data::ResultCode::Numeric::kInternalError,
+        "Secondary " + getSerial().ToString() + " did not accept the metadata that was sent in full.");
+  }
+  data::InstallationResult result(static_cast<data::ResultCode::Numeric>(r->result), ToString(r->description));
+  if (result.isSuccess()) {
+    secondary_meta_hashes_ = std::move(hashes);
+  }
+  return result;
+}
+
 Manifest IpUptaneSecondary::getManifest() const {
   getSecondaryVersion();
 
   LOG_DEBUG << "Getting the manifest from Secondary with serial " << getSerial();
+  if (protocol_version == 3) {
+    return getManifest_v3();
+  }
+  return getManifest_v2();
+}
+
+Manifest IpUptaneSecondary::getManifest_v2() const {
   Asn1Message::Ptr req(Asn1Message::Empty());
 
   req->present(AKIpUptaneMes_PR_manifestReq);
@@ -265,6 +358,35 @@ Manifest IpUptaneSecondary::getManifest() const {
   return Utils::parseJSON(manifest);
 }
 
+Manifest IpUptaneSecondary::getManifest_v3() const {
+  Asn1Message::Ptr req(Asn1Message::Empty());
+  req->present(AKIpUptaneMes_PR_manifestReq3);
+  req->manifestReq3()->compression = AKCompression_gzip;
+  auto resp = Asn1Rpc(req, getAddr());
+
+  if (resp->present() != AKIpUptaneMes_PR_manifestResp3) {
+    LOG_ERROR << "Secondary " << getSerial() << " failed to respond to a manifest request.";
+    return Json::Value();
+  }
+  auto r = resp->manifestResp3();
+
+  std::string manifest = ToString(r->manifest);
+  if (r->compression == AKCompression_gzip) {
+    // Far more than the signed manifest of a single ECU needs.
+    const size_t max_manifest_size = 1024 * 1024;
+    try {
+      manifest = Utils::gzipDecompress(manifest, max_manifest_size);
+    } catch (const std::exception& e) {
+      LOG_ERROR << "Failed to decompress the manifest of Secondary " << getSerial() << ": " << e.what();
+      return Json::Value();
+    }
+  } else if (r->compression != AKCompression_none) {
+    LOG_ERROR << "Manifest of Secondary " << getSerial() << " has an unknown compression: " << r->compression;
+    return Json::Value();
+  }
+  return Utils::parseJSON(manifest);
+}
+
 bool IpUptaneSecondary::ping() const {
   Asn1Message::Ptr req(Asn1Message::Empty());
   req->present(AKIpUptaneMes_PR_getInfoReq);
@@ -278,7 +400,7 @@ bool IpUptaneSecondary::ping() const {
 
 data::InstallationResult IpUptaneSecondary::sendFirmware(const Uptane::Target& target) {
   data::InstallationResult send_result;
-  if (protocol_version == 2) {
+  if (protocol_version >= 2) {
     send_result = sendFirmware_v2(target);
   } else if (protocol_version == 1) {
     send_result = sendFirmware_v1(target);
@@ -291,26 +413,25 @@ data::InstallationResult IpUptaneSecondary::sendFirmware(const Uptane::Target& t
 }
 
 data::InstallationResult IpUptaneSecondary::sendFirmware_v1(const Uptane::Target& target) {
-  std::string data_to_send;
+  Asn1Message::Ptr resp;
 
   if (target.IsOstree()) {
     // empty firmware means OSTree Secondaries: pack credentials instead
-    data_to_send = secondary_provider_->getTreehubCredentials();
+    std::istringstream creds(secondary_provider_->getTreehubCredentials());
+    LOG_INFO << "Sending firmware to the Secondary, size: " << creds.str().size();
+    resp = Asn1RpcSendFirmware(creds, creds.str().size(), getAddr());
   } else {
-    std::stringstream sstr;
-    auto str = secondary_provider_->getTargetFileHandle(target);
-    sstr << str.rdbuf();
-    data_to_send = sstr.str();
+    // Stream the image from the file, the Primary may not have the memory to hold it. The file has been
+    // verified against the target's length after the download.
+    auto file = secondary_provider_->getTargetStream(target);
+    if (!file->good()) {
+      return data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed,
+                                      "Could not read target " + target.filename());
+    }
+    LOG_INFO << "Sending firmware to the Secondary, size: " << target.length();
+    resp = Asn1RpcSendFirmware(*file, target.length(), getAddr());
   }
 
-  LOG_INFO << "Sending firmware to the Secondary, size: " << data_to_send.size();
-  Asn1Message::Ptr req(Asn1Message::Empty());
-  req->present(AKIpUptaneMes_PR_sendFirmwareReq);
-
-  auto m = req->sendFirmwareReq();
-  SetString(&m->firmware, data_to_send);
-  auto resp = Asn1Rpc(req, getAddr());
-
   if (resp->present() != AKIpUptaneMes_PR_sendFirmwareResp) {
     LOG_ERROR << "Secondary " << getSerial() << " failed to respond to a request to receive firmware.";
     return data::InstallationResult(
@@ -336,7 +457,7 @@ data::InstallationResult IpUptaneSecondary::sendFirmware_v2(const Uptane::Target
 
 data::InstallationResult IpUptaneSecondary::install(const Uptane::Target& target) {
   data::InstallationResult install_result;
-  if (protocol_version == 2) {
+  if (protocol_version >= 2) {
     install_result = install_v2(target);
   } else if (protocol_version == 1) {
     install_result = install_v1(target);
@@ -408,7 +529,7 @@ data::InstallationResult IpUptaneSecondary::uploadFirmware(const Uptane::Target&
 
   auto upload_result = data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed, "");
 
-  auto image_reader = secondary_provider_->getTargetFileHandle(target);
+  auto image_reader = secondary_provider_->getTargetStream(target);
 
   uint64_t image_size = target.length();
   const size_t size = 1024;
@@ -417,9 +538,9 @@ data::InstallationResult IpUptaneSecondary::uploadFirmware(const Uptane::Target&
   auto upload_data_result = data::InstallationResult(data::ResultCode::Numeric::kOk, "");
 
   while (total_send_data < image_size && upload_data_result.isSuccess()) {
-    image_reader.read(reinterpret_cast<char*>(buf.data()), buf.size());
-    upload_data_result = uploadFirmwareData(buf.data(), static_cast<size_t>(image_reader.gcount()));
-    total_send_data += static_cast<size_t>(image_reader.gcount());
+    image_reader->read(reinterpret_cast<char*>(buf.data()), buf.size());
+    upload_data_result = uploadFirmwareData(buf.data(), static_cast<size_t>(image_reader->gcount()));
+    total_send_data += static_cast<size_t>(image_reader->gcount());
   }
   if (upload_data_result.isSuccess() && total_send_data == image_size) {
     upload_result = data::InstallationResult(data::ResultCode::Numeric::kOk, "");
@@ -428,7 +549,6 @@ data::InstallationResult IpUptaneSecondary::uploadFirmware(const Uptane::Target&
   } else {
     upload_result = data::InstallationResult(data::ResultCode::Numeric::kDownloadFailed, "Incomplete upload");
   }
-  image_reader.close();
   return upload_result;
 }
 
@@ -4,6 +4,7 @@
 #include "asn1/asn1_message.h"
 #include "der_encoder.h"
 #include "libaktualizr/secondaryinterface.h"
+#include "uptane/tuf.h"
 
 namespace Uptane {
 
@@ -42,12 +43,19 @@ class IpUptaneSecondary : public SecondaryInterface {
   void getSecondaryVersion() const;
   data::InstallationResult putMetadata_v1(const Uptane::MetaBundle& meta_bundle);
   data::InstallationResult putMetadata_v2(const Uptane::MetaBundle& meta_bundle);
+  data::InstallationResult putMetadata_v3(const Uptane::MetaBundle& meta_bundle);
+  Asn1Message::Ptr putMetadataRpc_v3(const Uptane::MetaBundle& meta_bundle, bool leave_out_known,
+                                     Uptane::MetaBundle* hashes) const;
+  Manifest getManifest_v2() const;
+  Manifest getManifest_v3() const;
   data::InstallationResult sendFirmware_v1(const Uptane::Target& target);
   data::InstallationResult sendFirmware_v2(const Uptane::Target& target);
   data::InstallationResult install_v1(const Uptane::Target& target);
   data::InstallationResult install_v2(const Uptane::Target& target);
   static void addMetadata(const Uptane::MetaBundle& meta_bundle, Uptane::RepositoryType repo, const Uptane::Role& role,
                           AKMetaCollection_t& collection);
+  void addMetadata_v3(const Uptane::MetaBundle& meta_bundle, Uptane::RepositoryType repo, const Uptane::Role& role,
+                      bool leave_out_known, AKMetaObjectCollection_t& collection, Uptane::MetaBundle* hashes) const;
   data::InstallationResult invokeInstallOnSecondary(const Uptane::Target& target);
   data::InstallationResult downloadOstreeRev(const Uptane::Target& target);
   data::InstallationResult uploadFirmware(const Uptane::Target& target);
@@ -59,6 +67,10 @@ class IpUptaneSecondary : public SecondaryInterface {
   const HardwareIdentifier hw_id_;
   const PublicKey pub_key_;
   mutable uint32_t protocol_version{0};
+  // SHA-256 hashes of the metadata the Secondary has last verified
+  // successfully, as far as the Primary knows. These objects are not sent
+  // again with protocol v3.
+  Uptane::MetaBundle secondary_meta_hashes_;
 };
 
 }  // namespace Uptane
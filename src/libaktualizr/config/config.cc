@@ -95,6 +95,12 @@ void UptaneConfig::updateFromPropertyTree(const boost::property_tree::ptree& pt)
   CopyFromConfig(force_install_completion, "force_install_completion", pt);
   CopyFromConfig(secondary_config_file, "secondary_config_file", pt);
   CopyFromConfig(secondary_preinstall_wait_sec, "secondary_preinstall_wait_sec", pt);
+  CopyFromConfig(event_queue_size, "event_queue_size", pt);
+  CopyFromConfig(secondary_metadata_concurrency, "secondary_metadata_concurrency", pt);
+  CopyFromConfig(secondary_install_concurrency, "secondary_install_concurrency", pt);
+  CopyFromConfig(secondary_type_concurrency, "secondary_type_concurrency", pt);
+  CopyFromConfig(secondary_install_order, "secondary_install_order", pt);
+  CopyFromConfig(secondary_critical_ecus, "secondary_critical_ecus", pt);
 }
 
 void UptaneConfig::writeToStream(std::ostream& out_stream) const {
@@ -106,6 +112,12 @@ void UptaneConfig::writeToStream(std::ostream& out_stream) const {
   writeOption(out_stream, force_install_completion, "force_install_completion");
   writeOption(out_stream, secondary_config_file, "secondary_config_file");
   writeOption(out_stream, secondary_preinstall_wait_sec, "secondary_preinstall_wait_sec");
+  writeOption(out_stream, event_queue_size, "event_queue_size");
+  writeOption(out_stream, secondary_metadata_concurrency, "secondary_metadata_concurrency");
+  writeOption(out_stream, secondary_install_concurrency, "secondary_install_concurrency");
+  writeOption(out_stream, secondary_type_concurrency, "secondary_type_concurrency");
+  writeOption(out_stream, secondary_install_order, "secondary_install_order");
+  writeOption(out_stream, secondary_critical_ecus, "secondary_critical_ecus");
 }
 
 void NetworkConfig::updateFromPropertyTree(const boost::property_tree::ptree& pt) {
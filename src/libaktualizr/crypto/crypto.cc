@@ -125,7 +125,7 @@ std::string Crypto::sha512digest(const std::string &text) {
   return std::string(reinterpret_cast<char *>(sha512_hash.data()), crypto_hash_sha512_BYTES);
 }
 
-std::string Crypto::RSAPSSSign(ENGINE *engine, const std::string &private_key, const std::string &message) {
+StructGuard<RSA> Crypto::loadRSAPrivateKey(ENGINE *engine, const std::string &private_key) {
   StructGuard<EVP_PKEY> key(nullptr, EVP_PKEY_free);
   StructGuard<RSA> rsa(nullptr, RSA_free);
   if (engine != nullptr) {
@@ -134,13 +134,13 @@ std::string Crypto::RSAPSSSign(ENGINE *engine, const std::string &private_key, c
 
     if (key == nullptr) {
       LOG_ERROR << "ENGINE_load_private_key failed with error " << ERR_error_string(ERR_get_error(), nullptr);
-      return std::string();
+      return rsa;
     }
 
     rsa.reset(EVP_PKEY_get1_RSA(key.get()));
     if (rsa == nullptr) {
       LOG_ERROR << "EVP_PKEY_get1_RSA failed with error " << ERR_error_string(ERR_get_error(), nullptr);
-      return std::string();
+      return rsa;
     }
   } else {
     StructGuard<BIO> bio(BIO_new_mem_buf(const_cast<char *>(private_key.c_str()), static_cast<int>(private_key.size())),
@@ -152,7 +152,7 @@ std::string Crypto::RSAPSSSign(ENGINE *engine, const std::string &private_key, c
 
     if (rsa == nullptr) {
       LOG_ERROR << "PEM_read_bio_PrivateKey failed with error " << ERR_error_string(ERR_get_error(), nullptr);
-      return std::string();
+      return rsa;
     }
 
 #if AKTUALIZR_OPENSSL_PRE_11
@@ -161,13 +161,24 @@ std::string Crypto::RSAPSSSign(ENGINE *engine, const std::string &private_key, c
     RSA_set_method(rsa.get(), RSA_PKCS1_OpenSSL());
 #endif
   }
+  return rsa;
+}
+
+std::string Crypto::RSAPSSSign(ENGINE *engine, const std::string &private_key, const std::string &message) {
+  StructGuard<RSA> rsa = loadRSAPrivateKey(engine, private_key);
+  if (rsa == nullptr) {
+    return std::string();
+  }
+  return RSAPSSSign(rsa.get(), message);
+}
 
-  const auto sign_size = static_cast<unsigned int>(RSA_size(rsa.get()));
+std::string Crypto::RSAPSSSign(RSA *rsa, const std::string &message) {
+  const auto sign_size = static_cast<unsigned int>(RSA_size(rsa));
   boost::scoped_array<unsigned char> EM(new unsigned char[sign_size]);
   boost::scoped_array<unsigned char> pSignature(new unsigned char[sign_size]);
 
   std::string digest = Crypto::sha256digest(message);
-  int status = RSA_padding_add_PKCS1_PSS(rsa.get(), EM.get(), reinterpret_cast<const unsigned char *>(digest.c_str()),
+  int status = RSA_padding_add_PKCS1_PSS(rsa, EM.get(), reinterpret_cast<const unsigned char *>(digest.c_str()),
                                          EVP_sha256(), -1 /* maximum salt length*/);
   if (status == 0) {
     LOG_ERROR << "RSA_padding_add_PKCS1_PSS failed with error " << ERR_error_string(ERR_get_error(), nullptr);
@@ -175,7 +186,7 @@ std::string Crypto::RSAPSSSign(ENGINE *engine, const std::string &private_key, c
   }
 
   /* perform digital signature */
-  status = RSA_private_encrypt(RSA_size(rsa.get()), EM.get(), pSignature.get(), rsa.get(), RSA_NO_PADDING);
+  status = RSA_private_encrypt(RSA_size(rsa), EM.get(), pSignature.get(), rsa, RSA_NO_PADDING);
   if (status == -1) {
     LOG_ERROR << "RSA_private_encrypt failed with error " << ERR_error_string(ERR_get_error(), nullptr);
     return std::string();
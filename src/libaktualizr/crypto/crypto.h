@@ -76,6 +76,8 @@ class Crypto {
   static std::string sha256digest(const std::string &text);
   static std::string sha512digest(const std::string &text);
   static std::string RSAPSSSign(ENGINE *engine, const std::string &private_key, const std::string &message);
+  static std::string RSAPSSSign(RSA *rsa, const std::string &message);
+  static StructGuard<RSA> loadRSAPrivateKey(ENGINE *engine, const std::string &private_key);
   static std::string Sign(KeyType key_type, ENGINE *engine, const std::string &private_key, const std::string &message);
   static std::string ED25519Sign(const std::string &private_key, const std::string &message);
   static bool parseP12(BIO *p12_bio, const std::string &p12_password, std::string *out_pkey, std::string *out_cert,
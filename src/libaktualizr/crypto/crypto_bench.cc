@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+
+#include "crypto/crypto.h"
+#include "crypto/keymanager.h"
+#include "crypto/signer.h"
+#include "libaktualizr/config.h"
+#include "storage/invstorage.h"
+#include "utilities/utils.h"
+
+namespace {
+
+const std::string kMessage(1024, 'x');
+
+KeyType keyTypeArg(const benchmark::State &state) { return static_cast<KeyType>(state.range(0)); }
+
+void keyTypeArgs(benchmark::internal::Benchmark *b) {
+  b->Arg(static_cast<int64_t>(KeyType::kRSA2048))
+      ->Arg(static_cast<int64_t>(KeyType::kRSA4096))
+      ->Arg(static_cast<int64_t>(KeyType::kED25519));
+}
+
+/* Parse the key for every signature, as Crypto::Sign does. */
+void BM_SignReloadKey(benchmark::State &state) {
+  std::string public_key;
+  std::string private_key;
+  Crypto::generateKeyPair(keyTypeArg(state), &public_key, &private_key);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Crypto::Sign(keyTypeArg(state), nullptr, private_key, kMessage));
+  }
+}
+BENCHMARK(BM_SignReloadKey)->Apply(keyTypeArgs);
+
+/* Reuse the parsed key. */
+void BM_SignCachedKey(benchmark::State &state) {
+  std::string public_key;
+  std::string private_key;
+  Crypto::generateKeyPair(keyTypeArg(state), &public_key, &private_key);
+  Signer signer(keyTypeArg(state), nullptr, private_key);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(signer.sign(kMessage));
+  }
+}
+BENCHMARK(BM_SignCachedKey)->Apply(keyTypeArgs);
+
+/* Sign a small manifest with the Uptane key from the SQL storage. */
+void BM_KeyManagerSignTuf(benchmark::State &state) {
+  TemporaryDirectory temp_dir;
+  Config config;
+  config.storage.path = temp_dir.Path();
+  config.uptane.key_type = keyTypeArg(state);
+  auto storage = INvStorage::newStorage(config.storage);
+  KeyManager keys(storage, config.keymanagerConfig());
+  keys.generateUptaneKeyPair();
+
+  Json::Value manifest;
+  manifest["ecu_serial"] = "primary";
+  manifest["installed_image"]["filepath"] = "firmware.bin";
+  manifest["installed_image"]["fileinfo"]["hashes"]["sha256"] = std::string(64, 'a');
+  manifest["installed_image"]["fileinfo"]["length"] = 1024;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(keys.signTuf(manifest));
+  }
+}
+BENCHMARK(BM_KeyManagerSignTuf)->Apply(keyTypeArgs);
+
+/* Hash a download in chunks of the given size, as the fetcher does. */
+void BM_MultiPartSHA256Hasher(benchmark::State &state) {
+  const std::string chunk(static_cast<size_t>(state.range(0)), 'x');
+  const int64_t chunks_per_image = (1 << 20) / state.range(0);
+  MultiPartSHA256Hasher hasher;
+  for (auto _ : state) {
+    hasher.reset();
+    for (int64_t i = 0; i < chunks_per_image; ++i) {
+      hasher.update(reinterpret_cast<const unsigned char *>(chunk.data()), chunk.size());
+    }
+    benchmark::DoNotOptimize(hasher.getHexDigest());
+  }
+  state.SetBytesProcessed(state.iterations() * chunks_per_image * state.range(0));
+}
+BENCHMARK(BM_MultiPartSHA256Hasher)->Arg(1024)->Arg(16 * 1024)->Arg(64 * 1024);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -11,6 +11,7 @@
 
 #include "crypto/crypto.h"
 #include "crypto/p11engine.h"
+#include "crypto/signer.h"
 #include "utilities/utils.h"
 
 #ifdef BUILD_P11
@@ -100,6 +101,33 @@ TEST(crypto, sign_bad_key_no_crash) {
   EXPECT_TRUE(signature.empty());
 }
 
+/* Sign repeatedly with a key that is parsed once. */
+TEST(crypto, signer_reuse_key) {
+  for (const KeyType key_type : {KeyType::kRSA2048, KeyType::kED25519}) {
+    std::string public_key;
+    std::string private_key;
+    ASSERT_TRUE(Crypto::generateKeyPair(key_type, &public_key, &private_key));
+    PublicKey pkey(public_key, key_type);
+    Signer signer(key_type, nullptr, private_key);
+    ASSERT_TRUE(signer.isValid());
+    for (const std::string text : {"This is text for sign", "This is more text for sign"}) {
+      EXPECT_TRUE(pkey.VerifySignature(Utils::toBase64(signer.sign(text)), text));
+    }
+  }
+  EXPECT_EQ(Signer(KeyType::kRSA2048, nullptr, "").method(), "rsassa-pss");
+  EXPECT_EQ(Signer(KeyType::kED25519, nullptr, "").method(), "ed25519");
+}
+
+/* Refuse to sign with a key that could not be loaded. */
+TEST(crypto, signer_bad_key_no_crash) {
+  Signer signer(KeyType::kRSA2048, nullptr, "this is bad key");
+  EXPECT_FALSE(signer.isValid());
+  EXPECT_TRUE(signer.sign("This is text for sign").empty());
+  Signer short_signer(KeyType::kED25519, nullptr, "abcd");
+  EXPECT_FALSE(short_signer.isValid());
+  EXPECT_TRUE(short_signer.sign("This is text for sign").empty());
+}
+
 /* Reject a signature if the key is invalid. */
 TEST(crypto, verify_bad_key_no_crash) {
   std::string text = "This is text for sign";
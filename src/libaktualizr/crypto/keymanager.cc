@@ -1,11 +1,13 @@
 #include "keymanager.h"
 
+#include <mutex>
 #include <stdexcept>
 #include <utility>
 
 #include <boost/scoped_array.hpp>
 
 #include "crypto/openssl_compat.h"
+#include "crypto/signer.h"
 #include "libaktualizr/types.h"
 #include "storage/invstorage.h"
 
@@ -27,6 +29,7 @@ KeyManager::KeyManager(std::shared_ptr<INvStorage> backend, KeyManagerConfig con
 
 void KeyManager::loadKeys(const std::string *pkey_content, const std::string *cert_content,
                           const std::string *ca_content) {
+  std::lock_guard<std::mutex> guard(tmp_files_mutex_);
   if (config_.tls_pkey_source == CryptoSource::kFile) {
     std::string pkey;
     if (pkey_content != nullptr) {
@@ -34,11 +37,9 @@ void KeyManager::loadKeys(const std::string *pkey_content, const std::string *ce
     } else {
       backend_->loadTlsPkey(&pkey);
     }
-    if (!pkey.empty()) {
-      if (tmp_pkey_file == nullptr) {
-        tmp_pkey_file = std_::make_unique<TemporaryFile>("tls-pkey");
-      }
-      tmp_pkey_file->PutContents(pkey);
+    if (pkey != tls_pkey_) {
+      tls_pkey_ = std::move(pkey);
+      tmp_pkey_file.reset();
     }
   }
   if (config_.tls_cert_source == CryptoSource::kFile) {
@@ -48,11 +49,9 @@ void KeyManager::loadKeys(const std::string *pkey_content, const std::string *ce
     } else {
       backend_->loadTlsCert(&cert);
     }
-    if (!cert.empty()) {
-      if (tmp_cert_file == nullptr) {
-        tmp_cert_file = std_::make_unique<TemporaryFile>("tls-cert");
-      }
-      tmp_cert_file->PutContents(cert);
+    if (cert != tls_cert_) {
+      tls_cert_ = std::move(cert);
+      tmp_cert_file.reset();
     }
   }
   if (config_.tls_ca_source == CryptoSource::kFile) {
@@ -62,15 +61,28 @@ void KeyManager::loadKeys(const std::string *pkey_content, const std::string *ce
     } else {
       backend_->loadTlsCa(&ca);
     }
-    if (!ca.empty()) {
-      if (tmp_ca_file == nullptr) {
-        tmp_ca_file = std_::make_unique<TemporaryFile>("tls-ca");
-      }
-      tmp_ca_file->PutContents(ca);
+    if (ca != tls_ca_) {
+      tls_ca_ = std::move(ca);
+      tmp_ca_file.reset();
     }
   }
 }
 
+// Credentials are only written out when a consumer needs a path to them, and
+// then only once for as long as they do not change.
+std::string KeyManager::tmpFilePath(std::unique_ptr<TemporaryFile> &tmp_file, const std::string &name,
+                                    const std::string &content) const {
+  std::lock_guard<std::mutex> guard(tmp_files_mutex_);
+  if (content.empty()) {
+    return std::string();
+  }
+  if (tmp_file == nullptr) {
+    tmp_file = std_::make_unique<TemporaryFile>(name);
+    tmp_file->PutContents(content);
+  }
+  return tmp_file->PathString();
+}
+
 std::string KeyManager::getPkeyFile() const {
   std::string pkey_file;
   if (config_.tls_pkey_source == CryptoSource::kPkcs11) {
@@ -80,9 +92,7 @@ std::string KeyManager::getPkeyFile() const {
     pkey_file = (*p11_)->getTlsPkeyId();
   }
   if (config_.tls_pkey_source == CryptoSource::kFile) {
-    if (tmp_pkey_file && !boost::filesystem::is_empty(tmp_pkey_file->PathString())) {
-      pkey_file = tmp_pkey_file->PathString();
-    }
+    pkey_file = tmpFilePath(tmp_pkey_file, "tls-pkey", tls_pkey_);
   }
   return pkey_file;
 }
@@ -96,9 +106,7 @@ std::string KeyManager::getCertFile() const {
     cert_file = (*p11_)->getTlsCertId();
   }
   if (config_.tls_cert_source == CryptoSource::kFile) {
-    if (tmp_cert_file && !boost::filesystem::is_empty(tmp_cert_file->PathString())) {
-      cert_file = tmp_cert_file->PathString();
-    }
+    cert_file = tmpFilePath(tmp_cert_file, "tls-cert", tls_cert_);
   }
   return cert_file;
 }
@@ -112,9 +120,7 @@ std::string KeyManager::getCaFile() const {
     ca_file = (*p11_)->getTlsCacertId();
   }
   if (config_.tls_ca_source == CryptoSource::kFile) {
-    if (tmp_ca_file && !boost::filesystem::is_empty(tmp_ca_file->PathString())) {
-      ca_file = tmp_ca_file->PathString();
-    }
+    ca_file = tmpFilePath(tmp_ca_file, "tls-ca", tls_ca_);
   }
   return ca_file;
 }
@@ -254,41 +260,46 @@ void KeyManager::copyCertsToCurl(HttpInterface &http) const {
   }
 }
 
-Json::Value KeyManager::signTuf(const Json::Value &in_data) const {
-  ENGINE *crypto_engine = nullptr;
-  std::string private_key;
-  if (config_.uptane_key_source == CryptoSource::kPkcs11) {
-    if (!built_with_p11) {
-      throw std::runtime_error("Aktualizr was built without PKCS#11");
+std::shared_ptr<const Signer> KeyManager::uptaneSigner(std::string *key_id) const {
+  std::lock_guard<std::mutex> guard(signer_mutex_);
+  if (signer_ == nullptr) {
+    ENGINE *crypto_engine = nullptr;
+    std::string private_key;
+    if (config_.uptane_key_source == CryptoSource::kPkcs11) {
+      if (!built_with_p11) {
+        throw std::runtime_error("Aktualizr was built without PKCS#11");
+      }
+      crypto_engine = (*p11_)->getEngine();
+      private_key = config_.p11.uptane_key_id;
     }
-    crypto_engine = (*p11_)->getEngine();
-    private_key = config_.p11.uptane_key_id;
+    if (config_.uptane_key_source == CryptoSource::kFile) {
+      backend_->loadPrimaryPrivate(&private_key);
+    }
+    std::shared_ptr<const Signer> signer =
+        std::make_shared<Signer>(config_.uptane_key_type, crypto_engine, private_key);
+    // Keep trying to load the key on the next signature until there is one.
+    if (!signer->isValid()) {
+      *key_id = UptanePublicKey().KeyId();
+      return signer;
+    }
+    signer_ = signer;
+    signer_key_id_ = UptanePublicKey().KeyId();
   }
+  *key_id = signer_key_id_;
+  return signer_;
+}
 
-  std::string b64sig;
-  if (config_.uptane_key_source == CryptoSource::kFile) {
-    backend_->loadPrimaryPrivate(&private_key);
-  }
-  b64sig = Utils::toBase64(
-      Crypto::Sign(config_.uptane_key_type, crypto_engine, private_key, Utils::jsonToCanonicalStr(in_data)));
+Json::Value KeyManager::signTuf(const Json::Value &in_data) const {
+  std::string key_id;
+  std::shared_ptr<const Signer> signer = uptaneSigner(&key_id);
+  std::string b64sig = Utils::toBase64(signer->sign(Utils::jsonToCanonicalStr(in_data)));
 
   Json::Value signature;
-  switch (config_.uptane_key_type) {
-    case KeyType::kRSA2048:
-    case KeyType::kRSA3072:
-    case KeyType::kRSA4096:
-      signature["method"] = "rsassa-pss";
-      break;
-    case KeyType::kED25519:
-      signature["method"] = "ed25519";
-      break;
-    default:
-      throw std::runtime_error("Unknown key type");
-  }
+  signature["method"] = signer->method();
   signature["sig"] = b64sig;
 
   Json::Value out_data;
-  signature["keyid"] = UptanePublicKey().KeyId();
+  signature["keyid"] = key_id;
   out_data["signed"] = in_data;
   out_data["signatures"] = Json::Value(Json::arrayValue);
   out_data["signatures"].append(signature);
@@ -297,6 +308,10 @@ Json::Value KeyManager::signTuf(const Json::Value &in_data) const {
 
 std::string KeyManager::generateUptaneKeyPair() {
   std::string primary_public;
+  {
+    std::lock_guard<std::mutex> guard(signer_mutex_);
+    signer_.reset();
+  }
 
   if (config_.uptane_key_source == CryptoSource::kFile) {
     std::string primary_private;
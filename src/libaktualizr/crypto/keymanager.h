@@ -1,6 +1,8 @@
 #ifndef KEYMANAGER_H_
 #define KEYMANAGER_H_
 
+#include <mutex>
+
 #include "libaktualizr/config.h"
 
 #include "crypto.h"
@@ -9,6 +11,7 @@
 #include "utilities/utils.h"
 
 class INvStorage;
+class Signer;
 
 class KeyManager {
  public:
@@ -16,6 +19,10 @@ class KeyManager {
   // Contains the logic from HttpClient::setCerts()
   void copyCertsToCurl(HttpInterface &http) const;
   KeyManager(std::shared_ptr<INvStorage> backend, KeyManagerConfig config);
+  /**
+   * Load the TLS credentials into memory. They are only written to temporary
+   * files if one of the get*File() methods is called.
+   */
   void loadKeys(const std::string *pkey_content = nullptr, const std::string *cert_content = nullptr,
                 const std::string *ca_content = nullptr);
   std::string getPkeyFile() const;
@@ -29,6 +36,7 @@ class KeyManager {
   bool isOk() const { return ((getPkey().size() != 0U) && (getCert().size() != 0U) && (getCa().size() != 0U)); }
   std::string generateUptaneKeyPair();
   KeyType getUptaneKeyType() const { return config_.uptane_key_type; }
+  /** Sign with the Uptane key, which is only loaded for the first signature. */
   Json::Value signTuf(const Json::Value &in_data) const;
 
   PublicKey UptanePublicKey() const;
@@ -37,9 +45,21 @@ class KeyManager {
   std::shared_ptr<INvStorage> backend_;
   const KeyManagerConfig config_;
   std::unique_ptr<P11EngineGuard> p11_;
-  std::unique_ptr<TemporaryFile> tmp_pkey_file;
-  std::unique_ptr<TemporaryFile> tmp_cert_file;
-  std::unique_ptr<TemporaryFile> tmp_ca_file;
+  std::string tls_pkey_;
+  std::string tls_cert_;
+  std::string tls_ca_;
+  mutable std::mutex tmp_files_mutex_;
+  mutable std::unique_ptr<TemporaryFile> tmp_pkey_file;
+  mutable std::unique_ptr<TemporaryFile> tmp_cert_file;
+  mutable std::unique_ptr<TemporaryFile> tmp_ca_file;
+
+  mutable std::mutex signer_mutex_;
+  mutable std::shared_ptr<const Signer> signer_;
+  mutable std::string signer_key_id_;
+
+  std::shared_ptr<const Signer> uptaneSigner(std::string *key_id) const;
+  std::string tmpFilePath(std::unique_ptr<TemporaryFile> &tmp_file, const std::string &name,
+                          const std::string &content) const;
 
   FRIEND_TEST(KeyManager, AllTestsPkcs11);
 };
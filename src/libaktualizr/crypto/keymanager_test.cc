@@ -110,6 +110,32 @@ TEST(KeyManager, InitFileValid) {
   EXPECT_EQ(cert, Utils::readFile(cert_file));
 }
 
+/* TLS credentials are only written to disk when a file is requested, and only
+ * rewritten when they change. */
+TEST(KeyManager, TmpFilesOnDemand) {
+  Config config;
+  TemporaryDirectory temp_dir;
+  config.storage.path = temp_dir.Path();
+  std::shared_ptr<INvStorage> storage = INvStorage::newStorage(config.storage);
+  std::string ca = Utils::readFile("tests/test_data/prov/root.crt");
+  std::string pkey = Utils::readFile("tests/test_data/prov/pkey.pem");
+  std::string cert = Utils::readFile("tests/test_data/prov/client.pem");
+  storage->storeTlsCreds(ca, cert, pkey);
+  KeyManager keys(storage, config.keymanagerConfig());
+  keys.loadKeys();
+
+  const std::string ca_file = keys.getCaFile();
+  keys.loadKeys();
+  EXPECT_EQ(keys.getCaFile(), ca_file);
+  EXPECT_EQ(ca, Utils::readFile(ca_file));
+
+  std::string new_ca = Utils::readFile("tests/test_data/CAcert.pem");
+  storage->storeTlsCa(new_ca);
+  keys.loadKeys();
+  EXPECT_FALSE(boost::filesystem::exists(ca_file));
+  EXPECT_EQ(new_ca, Utils::readFile(keys.getCaFile()));
+}
+
 #ifdef BUILD_P11
 /* Generate Uptane keys, use them for signing, and verify them. */
 TEST(KeyManager, AllTestsPkcs11) {
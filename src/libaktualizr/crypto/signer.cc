@@ -0,0 +1,43 @@
+#include "signer.h"
+
+#include <stdexcept>
+
+#include <boost/algorithm/hex.hpp>
+
+Signer::Signer(KeyType key_type, ENGINE *engine, const std::string &private_key) : key_type_(key_type) {
+  if (key_type_ == KeyType::kED25519) {
+    ed25519_key_ = boost::algorithm::unhex(private_key);
+  } else {
+    rsa_ = Crypto::loadRSAPrivateKey(engine, private_key);
+  }
+}
+
+bool Signer::isValid() const {
+  if (key_type_ == KeyType::kED25519) {
+    return ed25519_key_.size() == crypto_sign_SECRETKEYBYTES;
+  }
+  return rsa_ != nullptr;
+}
+
+std::string Signer::sign(const std::string &message) const {
+  if (!isValid()) {
+    return std::string();
+  }
+  if (key_type_ == KeyType::kED25519) {
+    return Crypto::ED25519Sign(ed25519_key_, message);
+  }
+  return Crypto::RSAPSSSign(rsa_.get(), message);
+}
+
+std::string Signer::method() const {
+  switch (key_type_) {
+    case KeyType::kRSA2048:
+    case KeyType::kRSA3072:
+    case KeyType::kRSA4096:
+      return "rsassa-pss";
+    case KeyType::kED25519:
+      return "ed25519";
+    default:
+      throw std::runtime_error("Unknown key type");
+  }
+}
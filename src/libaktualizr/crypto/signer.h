@@ -0,0 +1,36 @@
+#ifndef SIGNER_H_
+#define SIGNER_H_
+
+#include <string>
+
+#include "crypto.h"
+
+/**
+ * Signs messages with a private key that is parsed only once.
+ *
+ * Loading the key (parsing PEM or looking it up on a PKCS#11 token through
+ * the engine) costs much more than producing a signature, so anything that
+ * signs repeatedly with the same key should keep a Signer around. sign() may
+ * be called concurrently.
+ */
+class Signer {
+ public:
+  /**
+   * @param private_key PEM for RSA keys, hex for ED25519 keys, or the key ID
+   *                    on the token if engine is not null.
+   */
+  Signer(KeyType key_type, ENGINE *engine, const std::string &private_key);
+
+  /** Whether the key could be loaded. sign() returns an empty string if not. */
+  bool isValid() const;
+  std::string sign(const std::string &message) const;
+  /** Signature method name as used in TUF metadata. */
+  std::string method() const;
+
+ private:
+  KeyType key_type_;
+  StructGuard<RSA> rsa_{nullptr, RSA_free};
+  std::string ed25519_key_;
+};
+
+#endif  // SIGNER_H_
@@ -11,6 +11,21 @@ struct WriteStringArg {
   int64_t limit{0};
 };
 
+#if LIBCURL_VERSION_NUM >= 0x074700
+/**
+ * Hand a PEM blob to curl, which keeps its own copy, so that TLS credentials
+ * never have to be written to disk. Returns false if the TLS backend of this
+ * libcurl cannot load them from memory.
+ */
+static bool setBlob(CURL* curl_handle, CURLoption option, const std::string& data) {
+  struct curl_blob blob {};
+  blob.data = const_cast<char*>(data.data());
+  blob.len = data.size();
+  blob.flags = CURL_BLOB_COPY;
+  return curl_easy_setopt(curl_handle, option, &blob) == CURLE_OK;
+}
+#endif
+
 /*****************************************************************************/
 /**
  * \par Description:
@@ -86,20 +101,39 @@ void HttpClient::setCerts(const std::string& ca, CryptoSource ca_source, const s
   if (ca_source == CryptoSource::kPkcs11) {
     throw std::runtime_error("Accessing CA certificate on PKCS11 devices isn't currently supported");
   }
-  std::unique_ptr<TemporaryFile> tmp_ca_file = std_::make_unique<TemporaryFile>("tls-ca");
-  tmp_ca_file->PutContents(ca);
-  curlEasySetoptWrapper(curl, CURLOPT_CAINFO, tmp_ca_file->Path().c_str());
-  tls_ca_file = std::move_if_noexcept(tmp_ca_file);
+  bool ca_in_memory = false;
+#if LIBCURL_VERSION_NUM >= 0x074d00
+  ca_in_memory = setBlob(curl, CURLOPT_CAINFO_BLOB, ca);
+#endif
+  if (ca_in_memory) {
+    // Trust only the given CA, as with CURLOPT_CAINFO, and not the system store.
+    curlEasySetoptWrapper(curl, CURLOPT_CAINFO, static_cast<char*>(nullptr));
+    curlEasySetoptWrapper(curl, CURLOPT_CAPATH, static_cast<char*>(nullptr));
+    tls_ca_file.reset();
+  } else {
+    std::unique_ptr<TemporaryFile> tmp_ca_file = std_::make_unique<TemporaryFile>("tls-ca");
+    tmp_ca_file->PutContents(ca);
+    curlEasySetoptWrapper(curl, CURLOPT_CAINFO, tmp_ca_file->Path().c_str());
+    tls_ca_file = std::move_if_noexcept(tmp_ca_file);
+  }
 
   if (cert_source == CryptoSource::kPkcs11) {
     curlEasySetoptWrapper(curl, CURLOPT_SSLCERT, cert.c_str());
     curlEasySetoptWrapper(curl, CURLOPT_SSLCERTTYPE, "ENG");
   } else {  // cert_source == CryptoSource::kFile
-    std::unique_ptr<TemporaryFile> tmp_cert_file = std_::make_unique<TemporaryFile>("tls-cert");
-    tmp_cert_file->PutContents(cert);
-    curlEasySetoptWrapper(curl, CURLOPT_SSLCERT, tmp_cert_file->Path().c_str());
+    bool cert_in_memory = false;
+#if LIBCURL_VERSION_NUM >= 0x074700
+    cert_in_memory = setBlob(curl, CURLOPT_SSLCERT_BLOB, cert);
+#endif
+    if (cert_in_memory) {
+      tls_cert_file.reset();
+    } else {
+      std::unique_ptr<TemporaryFile> tmp_cert_file = std_::make_unique<TemporaryFile>("tls-cert");
+      tmp_cert_file->PutContents(cert);
+      curlEasySetoptWrapper(curl, CURLOPT_SSLCERT, tmp_cert_file->Path().c_str());
+      tls_cert_file = std::move_if_noexcept(tmp_cert_file);
+    }
     curlEasySetoptWrapper(curl, CURLOPT_SSLCERTTYPE, "PEM");
-    tls_cert_file = std::move_if_noexcept(tmp_cert_file);
   }
   pkcs11_cert = (cert_source == CryptoSource::kPkcs11);
 
@@ -109,11 +143,19 @@ void HttpClient::setCerts(const std::string& ca, CryptoSource ca_source, const s
     curlEasySetoptWrapper(curl, CURLOPT_SSLKEY, pkey.c_str());
     curlEasySetoptWrapper(curl, CURLOPT_SSLKEYTYPE, "ENG");
   } else {  // pkey_source == CryptoSource::kFile
-    std::unique_ptr<TemporaryFile> tmp_pkey_file = std_::make_unique<TemporaryFile>("tls-pkey");
-    tmp_pkey_file->PutContents(pkey);
-    curlEasySetoptWrapper(curl, CURLOPT_SSLKEY, tmp_pkey_file->Path().c_str());
+    bool pkey_in_memory = false;
+#if LIBCURL_VERSION_NUM >= 0x074700
+    pkey_in_memory = setBlob(curl, CURLOPT_SSLKEY_BLOB, pkey);
+#endif
+    if (pkey_in_memory) {
+      tls_pkey_file.reset();
+    } else {
+      std::unique_ptr<TemporaryFile> tmp_pkey_file = std_::make_unique<TemporaryFile>("tls-pkey");
+      tmp_pkey_file->PutContents(pkey);
+      curlEasySetoptWrapper(curl, CURLOPT_SSLKEY, tmp_pkey_file->Path().c_str());
+      tls_pkey_file = std::move_if_noexcept(tmp_pkey_file);
+    }
     curlEasySetoptWrapper(curl, CURLOPT_SSLKEYTYPE, "PEM");
-    tls_pkey_file = std::move_if_noexcept(tmp_pkey_file);
   }
   pkcs11_key = (pkey_source == CryptoSource::kPkcs11);
 }
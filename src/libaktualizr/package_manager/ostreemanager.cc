@@ -34,9 +34,21 @@ static void aktualizr_progress_cb(OstreeAsyncProgress *progress, gpointer data)
   guint outstanding_metadata_fetches = ostree_async_progress_get_uint(progress, "outstanding-metadata-fetches");
   guint outstanding_writes = ostree_async_progress_get_uint(progress, "outstanding-writes");
   guint n_scanned_metadata = ostree_async_progress_get_uint(progress, "scanned-metadata");
+  guint total_delta_parts = ostree_async_progress_get_uint(progress, "total-delta-parts");
 
   if (status != nullptr && *status != '\0') {
     LOG_INFO << "ostree-pull: " << status;
+  } else if (outstanding_fetches != 0 && total_delta_parts != 0) {
+    guint64 fetched_size = ostree_async_progress_get_uint64(progress, "fetched-delta-part-size");
+    guint64 total_size = ostree_async_progress_get_uint64(progress, "total-delta-part-size");
+    guint calculated = total_size != 0 ? static_cast<guint>((fetched_size * 100) / total_size) : 0;
+    if (calculated != mt->percent_complete) {
+      mt->percent_complete = calculated;
+      LOG_INFO << "ostree-pull: Receiving static delta: " << calculated << "% ";
+      if (mt->progress_cb) {
+        mt->progress_cb(mt->target, "Receiving static delta", calculated);
+      }
+    }
   } else if (outstanding_fetches != 0) {
     guint fetched = ostree_async_progress_get_uint(progress, "fetched");
     guint metadata_fetched = ostree_async_progress_get_uint(progress, "metadata-fetched");
@@ -67,17 +79,53 @@ static void aktualizr_progress_cb(OstreeAsyncProgress *progress, gpointer data)
   }
 }
 
+// Remote ref used to tell OSTree which commit a static delta should start from.
+constexpr const char *delta_base_ref = "aktualizr-delta-base";
+
+/* Pull a single commit. If from_hash is not empty, only a static delta from
+ * from_hash is accepted, otherwise the commit is fetched object by object. */
+static bool pullCommit(OstreeRepo *repo, const std::string &refhash, const std::string &from_hash, PullMetaStruct *mt,
+                       GError **error) {
+  GVariantBuilder builder;
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+  g_variant_builder_add(&builder, "{s@v}", "flags", g_variant_new_variant(g_variant_new_int32(0)));
+
+  if (from_hash.empty()) {
+    // NOLINTNEXTLINE(modernize-avoid-c-arrays, cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays)
+    const char *const commit_ids[] = {refhash.c_str()};
+    g_variant_builder_add(&builder, "{s@v}", "refs", g_variant_new_variant(g_variant_new_strv(commit_ids, 1)));
+  } else {
+    // OSTree only looks for a delta when it knows the local revision of the ref it pulls, so pull our own ref
+    // pointing at from_hash, overridden to the target commit.
+    // NOLINTNEXTLINE(modernize-avoid-c-arrays, cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays)
+    const char *const refs[] = {delta_base_ref};
+    // NOLINTNEXTLINE(modernize-avoid-c-arrays, cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays)
+    const char *const commit_ids[] = {refhash.c_str()};
+    g_variant_builder_add(&builder, "{s@v}", "refs", g_variant_new_variant(g_variant_new_strv(refs, 1)));
+    g_variant_builder_add(&builder, "{s@v}", "override-commit-ids",
+                          g_variant_new_variant(g_variant_new_strv(commit_ids, 1)));
+    g_variant_builder_add(&builder, "{s@v}", "require-static-deltas",
+                          g_variant_new_variant(g_variant_new_boolean(TRUE)));
+  }
+  GVariant *options = g_variant_ref_sink(g_variant_builder_end(&builder));
+
+  mt->percent_complete = 0;
+  GObjectUniquePtr<OstreeAsyncProgress> progress(ostree_async_progress_new_and_connect(aktualizr_progress_cb, mt));
+  const bool res =
+      ostree_repo_pull_with_options(repo, remote, options, progress.get(), mt->cancellable.get(), error) != 0;
+  if (res) {
+    ostree_async_progress_finish(progress.get());
+  }
+  g_variant_unref(options);
+  return res;
+}
+
 data::InstallationResult OstreeManager::pull(const boost::filesystem::path &sysroot_path,
                                              const std::string &ostree_server, const KeyManager &keys,
                                              const Uptane::Target &target, const api::FlowControlToken *token,
-                                             OstreeProgressCb progress_cb) {
+                                             OstreeProgressCb progress_cb, const std::string &delta_base) {
   const std::string refhash = target.sha256Hash();
-  // NOLINTNEXTLINE(modernize-avoid-c-arrays, cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays)
-  const char *const commit_ids[] = {refhash.c_str()};
   GError *error = nullptr;
-  GVariantBuilder builder;
-  GVariant *options;
-  GObjectUniquePtr<OstreeAsyncProgress> progress = nullptr;
 
   GObjectUniquePtr<OstreeSysroot> sysroot = OstreeManager::LoadSysroot(sysroot_path);
   GObjectUniquePtr<OstreeRepo> repo = LoadRepo(sysroot.get(), &error);
@@ -106,24 +154,41 @@ data::InstallationResult OstreeManager::pull(const boost::filesystem::path &sysr
     return data::InstallationResult(data::ResultCode::Numeric::kInstallFailed, "Error adding OSTree remote");
   }
 
-  g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
-  g_variant_builder_add(&builder, "{s@v}", "flags", g_variant_new_variant(g_variant_new_int32(0)));
-
-  g_variant_builder_add(&builder, "{s@v}", "refs", g_variant_new_variant(g_variant_new_strv(commit_ids, 1)));
+  PullMetaStruct mt(target, token, g_cancellable_new(), std::move(progress_cb));
 
-  options = g_variant_builder_end(&builder);
+  // A static delta is a single large download instead of one request per object; fall back to fetching objects if
+  // the server does not have one.
+  bool pulled = false;
+  if (!delta_base.empty() && delta_base != refhash &&
+      ostree_repo_set_ref_immediate(repo.get(), remote, delta_base_ref, delta_base.c_str(), nullptr, &error) != 0) {
+    pulled = pullCommit(repo.get(), refhash, delta_base, &mt, &error);
+    if (pulled) {
+      LOG_INFO << "Pulled " << refhash << " using a static delta from " << delta_base;
+    } else if (g_cancellable_is_cancelled(mt.cancellable.get()) != 0) {
+      LOG_ERROR << "Error while pulling image: " << error->code << " " << error->message;
+      data::InstallationResult install_res(data::ResultCode::Numeric::kInstallFailed, error->message);
+      g_error_free(error);
+      ostree_repo_set_ref_immediate(repo.get(), remote, delta_base_ref, nullptr, nullptr, nullptr);
+      return install_res;
+    } else {
+      LOG_INFO << "No usable static delta from " << delta_base << " (" << error->message << "), fetching objects";
+      g_error_free(error);
+      error = nullptr;
+    }
+    // The ref only served as the delta base, don't let it keep the commit alive.
+    ostree_repo_set_ref_immediate(repo.get(), remote, delta_base_ref, nullptr, nullptr, nullptr);
+  }
+  if (error != nullptr) {
+    g_error_free(error);
+    error = nullptr;
+  }
 
-  PullMetaStruct mt(target, token, g_cancellable_new(), std::move(progress_cb));
-  progress.reset(ostree_async_progress_new_and_connect(aktualizr_progress_cb, &mt));
-  if (ostree_repo_pull_with_options(repo.get(), remote, options, progress.get(), mt.cancellable.get(), &error) == 0) {
+  if (!pulled && !pullCommit(repo.get(), refhash, "", &mt, &error)) {
     LOG_ERROR << "Error while pulling image: " << error->code << " " << error->message;
     data::InstallationResult install_res(data::ResultCode::Numeric::kInstallFailed, error->message);
     g_error_free(error);
-    g_variant_unref(options);
     return install_res;
   }
-  ostree_async_progress_finish(progress.get());
-  g_variant_unref(options);
   return data::InstallationResult(data::ResultCode::Numeric::kOk, "Pulling OSTree image was successful");
 }
 
@@ -265,7 +330,8 @@ bool OstreeManager::fetchTarget(const Uptane::Target &target, Uptane::Fetcher &f
     // while the target is aimed for a Secondary ECU that is configured with another/non-OSTree package manager
     return PackageManagerInterface::fetchTarget(target, fetcher, keys, progress_cb, token);
   }
-  return OstreeManager::pull(config.sysroot, config.ostree_server, keys, target, token, progress_cb).success;
+  return OstreeManager::pull(config.sysroot, config.ostree_server, keys, target, token, progress_cb, getDeltaBase())
+      .success;
 }
 
 TargetStatus OstreeManager::verifyTarget(const Uptane::Target &target) const {
@@ -338,6 +404,15 @@ std::string OstreeManager::getCurrentHash() const {
   return ostree_deployment_get_csum(booted_deployment);
 }
 
+std::string OstreeManager::getDeltaBase() const {
+  try {
+    return getCurrentHash();
+  } catch (const std::exception &e) {
+    LOG_DEBUG << "No static delta base: " << e.what();
+    return "";
+  }
+}
+
 Uptane::Target OstreeManager::getCurrent() const {
   const std::string current_hash = getCurrentHash();
   boost::optional<Uptane::Target> current_version;
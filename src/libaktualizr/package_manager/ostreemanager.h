@@ -46,6 +46,9 @@ class OstreeManager : public PackageManagerInterface {
   std::string name() const override { return "ostree"; }
   Json::Value getInstalledPackages() const override;
   virtual std::string getCurrentHash() const;
+  // Commit to pull static deltas from: the booted one, or none if there is no
+  // booted deployment.
+  std::string getDeltaBase() const;
   Uptane::Target getCurrent() const override;
   bool imageUpdated();
   data::InstallationResult install(const Uptane::Target &target) const override;
@@ -60,10 +63,11 @@ class OstreeManager : public PackageManagerInterface {
   static GObjectUniquePtr<OstreeSysroot> LoadSysroot(const boost::filesystem::path &path);
   static GObjectUniquePtr<OstreeRepo> LoadRepo(OstreeSysroot *sysroot, GError **error);
   static bool addRemote(OstreeRepo *repo, const std::string &url, const KeyManager &keys);
+  // Tries a static delta from delta_base first, if one is given.
   static data::InstallationResult pull(const boost::filesystem::path &sysroot_path, const std::string &ostree_server,
                                        const KeyManager &keys, const Uptane::Target &target,
                                        const api::FlowControlToken *token = nullptr,
-                                       OstreeProgressCb progress_cb = nullptr);
+                                       OstreeProgressCb progress_cb = nullptr, const std::string &delta_base = "");
 
  private:
   TargetStatus verifyTargetInternal(const Uptane::Target &target) const;
@@ -6,11 +6,15 @@
 #include <string>
 
 #include <boost/algorithm/hex.hpp>
+#include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/process.hpp>
 
 #include "libaktualizr/config.h"
 #include "package_manager/ostreemanager.h"
 #include "storage/invstorage.h"
+#include "test_utils.h"
+#include "uptane/fetcher.h"
 #include "utilities/utils.h"
 
 boost::filesystem::path test_sysroot;
@@ -213,6 +217,116 @@ TEST(OstreeManager, AddRemoteWithCreds) {
   g_object_unref(repo);
 }
 
+/* Reports a given commit as booted, which the test sysroot never has. */
+class OstreeManagerBooted : public OstreeManager {
+ public:
+  OstreeManagerBooted(const Config &conf, const std::shared_ptr<INvStorage> &storage, std::string booted_rev)
+      : OstreeManager(conf.pacman, conf.bootloader, storage, nullptr), booted_rev_{std::move(booted_rev)} {}
+
+  std::string getCurrentHash() const override { return booted_rev_; }
+
+ private:
+  std::string booted_rev_;
+};
+
+/* Serves a new commit from a treehub server to a copy of the test sysroot that
+ * pretends to have booted the commit deployed in it. */
+class OstreeManagerStaticDelta : public ::testing::Test {
+ protected:
+  OstreeManagerStaticDelta() {
+    int r = system((std::string("cp -r ") + test_sysroot.string() + " " + sysroot_.string()).c_str());
+    EXPECT_EQ(r, 0);
+    booted_rev_ = revParse(sysroot_ / "ostree/repo", "generate-remote/generated");
+
+    const std::string port = TestUtils::getFreePort();
+    treehub_server_ += port;
+    // The log shows which files the pull requested.
+    treehub_process_ = boost::process::child(
+        "tests/sota_tools/treehub_server.py", std::string("-p"), port, std::string("-d"), treehub_dir_.PathString(),
+        std::string("--create"), boost::process::env["PYTHONUNBUFFERED"] = "1",
+        boost::process::std_out > treehub_log_.string());
+    TestUtils::waitForServer(treehub_server_ + "/");
+    new_rev_ = revParse(treehub_dir_.Path(), "master");
+
+    // The server needs the booted commit to generate a delta from it.
+    EXPECT_EQ(std::get<0>(ostree_.run({"pull-local", "--repo", treehub_dir_.PathString(),
+                                       (sysroot_ / "ostree/repo").string(), booted_rev_})),
+              0);
+  }
+
+  std::string revParse(const boost::filesystem::path &repo, const std::string &ref) {
+    EXPECT_EQ(std::get<0>(ostree_.run({"rev-parse", "--repo", repo.string(), ref})), 0);
+    return boost::trim_copy(ostree_.lastStdOut());
+  }
+
+  void updateSummary() {
+    EXPECT_EQ(std::get<0>(ostree_.run({"summary", "--repo", treehub_dir_.PathString(), "-u"})), 0);
+  }
+
+  bool pull() {
+    Config config;
+    config.pacman.type = PACKAGE_MANAGER_OSTREE;
+    config.pacman.sysroot = sysroot_;
+    config.pacman.ostree_server = treehub_server_;
+    config.storage.path = temp_dir_.Path();
+    std::shared_ptr<INvStorage> storage = INvStorage::newStorage(config.storage);
+    KeyManager keys(storage, config.keymanagerConfig());
+    keys.loadKeys();
+    OstreeManagerBooted ostree(config, storage, booted_rev_);
+    Uptane::Fetcher fetcher(config, nullptr);
+
+    Json::Value target_json;
+    target_json["hashes"]["sha256"] = new_rev_;
+    target_json["length"] = 0;
+    target_json["custom"]["targetFormat"] = "OSTREE";
+    return ostree.fetchTarget(Uptane::Target("update", target_json), fetcher, keys, nullptr, nullptr);
+  }
+
+  // The pulled commit is in the repo, and the ref used as the delta base is gone again.
+  void checkPulled() {
+    EXPECT_EQ(std::get<0>(ostree_.run({"show", "--repo", (sysroot_ / "ostree/repo").string(), new_rev_})), 0);
+    EXPECT_EQ(std::get<0>(ostree_.run({"refs", "--repo", (sysroot_ / "ostree/repo").string()})), 0);
+    EXPECT_EQ(ostree_.lastStdOut().find("aktualizr-delta-base"), std::string::npos);
+  }
+
+  std::string treehubLog() const { return Utils::readFile(treehub_log_); }
+
+  Process ostree_{"ostree"};
+  TemporaryDirectory temp_dir_;
+  boost::filesystem::path sysroot_{temp_dir_ / "sysroot"};
+  TemporaryDirectory treehub_dir_;
+  boost::filesystem::path treehub_log_{temp_dir_ / "treehub.log"};
+  std::string treehub_server_{"http://127.0.0.1:"};
+  boost::process::child treehub_process_;
+  std::string booted_rev_;
+  std::string new_rev_;
+};
+
+/* Pull a static delta from the booted commit if the server has one. */
+TEST_F(OstreeManagerStaticDelta, PullDelta) {
+  ASSERT_EQ(std::get<0>(ostree_.run({"static-delta", "generate", "--repo", treehub_dir_.PathString(),
+                                     "--from", booted_rev_, "--to", new_rev_})),
+            0);
+  updateSummary();
+
+  EXPECT_TRUE(pull());
+  checkPulled();
+
+  const std::string log = treehubLog();
+  EXPECT_NE(log.find("GET request /deltas/"), std::string::npos);
+  EXPECT_EQ(log.find(".filez"), std::string::npos);
+}
+
+/* Fall back to fetching objects if the server has no static delta. */
+TEST_F(OstreeManagerStaticDelta, PullWithoutDelta) {
+  updateSummary();
+
+  EXPECT_TRUE(pull());
+  checkPulled();
+
+  EXPECT_NE(treehubLog().find(".filez"), std::string::npos);
+}
+
 #ifndef __NO_MAIN__
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
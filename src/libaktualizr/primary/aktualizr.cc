@@ -5,6 +5,7 @@
 #include "libaktualizr/aktualizr.h"
 #include "libaktualizr/events.h"
 
+#include "event_dispatcher.h"
 #include "sotauptaneclient.h"
 #include "utilities/apiqueue.h"
 #include "utilities/timer.h"
@@ -25,10 +26,24 @@ Aktualizr::Aktualizr(Config config, std::shared_ptr<INvStorage> storage_in,
   storage_ = std::move(storage_in);
   storage_->importData(config_.import);
 
-  uptane_client_ = std::make_shared<SotaUptaneClient>(config_, storage_, http_in, sig_);
+  std::shared_ptr<event::Channel> client_sig = sig_;
+  if (config_.uptane.event_queue_size > 0) {
+    // Let the client emit into a private channel and deliver from the dispatcher thread, so that slow handlers
+    // don't stall downloads and installations.
+    event_dispatcher_ = std_::make_unique<event::AsyncDispatcher>(sig_, config_.uptane.event_queue_size);
+    client_sig = std::make_shared<event::Channel>();
+    event::AsyncDispatcher *dispatcher = event_dispatcher_.get();
+    event_dispatcher_connection_ = client_sig->connect(
+        [dispatcher](std::shared_ptr<event::BaseEvent> event) { dispatcher->post(std::move(event)); });
+  }
+  uptane_client_ = std::make_shared<SotaUptaneClient>(config_, storage_, http_in, client_sig);
 }
 
-Aktualizr::~Aktualizr() { api_queue_.reset(nullptr); }
+Aktualizr::~Aktualizr() {
+  api_queue_.reset(nullptr);
+  event_dispatcher_connection_.disconnect();
+  event_dispatcher_.reset(nullptr);
+}
 
 void Aktualizr::Initialize() {
   uptane_client_->initialize();
@@ -194,6 +209,13 @@ boost::signals2::connection Aktualizr::SetSignalHandler(
   return sig_->connect(handler);
 }
 
+event::DispatcherStats Aktualizr::GetEventDispatcherStats() const {
+  if (event_dispatcher_ == nullptr) {
+    return event::DispatcherStats{};
+  }
+  return event_dispatcher_->stats();
+}
+
 Aktualizr::InstallationLog Aktualizr::GetInstallationLog() {
   std::vector<Aktualizr::InstallationLogEntry> ilog;
 
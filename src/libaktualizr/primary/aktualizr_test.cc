@@ -14,6 +14,8 @@
 #include "libaktualizr/events.h"
 
 #include "httpfake.h"
+#include "libaktualizr/packagemanagerfactory.h"
+#include "package_manager/packagemanagerfake.h"
 #include "primary/aktualizr_helpers.h"
 #include "primary/sotauptaneclient.h"
 #include "uptane_test_common.h"
@@ -204,6 +206,56 @@ TEST(Aktualizr, DeviceInstallationResultMetadata) {
 
 #endif  // FIU_ENABLE
 
+class MetadataFailingSecondary : public Primary::VirtualSecondary {
+ public:
+  explicit MetadataFailingSecondary(Primary::VirtualSecondaryConfig sconfig_in)
+      : Primary::VirtualSecondary(std::move(sconfig_in)) {}
+
+  data::InstallationResult putMetadata(const Uptane::Target& target) override {
+    received.push_back(target.filename());
+    if (target.filename().find("bad") == 0) {
+      return data::InstallationResult(data::ResultCode::Numeric::kVerificationFailed, "Bad target");
+    }
+    return Primary::VirtualSecondary::putMetadata(target);
+  }
+
+  std::vector<std::string> received;
+};
+
+/*
+ * Metadata is sent for every target of a Secondary, even after an earlier
+ * target failed, and each failing (target, ECU) pair is reported.
+ */
+TEST(Aktualizr, DeviceInstallationResultMetadataPerTarget) {
+  TemporaryDirectory temp_dir;
+  auto http = std::make_shared<HttpFake>(temp_dir.Path(), "hasupdates", fake_meta_dir);
+  Config conf = UptaneTestCommon::makeTestConfig(temp_dir, http->tls_server);
+
+  auto storage = INvStorage::newStorage(conf.storage);
+  UptaneTestCommon::TestAktualizr aktualizr(conf, storage, http);
+  auto secondary =
+      std::make_shared<MetadataFailingSecondary>(UptaneTestCommon::altVirtualConfiguration(temp_dir.Path()));
+  aktualizr.AddSecondary(secondary);
+  aktualizr.Initialize();
+  auto update_result = aktualizr.CheckUpdates().get();
+  EXPECT_EQ(update_result.status, result::UpdateStatus::kUpdatesAvailable);
+
+  std::vector<Uptane::Target> targets;
+  for (const std::string name : {"bad1", "good", "bad2"}) {
+    Json::Value target_json;
+    target_json["custom"]["targetFormat"] = "BINARY";
+    target_json["custom"]["ecuIdentifiers"]["ecuserial3"]["hardwareId"] = "hw_id3";
+    targets.emplace_back(Uptane::Target(name, target_json));
+  }
+
+  data::InstallationResult result;
+  aktualizr.uptane_client()->sendMetadataToEcus(targets, &result, nullptr);
+  auto res_json = result.toJson();
+  EXPECT_EQ(res_json["code"].asString(), "hw_id3:VERIFICATION_FAILED|hw_id3:VERIFICATION_FAILED");
+  EXPECT_EQ(res_json["success"], false);
+  EXPECT_EQ(secondary->received, (std::vector<std::string>{"bad1", "good", "bad2"}));
+}
+
 class HttpFakeEventCounter : public HttpFake {
  public:
   HttpFakeEventCounter(const boost::filesystem::path& test_dir_in, const boost::filesystem::path& meta_dir_in)
@@ -1263,6 +1315,72 @@ TEST(Aktualizr, FullMultipleSecondaries) {
   EXPECT_TRUE(manifest["installation_report"]["report"]["items"][1]["result"]["success"].asBool());
 }
 
+/* Counts how often target files are opened. */
+class PackageManagerCountingOpens : public PackageManagerFake {
+ public:
+  using PackageManagerFake::PackageManagerFake;
+  std::ifstream openTargetFile(const Uptane::Target &target) const override {
+    ++opens;
+    return PackageManagerFake::openTargetFile(target);
+  }
+
+  static std::atomic<int> opens;
+};
+std::atomic<int> PackageManagerCountingOpens::opens{0};
+AUTO_REGISTER_PACKAGE_MANAGER("counting_opens", PackageManagerCountingOpens);
+
+/*
+ * The same target sent to two Secondaries at the same time is read once and
+ * installed intact on both.
+ */
+TEST(Aktualizr, SharedTargetMultipleSecondaries) {
+  TemporaryDirectory temp_dir;
+  const boost::filesystem::path local_metadir = temp_dir / "metadir";
+  Utils::createDirectories(local_metadir, S_IRWXU);
+  auto http = std::make_shared<HttpFake>(temp_dir.Path(), "", local_metadir / "repo");
+
+  const boost::filesystem::path image = fake_meta_dir / "fake_meta/secondary_firmware.txt";
+  UptaneRepo repo{local_metadir, "2025-07-04T16:33:27Z", "id0"};
+  repo.generateRepo(KeyType::kED25519);
+  repo.addImage(image, "secondary_firmware.txt", "secondary_hw", "", {});
+  repo.addTarget("secondary_firmware.txt", "secondary_hw", "secondary_ecu_serial", "");
+  repo.addTarget("secondary_firmware.txt", "secondary_hw", "sec_serial2", "");
+  repo.signTargets();
+
+  Config conf = UptaneTestCommon::makeTestConfig(temp_dir, http->tls_server);
+  conf.pacman.type = "counting_opens";
+  auto storage = INvStorage::newStorage(conf.storage);
+  UptaneTestCommon::TestAktualizr aktualizr(conf, storage, http);
+  const boost::filesystem::path firmware1 =
+      Primary::VirtualSecondaryConfig::create_from_file(conf.uptane.secondary_config_file)[0].firmware_path;
+  TemporaryDirectory temp_dir2;
+  const Primary::VirtualSecondaryConfig sec2 =
+      UptaneTestCommon::addDefaultSecondary(conf, temp_dir2, "sec_serial2", "secondary_hw");
+  ASSERT_NO_THROW(aktualizr.AddSecondary(std::make_shared<Primary::VirtualSecondary>(sec2)));
+  aktualizr.Initialize();
+
+  result::UpdateCheck update_result = aktualizr.CheckUpdates().get();
+  ASSERT_EQ(update_result.status, result::UpdateStatus::kUpdatesAvailable);
+  ASSERT_EQ(update_result.ecus_count, 2);
+  result::Download download_result = aktualizr.Download(update_result.updates).get();
+  ASSERT_EQ(download_result.status, result::DownloadStatus::kSuccess);
+  PackageManagerCountingOpens::opens = 0;
+  result::Install install_result = aktualizr.Install(download_result.updates).get();
+  EXPECT_TRUE(install_result.dev_report.isSuccess());
+  ASSERT_EQ(install_result.ecu_reports.size(), 2);
+  for (const auto &report : install_result.ecu_reports) {
+    EXPECT_TRUE(report.install_res.isSuccess());
+  }
+  // The file is opened once to recheck its hash and once more for the read
+  // that both Secondaries share; it would be one more open per Secondary if
+  // each read it on its own.
+  EXPECT_EQ(PackageManagerCountingOpens::opens, 2);
+
+  const std::string content = Utils::readFile(image);
+  EXPECT_EQ(Utils::readFile(firmware1), content);
+  EXPECT_EQ(Utils::readFile(sec2.firmware_path), content);
+}
+
 /*
  * Initialize -> CheckUpdates -> no updates -> no further action or events.
  */
@@ -0,0 +1,97 @@
+#include "event_dispatcher.h"
+
+#include <algorithm>
+
+#include "logging/logging.h"
+
+namespace event {
+
+AsyncDispatcher::AsyncDispatcher(std::shared_ptr<Channel> sink, size_t max_queue_size)
+    : sink_(std::move(sink)), max_queue_size_(max_queue_size > 0 ? max_queue_size : 1) {
+  thread_ = std::thread([this] { run(); });
+}
+
+AsyncDispatcher::~AsyncDispatcher() {
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    shutdown_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+  if (stats_.coalesced != 0 || stats_.dropped != 0) {
+    LOG_DEBUG << "Event dispatcher coalesced " << stats_.coalesced << " and dropped " << stats_.dropped
+              << " progress reports";
+  }
+}
+
+void AsyncDispatcher::post(std::shared_ptr<BaseEvent> event) {
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    stats_.posted++;
+    if (event->isTypeOf<DownloadProgressReport>()) {
+      const auto &report = static_cast<const DownloadProgressReport &>(*event);
+      // Replace a pending report for the same target, as long as no state change is queued after it.
+      for (auto it = queue_.rbegin(); it != queue_.rend() && (*it)->isTypeOf<DownloadProgressReport>(); ++it) {
+        if (static_cast<const DownloadProgressReport &>(**it).target.filename() == report.target.filename()) {
+          *it = std::move(event);
+          stats_.coalesced++;
+          return;
+        }
+      }
+      if (queue_.size() >= max_queue_size_) {
+        stats_.dropped++;
+        return;
+      }
+    } else if (queue_.size() >= max_queue_size_) {
+      // Make room by dropping the oldest progress report, if there is one.
+      for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+        if ((*it)->isTypeOf<DownloadProgressReport>()) {
+          queue_.erase(it);
+          stats_.dropped++;
+          break;
+        }
+      }
+    }
+    queue_.push_back(std::move(event));
+    stats_.max_queue_size = std::max(stats_.max_queue_size, static_cast<uint64_t>(queue_.size()));
+  }
+  cv_.notify_all();
+}
+
+void AsyncDispatcher::flush() {
+  std::unique_lock<std::mutex> lock(m_);
+  idle_cv_.wait(lock, [this] { return (queue_.empty() && !delivering_) || shutdown_; });
+}
+
+DispatcherStats AsyncDispatcher::stats() const {
+  std::lock_guard<std::mutex> lock(m_);
+  return stats_;
+}
+
+void AsyncDispatcher::run() {
+  std::unique_lock<std::mutex> lock(m_);
+  for (;;) {
+    cv_.wait(lock, [this] { return !queue_.empty() || shutdown_; });
+    // Deliver what is still queued before shutting down, so that no state change gets lost.
+    if (queue_.empty()) {
+      break;
+    }
+    std::shared_ptr<BaseEvent> event = std::move(queue_.front());
+    queue_.pop_front();
+    delivering_ = true;
+    lock.unlock();
+    try {
+      (*sink_)(event);
+    } catch (const std::exception &ex) {
+      LOG_ERROR << "Exception in handler for " << event->variant << " event: " << ex.what();
+    }
+    lock.lock();
+    delivering_ = false;
+    if (queue_.empty()) {
+      idle_cv_.notify_all();
+    }
+  }
+  idle_cv_.notify_all();
+}
+
+}  // namespace event
@@ -0,0 +1,56 @@
+#ifndef EVENT_DISPATCHER_H_
+#define EVENT_DISPATCHER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "libaktualizr/events.h"
+
+namespace event {
+
+/**
+ * Delivers events to an event::Channel from a dedicated thread, so that slow
+ * handlers do not hold up the thread that emits them.
+ *
+ * Pending events are kept in a queue of at most max_queue_size entries.
+ * Successive DownloadProgressReport events for the same target are coalesced
+ * into the latest one, and when the queue is full, progress reports are
+ * dropped to make room. Every other event is a state change: these are never
+ * dropped or reordered, even if that means exceeding the limit.
+ */
+class AsyncDispatcher {
+ public:
+  AsyncDispatcher(std::shared_ptr<Channel> sink, size_t max_queue_size);
+  ~AsyncDispatcher();
+  AsyncDispatcher(const AsyncDispatcher &) = delete;
+  AsyncDispatcher &operator=(const AsyncDispatcher &) = delete;
+
+  /** Queue an event for delivery. Never blocks on the handlers. */
+  void post(std::shared_ptr<BaseEvent> event);
+
+  /** Wait until all the queued events have been delivered. */
+  void flush();
+
+  DispatcherStats stats() const;
+
+ private:
+  void run();
+
+  std::shared_ptr<Channel> sink_;
+  const size_t max_queue_size_;
+  std::deque<std::shared_ptr<BaseEvent>> queue_;
+  bool delivering_{false};
+  bool shutdown_{false};
+  DispatcherStats stats_{};
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+  std::condition_variable idle_cv_;
+  std::thread thread_;
+};
+
+}  // namespace event
+
+#endif  // EVENT_DISPATCHER_H_
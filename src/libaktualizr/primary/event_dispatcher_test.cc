@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "event_dispatcher.h"
+
+static Uptane::Target makeTarget(const std::string &name) {
+  Json::Value json;
+  json["hashes"]["sha256"] = "0000";
+  json["length"] = 0;
+  return Uptane::Target(name, json);
+}
+
+/* Handlers are called from the dispatcher thread, and a blocked handler does
+ * not block the thread that posts events. */
+TEST(AsyncDispatcher, DoesNotBlockPoster) {
+  auto sink = std::make_shared<event::Channel>();
+  std::promise<void> unblock;
+  std::shared_future<void> unblocked = unblock.get_future().share();
+  std::vector<std::string> received;
+  sink->connect([&](const std::shared_ptr<event::BaseEvent> &event) {
+    unblocked.wait();
+    received.push_back(event->variant);
+  });
+
+  event::AsyncDispatcher dispatcher(sink, 10);
+  dispatcher.post(std::make_shared<event::SendDeviceDataComplete>());
+  dispatcher.post(std::make_shared<event::PutManifestComplete>(true));
+  unblock.set_value();
+  dispatcher.flush();
+
+  ASSERT_EQ(received.size(), 2);
+  EXPECT_EQ(received[0], std::string(event::SendDeviceDataComplete::TypeName));
+  EXPECT_EQ(received[1], std::string(event::PutManifestComplete::TypeName));
+}
+
+/* Progress reports are coalesced per target and dropped when the queue is
+ * full, but state changes are always delivered, in order. */
+TEST(AsyncDispatcher, CoalesceAndDrop) {
+  auto sink = std::make_shared<event::Channel>();
+  std::promise<void> unblock;
+  std::shared_future<void> unblocked = unblock.get_future().share();
+  std::promise<void> first_delivered;
+  std::vector<std::shared_ptr<event::BaseEvent>> received;
+  sink->connect([&](const std::shared_ptr<event::BaseEvent> &event) {
+    if (received.empty()) {
+      received.push_back(event);
+      first_delivered.set_value();
+      unblocked.wait();
+    } else {
+      received.push_back(event);
+    }
+  });
+
+  event::AsyncDispatcher dispatcher(sink, 3);
+  // Keep the dispatcher busy in the handler while the queue fills up.
+  dispatcher.post(std::make_shared<event::SendDeviceDataComplete>());
+  first_delivered.get_future().wait();
+
+  const Uptane::Target a = makeTarget("a");
+  const Uptane::Target b = makeTarget("b");
+  dispatcher.post(std::make_shared<event::DownloadProgressReport>(a, "Downloading", 10));
+  dispatcher.post(std::make_shared<event::DownloadProgressReport>(b, "Downloading", 10));
+  dispatcher.post(std::make_shared<event::DownloadProgressReport>(a, "Downloading", 20));  // coalesced
+  dispatcher.post(std::make_shared<event::DownloadTargetComplete>(b, true));
+  dispatcher.post(std::make_shared<event::DownloadProgressReport>(a, "Downloading", 30));  // dropped: queue full
+  dispatcher.post(std::make_shared<event::DownloadTargetComplete>(a, true));  // makes room by dropping a progress
+  unblock.set_value();
+  dispatcher.flush();
+
+  ASSERT_EQ(received.size(), 4);
+  EXPECT_TRUE(received[0]->isTypeOf<event::SendDeviceDataComplete>());
+  ASSERT_TRUE(received[1]->isTypeOf<event::DownloadProgressReport>());
+  EXPECT_EQ(std::static_pointer_cast<event::DownloadProgressReport>(received[1])->target.filename(), "b");
+  ASSERT_TRUE(received[2]->isTypeOf<event::DownloadTargetComplete>());
+  EXPECT_EQ(std::static_pointer_cast<event::DownloadTargetComplete>(received[2])->update.filename(), "b");
+  ASSERT_TRUE(received[3]->isTypeOf<event::DownloadTargetComplete>());
+  EXPECT_EQ(std::static_pointer_cast<event::DownloadTargetComplete>(received[3])->update.filename(), "a");
+
+  const event::DispatcherStats stats = dispatcher.stats();
+  EXPECT_EQ(stats.posted, 7);
+  EXPECT_EQ(stats.coalesced, 1);
+  EXPECT_EQ(stats.dropped, 2);
+  EXPECT_EQ(stats.max_queue_size, 3);
+}
+
+#ifndef __NO_MAIN__
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+#endif
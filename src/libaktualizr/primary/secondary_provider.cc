@@ -1,5 +1,9 @@
 #include "libaktualizr/secondary_provider.h"
+
+#include <algorithm>
+
 #include "logging/logging.h"
+#include "primary/shared_target_reader.h"
 #include "storage/invstorage.h"
 #include "uptane/tuf.h"
 
@@ -95,3 +99,51 @@ std::string SecondaryProvider::getTreehubCredentials() const {
 std::ifstream SecondaryProvider::getTargetFileHandle(const Uptane::Target& target) const {
   return package_manager_->openTargetFile(target);
 }
+
+std::unique_ptr<std::istream> SecondaryProvider::getTargetStream(const Uptane::Target& target) const {
+  {
+    std::lock_guard<std::mutex> lock(shared_targets_mutex_);
+    auto shared = shared_targets_.find(target.filename());
+    if (shared != shared_targets_.end()) {
+      std::unique_ptr<std::istream> stream = shared->second->attach();
+      if (stream != nullptr) {
+        return stream;
+      }
+      LOG_DEBUG << "Reading target " << target.filename() << " separately, the shared read is already under way";
+    }
+  }
+  std::unique_ptr<std::ifstream> stream(new std::ifstream(package_manager_->openTargetFile(target)));
+  if (!stream->is_open()) {
+    // A stream that was never opened is good() but empty; make the failure visible to the caller.
+    stream->setstate(std::ios::failbit);
+  }
+  return std::unique_ptr<std::istream>(std::move(stream));
+}
+
+void SecondaryProvider::shareTarget(const Uptane::Target& target) {
+  std::lock_guard<std::mutex> lock(shared_targets_mutex_);
+  if (shared_targets_.count(target.filename()) != 0) {
+    return;
+  }
+  std::ifstream file;
+  try {
+    file = package_manager_->openTargetFile(target);
+  } catch (const std::exception& exc) {
+    LOG_WARNING << "Could not open target " << target.filename() << " for sharing: " << exc.what();
+    return;
+  }
+  // Otherwise every Secondary would get an empty image. Left unshared, each
+  // of them opens the file on its own and reports the error.
+  if (!file.is_open() || !file.good()) {
+    LOG_WARNING << "Could not open target " << target.filename() << " for sharing";
+    return;
+  }
+  const auto capacity = static_cast<size_t>(
+      std::min<uint64_t>(target.length(), static_cast<uint64_t>(SharedTargetReader::kDefaultCapacity)));
+  shared_targets_[target.filename()] = std::make_shared<SharedTargetReader>(std::move(file), capacity);
+}
+
+void SecondaryProvider::unshareTargets() {
+  std::lock_guard<std::mutex> lock(shared_targets_mutex_);
+  shared_targets_.clear();
+}
@@ -0,0 +1,126 @@
+#include "shared_target_reader.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+class SharedTargetReader::StreamBuf : public std::streambuf {
+ public:
+  StreamBuf(std::shared_ptr<SharedTargetReader> reader, int id) : reader_(std::move(reader)), id_(id) {}
+  ~StreamBuf() override { reader_->detach(id_); }
+  StreamBuf(const StreamBuf&) = delete;
+  StreamBuf& operator=(const StreamBuf&) = delete;
+
+ protected:
+  int_type underflow() override {
+    const size_t got = reader_->read(id_, buf_.data(), buf_.size());
+    if (got == 0) {
+      return traits_type::eof();
+    }
+    setg(buf_.data(), buf_.data(), buf_.data() + got);
+    return traits_type::to_int_type(buf_[0]);
+  }
+
+ private:
+  std::shared_ptr<SharedTargetReader> reader_;
+  const int id_;
+  std::array<char, 64 * 1024> buf_{};
+};
+
+class SharedTargetReader::Stream : public std::istream {
+ public:
+  Stream(std::shared_ptr<SharedTargetReader> reader, int id) : std::istream(nullptr), buf_(std::move(reader), id) {
+    rdbuf(&buf_);
+  }
+
+ private:
+  StreamBuf buf_;
+};
+
+constexpr size_t SharedTargetReader::kDefaultCapacity;
+
+SharedTargetReader::SharedTargetReader(std::ifstream file, size_t capacity)
+    : file_(std::move(file)), ring_(std::max<size_t>(capacity, 1)) {
+  eof_ = !file_.good();
+}
+
+std::unique_ptr<std::istream> SharedTargetReader::attach() {
+  int id;
+  if (!attachReceiver(&id)) {
+    return nullptr;
+  }
+  return std::unique_ptr<std::istream>(new Stream(shared_from_this(), id));
+}
+
+uint64_t SharedTargetReader::bytesRead() const {
+  std::lock_guard<std::mutex> lock(m_);
+  return head_;
+}
+
+bool SharedTargetReader::attachReceiver(int* id) {
+  std::lock_guard<std::mutex> lock(m_);
+  if (reserved_ > ring_.size()) {
+    return false;
+  }
+  *id = next_id_++;
+  receivers_[*id] = 0;
+  return true;
+}
+
+size_t SharedTargetReader::read(int id, char* out, size_t size) {
+  std::unique_lock<std::mutex> lock(m_);
+  for (;;) {
+    uint64_t& pos = receivers_[id];
+    if (pos < head_) {
+      // Copy what is available, in up to two pieces if it wraps around the end of the ring.
+      size_t copied = 0;
+      const size_t available = static_cast<size_t>(std::min<uint64_t>(size, head_ - pos));
+      while (copied < available) {
+        const size_t offset = static_cast<size_t>((pos + copied) % ring_.size());
+        const size_t n = std::min(available - copied, ring_.size() - offset);
+        memcpy(out + copied, ring_.data() + offset, n);
+        copied += n;
+      }
+      pos += copied;
+      // This may have made room for the receiver that reads the file.
+      cv_.notify_all();
+      return copied;
+    }
+    if (eof_) {
+      return 0;
+    }
+    const size_t space = ring_.size() - static_cast<size_t>(head_ - slowestPosition());
+    if (space > 0 && reserved_ == head_) {
+      // Only this thread writes past head_, and nobody reads there, so the
+      // file can be read without holding the lock.
+      const size_t offset = static_cast<size_t>(head_ % ring_.size());
+      const size_t n = std::min(space, ring_.size() - offset);
+      reserved_ = head_ + n;
+      lock.unlock();
+      file_.read(ring_.data() + offset, static_cast<std::streamsize>(n));
+      const auto got = static_cast<size_t>(file_.gcount());
+      lock.lock();
+      head_ += got;
+      reserved_ = head_;
+      eof_ = got == 0 || !file_.good();
+      cv_.notify_all();
+      continue;
+    }
+    // Another receiver is reading the file, or the slowest one has not caught up yet.
+    cv_.wait(lock);
+  }
+}
+
+void SharedTargetReader::detach(int id) {
+  std::lock_guard<std::mutex> lock(m_);
+  receivers_.erase(id);
+  cv_.notify_all();
+}
+
+uint64_t SharedTargetReader::slowestPosition() const {
+  uint64_t slowest = head_;
+  for (const auto& receiver : receivers_) {
+    slowest = std::min(slowest, receiver.second);
+  }
+  return slowest;
+}
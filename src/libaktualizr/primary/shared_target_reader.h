@@ -0,0 +1,63 @@
+#ifndef SHARED_TARGET_READER_H_
+#define SHARED_TARGET_READER_H_
+
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Reads a target file once on behalf of several Secondaries that receive the
+ * same image at the same time.
+ *
+ * The data read from the file is kept in a ring buffer, and is only
+ * overwritten once every attached receiver has consumed it. A receiver that
+ * gets ahead of the others by the size of the buffer waits for the slowest
+ * one, so the memory use is bounded and the file is read only once. A receiver
+ * can attach as long as the beginning of the file is still in the buffer;
+ * otherwise it must read the file on its own. Readers must be owned by a
+ * std::shared_ptr, which the streams share.
+ */
+class SharedTargetReader : public std::enable_shared_from_this<SharedTargetReader> {
+ public:
+  static constexpr size_t kDefaultCapacity = 4 * 1024 * 1024;
+
+  explicit SharedTargetReader(std::ifstream file, size_t capacity = kDefaultCapacity);
+  SharedTargetReader(const SharedTargetReader&) = delete;
+  SharedTargetReader& operator=(const SharedTargetReader&) = delete;
+
+  /**
+   * Get a stream over the file that reads from the shared buffer, or nullptr
+   * if the beginning of the file is no longer available.
+   */
+  std::unique_ptr<std::istream> attach();
+
+  /** Number of bytes read from the file so far. */
+  uint64_t bytesRead() const;
+
+ private:
+  class StreamBuf;
+  class Stream;
+
+  bool attachReceiver(int* id);
+  size_t read(int id, char* out, size_t size);
+  void detach(int id);
+  uint64_t slowestPosition() const;
+
+  std::ifstream file_;
+  std::vector<char> ring_;
+  // The last ring_.size() bytes before head_ are in the ring buffer. While the
+  // file is being read, the buffer is filled up to reserved_.
+  uint64_t head_{0};
+  uint64_t reserved_{0};
+  bool eof_{false};
+  // Position of every attached receiver in the file.
+  std::map<int, uint64_t> receivers_;
+  int next_id_{0};
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+};
+
+#endif  // SHARED_TARGET_READER_H_
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "libaktualizr/config.h"
+#include "package_manager/packagemanagerfake.h"
+#include "primary/secondary_provider_builder.h"
+#include "shared_target_reader.h"
+#include "storage/invstorage.h"
+#include "utilities/utils.h"
+
+static std::string makeImage(const boost::filesystem::path &path, size_t size) {
+  std::string content(size, '\0');
+  for (size_t i = 0; i < size; ++i) {
+    content[i] = static_cast<char>(i * 7 + i / 251);
+  }
+  Utils::writeFile(path, content);
+  return content;
+}
+
+static std::string readAll(std::istream &stream) {
+  std::stringstream ss;
+  ss << stream.rdbuf();
+  return ss.str();
+}
+
+/* Receivers reading at the same time all get the whole file, which is read
+ * only once even though it is larger than the buffer. */
+TEST(SharedTargetReader, ReadOnce) {
+  TemporaryDirectory temp_dir;
+  const std::string content = makeImage(temp_dir / "image", 1024 * 1024 + 123);
+  auto reader = std::make_shared<SharedTargetReader>(std::ifstream((temp_dir / "image").c_str()), 64 * 1024);
+
+  std::vector<std::unique_ptr<std::istream>> streams;
+  for (int i = 0; i < 4; ++i) {
+    streams.push_back(reader->attach());
+    ASSERT_NE(streams.back(), nullptr);
+  }
+  std::vector<std::future<std::string>> results;
+  for (auto &stream : streams) {
+    std::istream *s = stream.get();
+    results.push_back(std::async(std::launch::async, [s]() { return readAll(*s); }));
+  }
+  for (auto &result : results) {
+    EXPECT_EQ(result.get(), content);
+  }
+  EXPECT_EQ(reader->bytesRead(), content.size());
+}
+
+/* A receiver that stops reading early does not hold the others back. */
+TEST(SharedTargetReader, EarlyClose) {
+  TemporaryDirectory temp_dir;
+  const std::string content = makeImage(temp_dir / "image", 300 * 1024);
+  auto reader = std::make_shared<SharedTargetReader>(std::ifstream((temp_dir / "image").c_str()), 16 * 1024);
+
+  std::unique_ptr<std::istream> quitter = reader->attach();
+  std::unique_ptr<std::istream> stream = reader->attach();
+  ASSERT_NE(quitter, nullptr);
+  ASSERT_NE(stream, nullptr);
+  std::array<char, 100> buf{};
+  quitter->read(buf.data(), buf.size());
+  EXPECT_EQ(std::string(buf.data(), buf.size()), content.substr(0, buf.size()));
+  quitter.reset();
+
+  EXPECT_EQ(readAll(*stream), content);
+}
+
+/* A receiver can attach after another one has read a file that fits in the
+ * buffer, without reading the file again. */
+TEST(SharedTargetReader, AttachAfterRead) {
+  TemporaryDirectory temp_dir;
+  const std::string content = makeImage(temp_dir / "image", 10 * 1024);
+  auto reader = std::make_shared<SharedTargetReader>(std::ifstream((temp_dir / "image").c_str()), 16 * 1024);
+
+  std::unique_ptr<std::istream> first = reader->attach();
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(readAll(*first), content);
+  first.reset();
+  std::unique_ptr<std::istream> second = reader->attach();
+  ASSERT_NE(second, nullptr);
+  EXPECT_EQ(readAll(*second), content);
+  EXPECT_EQ(reader->bytesRead(), content.size());
+}
+
+/* Once the beginning of the file has been overwritten in the buffer, new
+ * receivers have to read the file on their own. */
+TEST(SharedTargetReader, LateAttach) {
+  TemporaryDirectory temp_dir;
+  const std::string content = makeImage(temp_dir / "image", 100 * 1024);
+  auto reader = std::make_shared<SharedTargetReader>(std::ifstream((temp_dir / "image").c_str()), 16 * 1024);
+
+  std::unique_ptr<std::istream> stream = reader->attach();
+  ASSERT_NE(stream, nullptr);
+  EXPECT_EQ(readAll(*stream), content);
+  EXPECT_EQ(reader->attach(), nullptr);
+}
+
+class PackageManagerUnopened : public PackageManagerFake {
+ public:
+  using PackageManagerFake::PackageManagerFake;
+  std::ifstream openTargetFile(const Uptane::Target &target) const override {
+    (void)target;
+    return std::ifstream();
+  }
+};
+
+/* A target file that could not be opened is not shared, and its stream fails
+ * instead of looking like an empty image. */
+TEST(SharedTargetReader, ProviderUnopenedFile) {
+  TemporaryDirectory temp_dir;
+  Config config;
+  config.storage.path = temp_dir.Path();
+  config.pacman.images_path = temp_dir / "images";
+  std::shared_ptr<INvStorage> storage = INvStorage::newStorage(config.storage);
+  auto pacman = std::make_shared<PackageManagerUnopened>(config.pacman, config.bootloader, storage, nullptr);
+  std::shared_ptr<SecondaryProvider> provider = SecondaryProviderBuilder::Build(config, storage, pacman);
+
+  Json::Value target_json;
+  target_json["hashes"]["sha256"] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+  target_json["length"] = 10;
+  const Uptane::Target target("image", target_json);
+
+  provider->shareTarget(target);
+  std::unique_ptr<std::istream> stream = provider->getTargetStream(target);
+  ASSERT_NE(stream, nullptr);
+  EXPECT_FALSE(stream->good());
+  provider->unshareTargets();
+}
+
+#ifndef __NO_MAIN__
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+#endif
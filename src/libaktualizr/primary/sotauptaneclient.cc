@@ -1,10 +1,14 @@
 #include "sotauptaneclient.h"
 
-#include <fnmatch.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <map>
 #include <memory>
 #include <utility>
 
+#include <boost/algorithm/string.hpp>
+
 #include "crypto/crypto.h"
 #include "crypto/keymanager.h"
 #include "initializer.h"
@@ -14,6 +18,7 @@
 
 #include "utilities/fault_injection.h"
 #include "utilities/utils.h"
+#include "utilities/worker_pool.h"
 
 static void report_progress_cb(event::Channel *channel, const Uptane::Target &target, const std::string &description,
                                unsigned int progress) {
@@ -342,9 +347,18 @@ Json::Value SotaUptaneClient::AssembleManifest() {
 
 bool SotaUptaneClient::hasPendingUpdates() const { return storage->hasPendingInstall(); }
 
+std::shared_ptr<KeyManager> SotaUptaneClient::keyManager() {
+  // Shared for the lifetime of the client, so that the TLS credentials are not
+  // reloaded (and possibly rewritten to disk) for every target.
+  if (key_manager_ == nullptr) {
+    key_manager_ = std::make_shared<KeyManager>(storage, config.keymanagerConfig());
+  }
+  return key_manager_;
+}
+
 void SotaUptaneClient::initialize() {
   LOG_DEBUG << "Checking if device is provisioned...";
-  auto keys = std::make_shared<KeyManager>(storage, config.keymanagerConfig());
+  auto keys = keyManager();
 
   Initializer initializer(config.provision, storage, http, *keys, secondaries);
 
@@ -495,11 +509,15 @@ void SotaUptaneClient::computeDeviceInstallationResult(data::InstallationResult
 }
 
 void SotaUptaneClient::getNewTargets(std::vector<Uptane::Target> *new_targets, unsigned int *ecus_count) {
-  const std::vector<Uptane::Target> targets = director_repo.getTargets().targets;
+  const std::vector<Uptane::Target> targets = director_repo.getTargets().targets();
   const Uptane::EcuSerial primary_ecu_serial = primaryEcuSerial();
   if (ecus_count != nullptr) {
     *ecus_count = 0;
   }
+  // Read the installed versions of all ECUs at once rather than once per ECU
+  // of every Target.
+  std::map<Uptane::EcuSerial, InstalledVersions> installed_versions;
+  const bool versions_loaded = storage->loadAllInstalledVersions(&installed_versions);
   for (const Uptane::Target &target : targets) {
     bool is_new = false;
     for (const auto &ecu : target.ecus()) {
@@ -524,11 +542,15 @@ void SotaUptaneClient::getNewTargets(std::vector<Uptane::Target> *new_targets, u
         throw Uptane::BadHardwareId(target.filename());
       }
 
-      boost::optional<Uptane::Target> current_version;
-      if (!storage->loadInstalledVersions(ecu_serial.ToString(), &current_version, nullptr)) {
+      if (!versions_loaded) {
         LOG_WARNING << "Could not load currently installed version for ECU ID: " << ecu_serial.ToString();
         break;
       }
+      boost::optional<Uptane::Target> current_version;
+      const auto installed = installed_versions.find(ecu_serial);
+      if (installed != installed_versions.end()) {
+        current_version = installed->second.current;
+      }
 
       if (!current_version) {
         LOG_WARNING << "Current version for ECU ID: " << ecu_serial.ToString() << " is unknown";
@@ -567,39 +589,21 @@ std::unique_ptr<Uptane::Target> SotaUptaneClient::findTargetHelper(const Uptane:
                                                                    const Uptane::Target &queried_target,
                                                                    const int level, const bool terminating,
                                                                    const bool offline) {
-  TargetCompare target_comp(queried_target);
-  const auto it = std::find_if(cur_targets.targets.cbegin(), cur_targets.targets.cend(), target_comp);
-  if (it != cur_targets.targets.cend()) {
-    return std_::make_unique<Uptane::Target>(*it);
+  const Uptane::Target *found = cur_targets.findTarget(queried_target);
+  if (found != nullptr) {
+    return std_::make_unique<Uptane::Target>(*found);
   }
 
   if (terminating || level >= Uptane::kDelegationsMaxDepth) {
     return std::unique_ptr<Uptane::Target>(nullptr);
   }
 
-  for (const auto &delegate_name : cur_targets.delegated_role_names_) {
+  // Only the delegations with a path pattern that matches the target name.
+  for (const auto &delegate_name : cur_targets.matchingDelegations(queried_target.filename())) {
     Uptane::Role delegate_role = Uptane::Role::Delegation(delegate_name);
-    auto patterns = cur_targets.paths_for_role_.find(delegate_role);
-    if (patterns == cur_targets.paths_for_role_.end()) {
-      continue;
-    }
-
-    bool match = false;
-    for (const auto &pattern : patterns->second) {
-      if (fnmatch(pattern.c_str(), queried_target.filename().c_str(), 0) == 0) {
-        match = true;
-        break;
-      }
-    }
-    if (!match) {
-      continue;
-    }
-
-    // Target name matches one of the patterns
-
     auto delegation =
         Uptane::getTrustedDelegation(delegate_role, cur_targets, image_repo, *storage, *uptane_fetcher, offline);
-    if (delegation.isExpired(TimeStamp::Now())) {
+    if (delegation->isExpired(TimeStamp::Now())) {
       continue;
     }
 
@@ -608,7 +612,7 @@ std::unique_ptr<Uptane::Target> SotaUptaneClient::findTargetHelper(const Uptane:
       throw Uptane::Exception("image", "Inconsistent delegations");
     }
 
-    auto found_target = findTargetHelper(delegation, queried_target, level + 1, is_terminating->second, offline);
+    auto found_target = findTargetHelper(*delegation, queried_target, level + 1, is_terminating->second, offline);
     if (found_target != nullptr) {
       return found_target;
     }
@@ -705,7 +709,7 @@ std::pair<bool, Uptane::Target> SotaUptaneClient::downloadImage(const Uptane::Ta
 
   bool success = false;
   try {
-    KeyManager keys(storage, config.keymanagerConfig());
+    KeyManager &keys = *keyManager();
     keys.loadKeys();
     auto prog_cb = [this](const Uptane::Target &t, const std::string &description, unsigned int progress) {
       report_progress_cb(events_channel.get(), t, description, progress);
@@ -1180,10 +1184,6 @@ bool SotaUptaneClient::waitSecondariesReachable(const std::vector<Uptane::Target
 
   auto deadline = std::chrono::system_clock::now() + std::chrono::seconds(config.uptane.secondary_preinstall_wait_sec);
   while (std::chrono::system_clock::now() <= deadline) {
-    if (targeted_secondaries.empty()) {
-      return true;
-    }
-
     for (auto sec_it = targeted_secondaries.begin(); sec_it != targeted_secondaries.end();) {
       bool connected = false;
       try {
@@ -1197,6 +1197,9 @@ bool SotaUptaneClient::waitSecondariesReachable(const std::vector<Uptane::Target
         sec_it++;
       }
     }
+    if (targeted_secondaries.empty()) {
+      return true;
+    }
     std::this_thread::sleep_for(std::chrono::seconds(1));
   }
 
@@ -1235,6 +1238,8 @@ data::InstallationResult SotaUptaneClient::rotateSecondaryRoot(Uptane::Repositor
       if (!storage->loadRoot(&root, repo, Uptane::Version(v))) {
         LOG_WARNING << "Couldn't find Root metadata in the storage, trying remote repo";
         try {
+          // Secondaries are handled in parallel, but the fetcher is not thread-safe.
+          std::lock_guard<std::mutex> guard(root_fetch_mutex);
           uptane_fetcher->fetchRole(&root, Uptane::kMaxRootSize, repo, Uptane::Role::Root(), Uptane::Version(v));
         } catch (const std::exception &e) {
           // TODO(OTA-4552): looks problematic, robust procedure needs to be defined
@@ -1264,40 +1269,70 @@ void SotaUptaneClient::sendMetadataToEcus(const std::vector<Uptane::Target> &tar
                                           std::string *raw_installation_report) {
   data::InstallationResult final_result{data::ResultCode::Numeric::kOk, ""};
   std::string result_code_err_str;
+
+  // Secondaries are updated in parallel, but the metadata for the targets of
+  // a given Secondary is sent in order, each time after rotating its Roots.
+  // Every (target, ECU) pair is processed and reported on its own, in the
+  // order of the targets, even if an earlier target of the same ECU failed.
+  struct MetadataJob {
+    const Uptane::Target *target;
+    Uptane::HardwareIdentifier hw_id;
+    data::InstallationResult result;
+  };
+  std::vector<MetadataJob> jobs;
+  std::vector<std::pair<SecondaryInterface *, std::vector<size_t>>> jobs_per_secondary;
+  std::map<Uptane::EcuSerial, size_t> secondary_index;
   for (const auto &target : targets) {
     for (const auto &ecu : target.ecus()) {
-      const Uptane::EcuSerial ecu_serial = ecu.first;
-      const Uptane::HardwareIdentifier hw_id = ecu.second;
-      auto sec = secondaries.find(ecu_serial);
+      auto sec = secondaries.find(ecu.first);
       if (sec == secondaries.end()) {
         continue;
       }
+      auto inserted = secondary_index.emplace(ecu.first, jobs_per_secondary.size());
+      if (inserted.second) {
+        jobs_per_secondary.emplace_back(sec->second.get(), std::vector<size_t>());
+      }
+      jobs_per_secondary[inserted.first->second].second.push_back(jobs.size());
+      jobs.push_back(MetadataJob{&target, ecu.second, data::InstallationResult(data::ResultCode::Numeric::kOk, "")});
+    }
+  }
 
-      data::InstallationResult local_result{data::ResultCode::Numeric::kOk, ""};
-      do {
-        /* Root rotation if necessary */
-        local_result = rotateSecondaryRoot(Uptane::RepositoryType::Director(), *(sec->second));
-        if (!local_result.isSuccess()) {
-          final_result = local_result;
-          break;
-        }
-        local_result = rotateSecondaryRoot(Uptane::RepositoryType::Image(), *(sec->second));
-        if (!local_result.isSuccess()) {
-          final_result = local_result;
-          break;
-        }
-        try {
-          local_result = sec->second->putMetadata(target);
-        } catch (const std::exception &ex) {
-          local_result = data::InstallationResult(data::ResultCode::Numeric::kInternalError, ex.what());
+  WorkerPool pool(config.uptane.secondary_metadata_concurrency);
+  for (const auto &sec_jobs : jobs_per_secondary) {
+    SecondaryInterface *secondary = sec_jobs.first;
+    const std::vector<size_t> *indices = &sec_jobs.second;
+    pool.add([this, secondary, indices, &jobs]() {
+      for (const size_t index : *indices) {
+        MetadataJob &job = jobs[index];
+        do {
+          /* Root rotation if necessary */
+          job.result = rotateSecondaryRoot(Uptane::RepositoryType::Director(), *secondary);
+          if (!job.result.isSuccess()) {
+            break;
+          }
+          job.result = rotateSecondaryRoot(Uptane::RepositoryType::Image(), *secondary);
+          if (!job.result.isSuccess()) {
+            break;
+          }
+          try {
+            job.result = secondary->putMetadata(*job.target);
+          } catch (const std::exception &ex) {
+            job.result = data::InstallationResult(data::ResultCode::Numeric::kInternalError, ex.what());
+          }
+        } while (false);
+        if (!job.result.isSuccess()) {
+          LOG_ERROR << "Sending metadata to " << secondary->getSerial() << " failed: " << job.result.result_code << " "
+                    << job.result.description;
         }
-      } while (false);
-      if (!local_result.isSuccess()) {
-        LOG_ERROR << "Sending metadata to " << sec->first << " failed: " << local_result.result_code << " "
-                  << local_result.description;
-        const std::string ecu_code_str = hw_id.ToString() + ":" + local_result.result_code.toString();
-        result_code_err_str += (!result_code_err_str.empty() ? "|" : "") + ecu_code_str;
       }
+    });
+  }
+  pool.run();
+
+  for (const auto &job : jobs) {
+    if (!job.result.isSuccess()) {
+      const std::string ecu_code_str = job.hw_id.ToString() + ":" + job.result.result_code.toString();
+      result_code_err_str += (!result_code_err_str.empty() ? "|" : "") + ecu_code_str;
     }
   }
 
@@ -1316,41 +1351,97 @@ void SotaUptaneClient::sendMetadataToEcus(const std::vector<Uptane::Target> &tar
   }
 }
 
-std::future<data::InstallationResult> SotaUptaneClient::sendFirmwareAsync(SecondaryInterface &secondary,
-                                                                          const Uptane::Target &target) {
-  auto f = [this, &secondary, target]() {
-    const std::string &correlation_id = director_repo.getCorrelationId();
+data::InstallationResult SotaUptaneClient::sendFirmwareToSecondary(SecondaryInterface &secondary,
+                                                                   const Uptane::Target &target) {
+  const std::string &correlation_id = director_repo.getCorrelationId();
 
-    sendEvent<event::InstallStarted>(secondary.getSerial());
-    report_queue->enqueue(std_::make_unique<EcuInstallationStartedReport>(secondary.getSerial(), correlation_id));
+  sendEvent<event::InstallStarted>(secondary.getSerial());
+  report_queue->enqueue(std_::make_unique<EcuInstallationStartedReport>(secondary.getSerial(), correlation_id));
 
-    data::InstallationResult result;
-    try {
-      result = secondary.sendFirmware(target);
-      if (result.isSuccess()) {
-        result = secondary.install(target);
-      }
-    } catch (const std::exception &ex) {
-      result = data::InstallationResult(data::ResultCode::Numeric::kInternalError, ex.what());
+  data::InstallationResult result;
+  try {
+    result = secondary.sendFirmware(target);
+    if (result.isSuccess()) {
+      result = secondary.install(target);
     }
+  } catch (const std::exception &ex) {
+    result = data::InstallationResult(data::ResultCode::Numeric::kInternalError, ex.what());
+  }
 
-    if (result.result_code == data::ResultCode::Numeric::kNeedCompletion) {
-      report_queue->enqueue(std_::make_unique<EcuInstallationAppliedReport>(secondary.getSerial(), correlation_id));
-    } else {
-      report_queue->enqueue(
-          std_::make_unique<EcuInstallationCompletedReport>(secondary.getSerial(), correlation_id, result.isSuccess()));
+  if (result.result_code == data::ResultCode::Numeric::kNeedCompletion) {
+    report_queue->enqueue(std_::make_unique<EcuInstallationAppliedReport>(secondary.getSerial(), correlation_id));
+  } else {
+    report_queue->enqueue(
+        std_::make_unique<EcuInstallationCompletedReport>(secondary.getSerial(), correlation_id, result.isSuccess()));
+  }
+
+  sendEvent<event::InstallTargetComplete>(secondary.getSerial(), result.isSuccess());
+  return result;
+}
+
+/* Parse "type:limit,type:limit" as found in uptane.secondary_type_concurrency. */
+std::map<std::string, size_t> SotaUptaneClient::parseTypeLimits(const std::string &spec) {
+  std::map<std::string, size_t> limits;
+  std::vector<std::string> entries;
+  boost::split(entries, spec, boost::is_any_of(","), boost::token_compress_on);
+  for (auto &entry : entries) {
+    boost::trim(entry);
+    if (entry.empty()) {
+      continue;
     }
+    const size_t colon = entry.rfind(':');
+    try {
+      if (colon == std::string::npos) {
+        throw std::invalid_argument("missing limit");
+      }
+      const std::string type = boost::trim_copy(entry.substr(0, colon));
+      const std::string limit = boost::trim_copy(entry.substr(colon + 1));
+      // std::stoul() alone would accept "-1" or "4x".
+      if (type.empty() || limit.empty() || !std::all_of(limit.cbegin(), limit.cend(), ::isdigit)) {
+        throw std::invalid_argument("invalid type or limit");
+      }
+      const size_t value = std::stoul(limit);
+      limits[type] = value;
+    } catch (const std::exception &) {
+      LOG_WARNING << "Ignoring invalid Secondary concurrency limit \"" << entry << "\"";
+    }
+  }
+  return limits;
+}
 
-    sendEvent<event::InstallTargetComplete>(secondary.getSerial(), result.isSuccess());
-    return result;
+/* Order in which the installations of the reports are started: those on the
+ * critical ECUs first, then optionally the largest images first. The order of
+ * the reports is kept otherwise. */
+std::vector<size_t> SotaUptaneClient::secondaryInstallOrder(const std::vector<result::Install::EcuReport> &reports,
+                                                            const std::string &install_order,
+                                                            const std::string &critical_ecus) {
+  std::vector<std::string> critical;
+  boost::split(critical, critical_ecus, boost::is_any_of(", "), boost::token_compress_on);
+  const bool largest_first = install_order == "largest_first";
+  if (!largest_first && install_order != "default") {
+    LOG_WARNING << "Unknown Secondary installation order \"" << install_order << "\", using the default";
+  }
+  auto is_critical = [&critical](const Uptane::EcuSerial &serial) {
+    return std::find(critical.cbegin(), critical.cend(), serial.ToString()) != critical.cend();
   };
-
-  return std::async(std::launch::async, f);
+  std::vector<size_t> order(reports.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&reports, &is_critical, largest_first](size_t a, size_t b) {
+    const bool a_critical = is_critical(reports[a].serial);
+    const bool b_critical = is_critical(reports[b].serial);
+    if (a_critical != b_critical) {
+      return a_critical;
+    }
+    return largest_first && reports[a].update.length() > reports[b].update.length();
+  });
+  return order;
 }
 
 std::vector<result::Install::EcuReport> SotaUptaneClient::sendImagesToEcus(const std::vector<Uptane::Target> &targets) {
   std::vector<result::Install::EcuReport> reports;
-  std::vector<std::pair<result::Install::EcuReport, std::future<data::InstallationResult>>> firmwareFutures;
+  std::vector<SecondaryInterface *> report_secondaries;
 
   const Uptane::EcuSerial &primary_ecu_serial = primaryEcuSerial();
   // target images should already have been downloaded to metadata_path/targets/
@@ -1368,25 +1459,53 @@ std::vector<result::Install::EcuReport> SotaUptaneClient::sendImagesToEcus(const
         continue;
       }
 
-      SecondaryInterface &sec = *f->second;
-      firmwareFutures.emplace_back(result::Install::EcuReport(*targets_it, ecu_serial, data::InstallationResult()),
-                                   sendFirmwareAsync(sec, *targets_it));
+      reports.emplace_back(*targets_it, ecu_serial, data::InstallationResult());
+      report_secondaries.push_back(f->second.get());
     }
   }
 
-  for (auto &f : firmwareFutures) {
-    data::InstallationResult fut_result = f.second.get();
+  const std::vector<size_t> order =
+      secondaryInstallOrder(reports, config.uptane.secondary_install_order, config.uptane.secondary_critical_ecus);
+
+  // Read an image only once when it is sent to several Secondaries.
+  std::map<std::string, size_t> receivers;
+  for (const auto &report : reports) {
+    if (!report.update.IsOstree() && ++receivers[report.update.filename()] == 2) {
+      LOG_DEBUG << "Sharing the reads of target " << report.update.filename() << " between Secondaries";
+      secondary_provider_->shareTarget(report.update);
+    }
+  }
+
+  const uint64_t concurrency = config.uptane.secondary_install_concurrency;
+  WorkerPool pool(concurrency > 0 ? concurrency : reports.size());
+  for (const auto &limit : parseTypeLimits(config.uptane.secondary_type_concurrency)) {
+    pool.setGroupLimit(limit.first, limit.second);
+  }
+  for (const size_t i : order) {
+    SecondaryInterface &sec = *report_secondaries[i];
+    result::Install::EcuReport &report = reports[i];
+    pool.add([this, &sec, &report]() { report.install_res = sendFirmwareToSecondary(sec, report.update); },
+             sec.Type());
+  }
+  const std::vector<WorkerPool::JobTimes> times = pool.run();
+  secondary_provider_->unshareTargets();
+  for (size_t k = 0; k < order.size(); ++k) {
+    reports[order[k]].queue_time = times[k].queued;
+    reports[order[k]].active_time = times[k].active;
+  }
 
-    if (fut_result.isSuccess() || fut_result.result_code == data::ResultCode::Numeric::kNeedCompletion) {
-      f.first.update.setCorrelationId(director_repo.getCorrelationId());
+  for (auto &report : reports) {
+    LOG_DEBUG << "Installation on " << report.serial << " waited " << report.queue_time.count() << " ms and took "
+              << report.active_time.count() << " ms";
+    if (report.install_res.isSuccess() ||
+        report.install_res.result_code == data::ResultCode::Numeric::kNeedCompletion) {
+      report.update.setCorrelationId(director_repo.getCorrelationId());
       auto update_mode =
-          fut_result.isSuccess() ? InstalledVersionUpdateMode::kCurrent : InstalledVersionUpdateMode::kPending;
-      storage->saveInstalledVersion(f.first.serial.ToString(), f.first.update, update_mode);
+          report.install_res.isSuccess() ? InstalledVersionUpdateMode::kCurrent : InstalledVersionUpdateMode::kPending;
+      storage->saveInstalledVersion(report.serial.ToString(), report.update, update_mode);
     }
 
-    f.first.install_res = fut_result;
-    storage->saveEcuInstallationResult(f.first.serial, f.first.install_res);
-    reports.push_back(f.first);
+    storage->saveEcuInstallationResult(report.serial, report.install_res);
   }
   return reports;
 }
@@ -108,6 +108,7 @@ class SotaUptaneClient {
   FRIEND_TEST(Aktualizr, FullNoUpdates);
   FRIEND_TEST(Aktualizr, DeviceInstallationResult);
   FRIEND_TEST(Aktualizr, DeviceInstallationResultMetadata);
+  FRIEND_TEST(Aktualizr, DeviceInstallationResultMetadataPerTarget);
   FRIEND_TEST(Aktualizr, FullMultipleSecondaries);
   FRIEND_TEST(Aktualizr, CheckNoUpdates);
   FRIEND_TEST(Aktualizr, DownloadWithUpdates);
@@ -125,6 +126,8 @@ class SotaUptaneClient {
   FRIEND_TEST(Uptane, offlineIteration);
   FRIEND_TEST(Uptane, IgnoreUnknownUpdate);
   FRIEND_TEST(Uptane, kRejectAllTest);
+  FRIEND_TEST(Uptane, ParseTypeLimits);
+  FRIEND_TEST(Uptane, SecondaryInstallOrder);
   FRIEND_TEST(UptaneCI, ProvisionAndPutManifest);
   FRIEND_TEST(UptaneCI, CheckKeys);
   FRIEND_TEST(UptaneKey, Check);  // Note hacky name
@@ -153,8 +156,11 @@ class SotaUptaneClient {
   data::InstallationResult rotateSecondaryRoot(Uptane::RepositoryType repo, SecondaryInterface &secondary);
   void sendMetadataToEcus(const std::vector<Uptane::Target> &targets, data::InstallationResult *result,
                           std::string *raw_installation_report);
-  std::future<data::InstallationResult> sendFirmwareAsync(SecondaryInterface &secondary, const Uptane::Target &target);
+  data::InstallationResult sendFirmwareToSecondary(SecondaryInterface &secondary, const Uptane::Target &target);
   std::vector<result::Install::EcuReport> sendImagesToEcus(const std::vector<Uptane::Target> &targets);
+  static std::map<std::string, size_t> parseTypeLimits(const std::string &spec);
+  static std::vector<size_t> secondaryInstallOrder(const std::vector<result::Install::EcuReport> &reports,
+                                                   const std::string &install_order, const std::string &critical_ecus);
 
   bool putManifestSimple(const Json::Value &custom = Json::nullValue);
   void getNewTargets(std::vector<Uptane::Target> *new_targets, unsigned int *ecus_count = nullptr);
@@ -167,6 +173,7 @@ class SotaUptaneClient {
                                                    bool offline);
   void checkAndUpdatePendingSecondaries();
   const Uptane::EcuSerial &primaryEcuSerial() const { return primary_ecu_serial_; }
+  std::shared_ptr<KeyManager> keyManager();
   boost::optional<Uptane::HardwareIdentifier> getEcuHwId(const Uptane::EcuSerial &serial) const;
 
   template <class T, class... Args>
@@ -184,6 +191,7 @@ class SotaUptaneClient {
   Uptane::ImageRepository image_repo;
   Uptane::ManifestIssuer::Ptr uptane_manifest;
   std::shared_ptr<INvStorage> storage;
+  std::shared_ptr<KeyManager> key_manager_;
   std::shared_ptr<HttpInterface> http;
   std::shared_ptr<PackageManagerInterface> package_manager_;
   std::shared_ptr<Uptane::Fetcher> uptane_fetcher;
@@ -195,6 +203,7 @@ class SotaUptaneClient {
   // ecu_serial => secondary*
   std::map<Uptane::EcuSerial, SecondaryInterface::Ptr> secondaries;
   std::mutex download_mutex;
+  std::mutex root_fetch_mutex;
   Uptane::EcuSerial primary_ecu_serial_;
   Uptane::HardwareIdentifier primary_ecu_hw_id_;
 };
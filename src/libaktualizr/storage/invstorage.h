@@ -1,6 +1,7 @@
 #ifndef INVSTORAGE_H_
 #define INVSTORAGE_H_
 
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -36,6 +37,11 @@ struct MisconfiguredEcu {
 
 enum class InstalledVersionUpdateMode { kNone, kCurrent, kPending };
 
+struct InstalledVersions {
+  boost::optional<Uptane::Target> current;
+  boost::optional<Uptane::Target> pending;
+};
+
 // Functions loading/storing multiple pieces of data are supposed to do so
 // atomically as far as implementation makes it possible.
 //
@@ -109,6 +115,8 @@ class INvStorage {
                                     InstalledVersionUpdateMode update_mode) = 0;
   virtual bool loadInstalledVersions(const std::string& ecu_serial, boost::optional<Uptane::Target>* current_version,
                                      boost::optional<Uptane::Target>* pending_version) const = 0;
+  // Current and pending versions of all the ECUs with any, in a single read.
+  virtual bool loadAllInstalledVersions(std::map<Uptane::EcuSerial, InstalledVersions>* versions) const = 0;
   virtual bool loadInstallationLog(const std::string& ecu_serial, std::vector<Uptane::Target>* log,
                                    bool only_installed) const = 0;
   virtual bool hasPendingInstall() = 0;
@@ -1174,6 +1174,42 @@ static void loadEcuMap(SQLite3Guard& db, std::string& ecu_serial, Uptane::EcuMap
   }
 }
 
+// Reads a version from six consecutive columns of an installed_versions query,
+// starting at first_col: sha256, name, hashes, length, correlation_id and
+// custom_meta.
+static Uptane::Target readInstalledVersion(SQLiteStatement& statement, int first_col, const Uptane::EcuMap& ecu_map) {
+  auto sha256 = statement.get_result_col_str(first_col).value();
+  auto filename = statement.get_result_col_str(first_col + 1).value();
+  auto hashes_str = statement.get_result_col_str(first_col + 2).value();
+  auto length = statement.get_result_col_int(first_col + 3);
+  auto correlation_id = statement.get_result_col_str(first_col + 4).value();
+  auto custom_str = statement.get_result_col_str(first_col + 5).value();
+
+  // note: sha256 should always be present and is used to uniquely identify
+  // a version. It should normally be part of the hash list as well.
+  std::vector<Hash> hashes = Hash::decodeVector(hashes_str);
+
+  auto find_sha256 =
+      std::find_if(hashes.cbegin(), hashes.cend(), [](const Hash& h) { return h.type() == Hash::Type::kSha256; });
+  if (find_sha256 == hashes.cend()) {
+    LOG_WARNING << "No sha256 in hashes list";
+    hashes.emplace_back(Hash::Type::kSha256, sha256);
+  }
+  Uptane::Target t(filename, ecu_map, hashes, static_cast<uint64_t>(length), correlation_id);
+  if (!custom_str.empty()) {
+    std::istringstream css(custom_str);
+    Json::Value custom;
+    std::string errs;
+    if (Json::parseFromStream(Json::CharReaderBuilder(), css, &custom, &errs)) {
+      t.updateCustom(custom);
+    } else {
+      LOG_ERROR << "Unable to parse custom data: " << errs;
+    }
+  }
+
+  return t;
+}
+
 bool SQLStorage::loadInstallationLog(const std::string& ecu_serial, std::vector<Uptane::Target>* log,
                                      bool only_installed) const {
   SQLite3Guard db = dbConnection();
@@ -1261,39 +1297,6 @@ bool SQLStorage::loadInstalledVersions(const std::string& ecu_serial, boost::opt
   Uptane::EcuMap ecu_map;
   loadEcuMap(db, ecu_serial_real, ecu_map);
 
-  auto read_target = [&ecu_map](SQLiteStatement& statement) -> Uptane::Target {
-    auto sha256 = statement.get_result_col_str(0).value();
-    auto filename = statement.get_result_col_str(1).value();
-    auto hashes_str = statement.get_result_col_str(2).value();
-    auto length = statement.get_result_col_int(3);
-    auto correlation_id = statement.get_result_col_str(4).value();
-    auto custom_str = statement.get_result_col_str(5).value();
-
-    // note: sha256 should always be present and is used to uniquely identify
-    // a version. It should normally be part of the hash list as well.
-    std::vector<Hash> hashes = Hash::decodeVector(hashes_str);
-
-    auto find_sha256 =
-        std::find_if(hashes.cbegin(), hashes.cend(), [](const Hash& h) { return h.type() == Hash::Type::kSha256; });
-    if (find_sha256 == hashes.cend()) {
-      LOG_WARNING << "No sha256 in hashes list";
-      hashes.emplace_back(Hash::Type::kSha256, sha256);
-    }
-    Uptane::Target t(filename, ecu_map, hashes, static_cast<uint64_t>(length), correlation_id);
-    if (!custom_str.empty()) {
-      std::istringstream css(custom_str);
-      Json::Value custom;
-      std::string errs;
-      if (Json::parseFromStream(Json::CharReaderBuilder(), css, &custom, &errs)) {
-        t.updateCustom(custom);
-      } else {
-        LOG_ERROR << "Unable to parse custom data: " << errs;
-      }
-    }
-
-    return t;
-  };
-
   if (current_version != nullptr) {
     auto statement = db.prepareStatement<std::string>(
         "SELECT sha256, name, hashes, length, correlation_id, custom_meta FROM installed_versions WHERE "
@@ -1302,7 +1305,7 @@ bool SQLStorage::loadInstalledVersions(const std::string& ecu_serial, boost::opt
 
     if (statement.step() == SQLITE_ROW) {
       try {
-        *current_version = read_target(statement);
+        *current_version = readInstalledVersion(statement, 0, ecu_map);
       } catch (const boost::bad_optional_access&) {
         LOG_ERROR << "Could not read current installed version";
         return false;
@@ -1321,7 +1324,7 @@ bool SQLStorage::loadInstalledVersions(const std::string& ecu_serial, boost::opt
 
     if (statement.step() == SQLITE_ROW) {
       try {
-        *pending_version = read_target(statement);
+        *pending_version = readInstalledVersion(statement, 0, ecu_map);
       } catch (const boost::bad_optional_access&) {
         LOG_ERROR << "Could not read pending installed version";
         return false;
@@ -1335,6 +1338,52 @@ bool SQLStorage::loadInstalledVersions(const std::string& ecu_serial, boost::opt
   return true;
 }
 
+bool SQLStorage::loadAllInstalledVersions(std::map<Uptane::EcuSerial, InstalledVersions>* versions) const {
+  SQLite3Guard db = dbConnection();
+
+  // Rows are visited in insertion order and only the first current and
+  // pending version of each ECU is kept, as with loadInstalledVersions().
+  auto statement = db.prepareStatement(
+      "SELECT installed_versions.ecu_serial, ecus.hardware_id, is_current, is_pending, sha256, name, hashes, length, "
+      "correlation_id, custom_meta FROM installed_versions "
+      "LEFT JOIN ecus ON ecus.serial = installed_versions.ecu_serial "
+      "WHERE is_current = 1 OR is_pending = 1 ORDER BY installed_versions.id;");
+
+  std::map<Uptane::EcuSerial, InstalledVersions> new_versions;
+  int statement_state;
+  while ((statement_state = statement.step()) == SQLITE_ROW) {
+    try {
+      const Uptane::EcuSerial serial(statement.get_result_col_str(0).value());
+      Uptane::EcuMap ecu_map;
+      const auto hw_id = statement.get_result_col_str(1);
+      if (hw_id) {
+        ecu_map.insert({serial, Uptane::HardwareIdentifier(*hw_id)});
+      }
+
+      InstalledVersions& ecu_versions = new_versions[serial];
+      if (statement.get_result_col_int(2) != 0 && !ecu_versions.current) {
+        ecu_versions.current = readInstalledVersion(statement, 4, ecu_map);
+      }
+      if (statement.get_result_col_int(3) != 0 && !ecu_versions.pending) {
+        ecu_versions.pending = readInstalledVersion(statement, 4, ecu_map);
+      }
+    } catch (const boost::bad_optional_access&) {
+      LOG_ERROR << "Could not read installed versions";
+      return false;
+    } catch (const std::out_of_range& e) {
+      LOG_WARNING << "Ignoring installed version with invalid ECU serial: " << e.what();
+    }
+  }
+
+  if (statement_state != SQLITE_DONE) {
+    LOG_ERROR << "Failed to get installed versions: " << db.errmsg();
+    return false;
+  }
+
+  *versions = std::move(new_versions);
+  return true;
+}
+
 bool SQLStorage::hasPendingInstall() {
   SQLite3Guard db = dbConnection();
 
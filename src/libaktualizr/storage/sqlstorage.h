@@ -76,6 +76,7 @@ class SQLStorage : public SQLStorageBase, public INvStorage {
                             InstalledVersionUpdateMode update_mode) override;
   bool loadInstalledVersions(const std::string& ecu_serial, boost::optional<Uptane::Target>* current_version,
                              boost::optional<Uptane::Target>* pending_version) const override;
+  bool loadAllInstalledVersions(std::map<Uptane::EcuSerial, InstalledVersions>* versions) const override;
   bool loadInstallationLog(const std::string& ecu_serial, std::vector<Uptane::Target>* log,
                            bool only_installed) const override;
   bool hasPendingInstall() override;
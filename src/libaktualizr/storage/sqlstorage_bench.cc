@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+
+#include <map>
+
+#include "libaktualizr/config.h"
+#include "logging/logging.h"
+#include "storage/sqlstorage.h"
+#include "utilities/utils.h"
+
+namespace {
+
+const std::string kMetadata(16 * 1024, 'm');
+
+void BM_StoreNonRoot(benchmark::State &state) {
+  TemporaryDirectory temp_dir;
+  StorageConfig config;
+  config.path = temp_dir.Path();
+  SQLStorage storage(config, false);
+  for (auto _ : state) {
+    storage.storeNonRoot(kMetadata, Uptane::RepositoryType::Image(), Uptane::Role::Targets());
+  }
+}
+BENCHMARK(BM_StoreNonRoot);
+
+void BM_LoadNonRoot(benchmark::State &state) {
+  TemporaryDirectory temp_dir;
+  StorageConfig config;
+  config.path = temp_dir.Path();
+  SQLStorage storage(config, false);
+  storage.storeNonRoot(kMetadata, Uptane::RepositoryType::Image(), Uptane::Role::Targets());
+  std::string data;
+  for (auto _ : state) {
+    storage.loadNonRoot(&data, Uptane::RepositoryType::Image(), Uptane::Role::Targets());
+  }
+}
+BENCHMARK(BM_LoadNonRoot);
+
+/* Look up the installed versions of an ECU with the given number of entries in its installation log. */
+void BM_LoadInstalledVersions(benchmark::State &state) {
+  // Every lookup logs at debug level that there is no pending version.
+  logger_set_threshold(boost::log::trivial::info);
+  TemporaryDirectory temp_dir;
+  StorageConfig config;
+  config.path = temp_dir.Path();
+  SQLStorage storage(config, false);
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    Uptane::Target target("firmware-" + std::to_string(i) + ".bin", Uptane::EcuMap{},
+                          {Hash(Hash::Type::kSha256, std::string(64, 'a'))}, 1024);
+    storage.saveInstalledVersion("primary", target, InstalledVersionUpdateMode::kCurrent);
+  }
+  boost::optional<Uptane::Target> current;
+  boost::optional<Uptane::Target> pending;
+  for (auto _ : state) {
+    storage.loadInstalledVersions("primary", &current, &pending);
+  }
+}
+BENCHMARK(BM_LoadInstalledVersions)->Arg(1)->Arg(100);
+
+/* Fill a database with one installed version for each of the given number of ECUs. */
+void SaveEcuVersions(SQLStorage &storage, int64_t ecus) {
+  EcuSerials serials;
+  for (int64_t i = 0; i < ecus; ++i) {
+    serials.emplace_back(Uptane::EcuSerial("ecu-" + std::to_string(i)), Uptane::HardwareIdentifier("hw"));
+  }
+  storage.storeEcuSerials(serials);
+  for (const auto &ecu : serials) {
+    Uptane::Target target("firmware.bin", Uptane::EcuMap{{ecu.first, ecu.second}},
+                          {Hash(Hash::Type::kSha256, std::string(64, 'a'))}, 1024);
+    storage.saveInstalledVersion(ecu.first.ToString(), target, InstalledVersionUpdateMode::kCurrent);
+  }
+}
+
+/* Look up the current version of every ECU of a device, one ECU at a time. */
+void BM_LoadInstalledVersionsPerEcu(benchmark::State &state) {
+  logger_set_threshold(boost::log::trivial::info);
+  TemporaryDirectory temp_dir;
+  StorageConfig config;
+  config.path = temp_dir.Path();
+  SQLStorage storage(config, false);
+  SaveEcuVersions(storage, state.range(0));
+  boost::optional<Uptane::Target> current;
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      storage.loadInstalledVersions("ecu-" + std::to_string(i), &current, nullptr);
+    }
+  }
+}
+BENCHMARK(BM_LoadInstalledVersionsPerEcu)->Arg(1)->Arg(50);
+
+/* Look up the current version of every ECU of a device at once. */
+void BM_LoadAllInstalledVersions(benchmark::State &state) {
+  logger_set_threshold(boost::log::trivial::info);
+  TemporaryDirectory temp_dir;
+  StorageConfig config;
+  config.path = temp_dir.Path();
+  SQLStorage storage(config, false);
+  SaveEcuVersions(storage, state.range(0));
+  std::map<Uptane::EcuSerial, InstalledVersions> versions;
+  for (auto _ : state) {
+    storage.loadAllInstalledVersions(&versions);
+  }
+}
+BENCHMARK(BM_LoadAllInstalledVersions)->Arg(1)->Arg(50);
+
+}  // namespace
+
+BENCHMARK_MAIN();
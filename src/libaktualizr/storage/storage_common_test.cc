@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <map>
 #include <memory>
 #include <string>
 
@@ -418,6 +419,56 @@ TEST(StorageCommon, LoadStoreInstalledVersions) {
   }
 }
 
+/* Load the installed versions of all ECUs at once. */
+TEST(StorageCommon, LoadAllInstalledVersions) {
+  TemporaryDirectory temp_dir;
+  std::unique_ptr<INvStorage> storage = Storage(temp_dir.Path());
+
+  EcuSerials serials{{Uptane::EcuSerial("primary"), Uptane::HardwareIdentifier("primary_hw")},
+                     {Uptane::EcuSerial("secondary_1"), Uptane::HardwareIdentifier("secondary_hw")},
+                     {Uptane::EcuSerial("secondary_2"), Uptane::HardwareIdentifier("secondary_hw")}};
+  storage->storeEcuSerials(serials);
+
+  Uptane::EcuMap primary_ecu{{Uptane::EcuSerial("primary"), Uptane::HardwareIdentifier("primary_hw")}};
+  Uptane::Target t1{"update.bin", primary_ecu, {Hash{Hash::Type::kSha256, "2561"}}, 1, "corrid"};
+  Json::Value custom;
+  custom["version"] = 42;
+  t1.updateCustom(custom);
+  Uptane::Target t2{"update2.bin", primary_ecu, {Hash{Hash::Type::kSha256, "2562"}}, 2};
+  storage->savePrimaryInstalledVersion(t1, InstalledVersionUpdateMode::kCurrent);
+  storage->savePrimaryInstalledVersion(t2, InstalledVersionUpdateMode::kPending);
+
+  Uptane::EcuMap secondary_ecu{{Uptane::EcuSerial("secondary_1"), Uptane::HardwareIdentifier("secondary_hw")}};
+  Uptane::Target tsec{"secondary.bin", secondary_ecu, {Hash{Hash::Type::kSha256, "256s"}}, 4};
+  storage->saveInstalledVersion("secondary_1", tsec, InstalledVersionUpdateMode::kCurrent);
+  // An ECU that is no longer part of the device.
+  storage->saveInstalledVersion("removed", tsec, InstalledVersionUpdateMode::kCurrent);
+
+  std::map<Uptane::EcuSerial, InstalledVersions> versions;
+  EXPECT_TRUE(storage->loadAllInstalledVersions(&versions));
+  EXPECT_EQ(versions.size(), 3);
+  EXPECT_EQ(versions.count(Uptane::EcuSerial("secondary_2")), 0);
+
+  for (const auto &serial : {"primary", "secondary_1", "removed"}) {
+    boost::optional<Uptane::Target> current;
+    boost::optional<Uptane::Target> pending;
+    EXPECT_TRUE(storage->loadInstalledVersions(serial, &current, &pending));
+    const InstalledVersions &ecu_versions = versions.at(Uptane::EcuSerial(serial));
+    ASSERT_TRUE(!!ecu_versions.current);
+    EXPECT_TRUE(ecu_versions.current->MatchTarget(*current));
+    EXPECT_EQ(ecu_versions.current->ecus(), current->ecus());
+    EXPECT_EQ(ecu_versions.current->correlation_id(), current->correlation_id());
+    EXPECT_EQ(ecu_versions.current->custom_data(), current->custom_data());
+    EXPECT_EQ(!!ecu_versions.pending, !!pending);
+    if (pending) {
+      EXPECT_TRUE(ecu_versions.pending->MatchTarget(*pending));
+    }
+  }
+  EXPECT_EQ(versions.at(Uptane::EcuSerial("primary")).current->custom_data()["version"], 42);
+  EXPECT_EQ(versions.at(Uptane::EcuSerial("primary")).pending->filename(), "update2.bin");
+  EXPECT_TRUE(versions.at(Uptane::EcuSerial("removed")).current->ecus().empty());
+}
+
 /*
  * Load and store an ECU installation result in an SQL database.
  * Load and store a device installation result in an SQL database.
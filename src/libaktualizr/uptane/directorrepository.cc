@@ -14,6 +14,13 @@ void DirectorRepository::checkTargetsExpired() {
   }
 }
 
+void DirectorRepository::checkMetaExpired() {
+  if (rootExpired()) {
+    throw Uptane::ExpiredMetadata(type.toString(), Role::ROOT);
+  }
+  checkTargetsExpired();
+}
+
 void DirectorRepository::targetsSanityCheck() {
   //  5.4.4.6.6. If checking Targets metadata from the Director repository,
   //  verify that there are no delegations.
@@ -23,7 +30,7 @@ void DirectorRepository::targetsSanityCheck() {
   //  5.4.4.6.7. If checking Targets metadata from the Director repository,
   //  check that no ECU identifier is represented more than once.
   std::set<Uptane::EcuSerial> ecu_ids;
-  for (const auto& target : targets.targets) {
+  for (const auto& target : targets.targets()) {
     for (const auto& ecu : target.ecus()) {
       if (ecu_ids.find(ecu.first) == ecu_ids.end()) {
         ecu_ids.insert(ecu.first);
@@ -38,7 +45,7 @@ void DirectorRepository::targetsSanityCheck() {
 bool DirectorRepository::usePreviousTargets() const {
   // Don't store the new targets if they are empty and we've previously received
   // a non-empty list.
-  return !targets.targets.empty() && latest_targets.targets.empty();
+  return !targets.targets().empty() && latest_targets.targets().empty();
 }
 
 void DirectorRepository::verifyTargets(const std::string& targets_raw) {
@@ -111,10 +118,14 @@ void DirectorRepository::updateMeta(INvStorage& storage, const IMetadataFetcher&
     std::string director_targets_stored;
     if (storage.loadNonRoot(&director_targets_stored, RepositoryType::Director(), Role::Targets())) {
       local_version = extractVersionUntrusted(director_targets_stored);
-      try {
-        verifyTargets(director_targets_stored);
-      } catch (const std::exception& e) {
-        LOG_WARNING << "Unable to verify stored Director Targets metadata.";
+      // Verifying the same metadata twice gives the same result, so only the
+      // fetched copy is verified if nothing has changed.
+      if (director_targets_stored != director_targets) {
+        try {
+          verifyTargets(director_targets_stored);
+        } catch (const std::exception& e) {
+          LOG_WARNING << "Unable to verify stored Director Targets metadata.";
+        }
       }
     } else {
       local_version = -1;
@@ -153,15 +164,8 @@ bool DirectorRepository::matchTargetsWithImageTargets(const Uptane::Targets& ima
   // Currently this is only used by aktualizr-secondary, but according to the
   // Standard, "A Secondary ECU MAY elect to perform this check only on the
   // metadata for the image it will install".
-  const auto& image_target_array = image_targets.targets;
-  const auto& director_target_array = targets.targets;
-
-  for (const auto& director_target : director_target_array) {
-    auto found_it = std::find_if(
-        image_target_array.begin(), image_target_array.end(),
-        [&director_target](const Target& image_target) { return director_target.MatchTarget(image_target); });
-
-    if (found_it == image_target_array.end()) {
+  for (const auto& director_target : targets.targets()) {
+    if (image_targets.findTarget(director_target) == nullptr) {
       return false;
     }
   }
@@ -25,6 +25,8 @@ class DirectorRepository : public RepositoryCommon {
   void dropTargets(INvStorage& storage);
 
   void updateMeta(INvStorage& storage, const IMetadataFetcher& fetcher) override;
+  // Throws if any of the metadata verified by the last update has expired since.
+  void checkMetaExpired();
   bool matchTargetsWithImageTargets(const Uptane::Targets& image_targets) const;
 
  private:
@@ -7,6 +7,8 @@ void ImageRepository::resetMeta() {
   targets.reset();
   snapshot = Snapshot();
   timestamp = TimestampMeta();
+  std::lock_guard<std::mutex> guard(delegations_mutex);
+  delegations.clear();
 }
 
 void ImageRepository::verifyTimestamp(const std::string& timestamp_raw) {
@@ -48,7 +50,8 @@ void ImageRepository::fetchSnapshot(INvStorage& storage, const IMetadataFetcher&
 }
 
 void ImageRepository::verifySnapshot(const std::string& snapshot_raw, bool prefetch) {
-  const std::string canonical = Utils::jsonToCanonicalStr(Utils::parseJSON(snapshot_raw));
+  const Json::Value snapshot_json = Utils::parseJSON(snapshot_raw);
+  const std::string canonical = Utils::jsonToCanonicalStr(snapshot_json);
   bool hash_exists = false;
   for (const auto& it : timestamp.snapshot_hashes()) {
     switch (it.type()) {
@@ -82,7 +85,7 @@ void ImageRepository::verifySnapshot(const std::string& snapshot_raw, bool prefe
 
   try {
     // Verify the signature:
-    snapshot = Snapshot(RepositoryType::Image(), Utils::parseJSON(snapshot_raw), std::make_shared<MetaWithKeys>(root));
+    snapshot = Snapshot(RepositoryType::Image(), snapshot_json, std::make_shared<MetaWithKeys>(root));
   } catch (const Exception& e) {
     LOG_ERROR << "Signature verification for Snapshot metadata failed";
     throw;
@@ -122,10 +125,14 @@ void ImageRepository::fetchTargets(INvStorage& storage, const IMetadataFetcher&
 }
 
 void ImageRepository::verifyRoleHashes(const std::string& role_data, const Uptane::Role& role, bool prefetch) const {
-  const std::string canonical = Utils::jsonToCanonicalStr(Utils::parseJSON(role_data));
   // Hashes are not required. If present, however, we may as well check them.
   // This provides no security benefit, but may help with fault detection.
-  for (const auto& it : snapshot.role_hashes(role)) {
+  const std::vector<Hash> hashes = snapshot.role_hashes(role);
+  if (hashes.empty()) {
+    return;
+  }
+  const std::string canonical = Utils::jsonToCanonicalStr(Utils::parseJSON(role_data));
+  for (const auto& it : hashes) {
     switch (it.type()) {
       case Hash::Type::kSha256:
         if (Hash(Hash::Type::kSha256, boost::algorithm::hex(Crypto::sha256digest(canonical))) != it) {
@@ -149,6 +156,29 @@ void ImageRepository::verifyRoleHashes(const std::string& role_data, const Uptan
   }
 }
 
+std::shared_ptr<const Uptane::Targets> ImageRepository::getVerifiedDelegation(const std::string& parent,
+                                                                             const Role& role) const {
+  std::lock_guard<std::mutex> guard(delegations_mutex);
+  if (delegations_snapshot_version != snapshot.version()) {
+    return nullptr;
+  }
+  const auto it = delegations.find({parent, role});
+  if (it == delegations.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void ImageRepository::storeVerifiedDelegation(const std::string& parent, const Role& role,
+                                              std::shared_ptr<const Uptane::Targets> delegation) const {
+  std::lock_guard<std::mutex> guard(delegations_mutex);
+  if (delegations_snapshot_version != snapshot.version()) {
+    delegations.clear();
+    delegations_snapshot_version = snapshot.version();
+  }
+  delegations[{parent, role}] = std::move(delegation);
+}
+
 int ImageRepository::getRoleVersion(const Uptane::Role& role) const { return snapshot.role_version(role); }
 
 int64_t ImageRepository::getRoleSize(const Uptane::Role& role) const { return snapshot.role_size(role); }
@@ -197,6 +227,15 @@ void ImageRepository::checkTargetsExpired() {
   }
 }
 
+void ImageRepository::checkMetaExpired() {
+  if (rootExpired()) {
+    throw Uptane::ExpiredMetadata(type.toString(), Role::ROOT);
+  }
+  checkTimestampExpired();
+  checkSnapshotExpired();
+  checkTargetsExpired();
+}
+
 void ImageRepository::updateMeta(INvStorage& storage, const IMetadataFetcher& fetcher) {
   resetMeta();
 
@@ -2,6 +2,8 @@
 #define IMAGE_REPOSITORY_H_
 
 #include <map>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 #include "uptanerepository.h"
@@ -30,8 +32,20 @@ class ImageRepository : public RepositoryCommon {
   int getRoleVersion(const Uptane::Role& role) const;
   int64_t getRoleSize(const Uptane::Role& role) const;
 
+  /**
+   * Delegated Targets metadata that has already been verified in this update
+   * cycle, looked up by the name of the delegating role and the delegated
+   * role. Returns nullptr if the delegation has not been verified yet or the
+   * Snapshot metadata has changed since.
+   */
+  std::shared_ptr<const Uptane::Targets> getVerifiedDelegation(const std::string& parent, const Role& role) const;
+  void storeVerifiedDelegation(const std::string& parent, const Role& role,
+                               std::shared_ptr<const Uptane::Targets> delegation) const;
+
   void checkMetaOffline(INvStorage& storage);
   void updateMeta(INvStorage& storage, const IMetadataFetcher& fetcher) override;
+  // Throws if any of the metadata verified by the last update has expired since.
+  void checkMetaExpired();
 
  private:
   void checkTimestampExpired();
@@ -44,6 +58,11 @@ class ImageRepository : public RepositoryCommon {
   std::shared_ptr<Uptane::Targets> targets;
   Uptane::TimestampMeta timestamp;
   Uptane::Snapshot snapshot;
+
+  // Cleared in resetMeta(), so entries live for a single update cycle.
+  mutable std::mutex delegations_mutex;
+  mutable std::map<std::pair<std::string, Role>, std::shared_ptr<const Uptane::Targets>> delegations;
+  mutable int delegations_snapshot_version{-1};
 };
 
 }  // namespace Uptane
@@ -2,9 +2,14 @@
 
 namespace Uptane {
 
-Targets getTrustedDelegation(const Role &delegate_role, const Targets &parent_targets,
-                             const ImageRepository &image_repo, INvStorage &storage, Fetcher &fetcher,
-                             const bool offline) {
+std::shared_ptr<const Targets> getTrustedDelegation(const Role &delegate_role, const Targets &parent_targets,
+                                                    const ImageRepository &image_repo, INvStorage &storage,
+                                                    Fetcher &fetcher, const bool offline) {
+  auto verified = image_repo.getVerifiedDelegation(parent_targets.name(), delegate_role);
+  if (verified != nullptr) {
+    return verified;
+  }
+
   std::string delegation_meta;
   auto version_in_snapshot = image_repo.getRoleVersion(delegate_role);
 
@@ -52,7 +57,8 @@ Targets getTrustedDelegation(const Role &delegate_role, const Targets &parent_ta
     storage.storeDelegation(delegation_meta, delegate_role);
   }
 
-  return *delegation;
+  image_repo.storeVerifiedDelegation(parent_targets.name(), delegate_role, delegation);
+  return delegation;
 }
 
 LazyTargetsList::DelegationIterator::DelegationIterator(const ImageRepository &repo,
@@ -86,11 +92,9 @@ void LazyTargetsList::DelegationIterator::renewTargetsData() {
       indices.pop();
 
       auto fetched_role = Role(parent_targets->delegated_role_names_[idx], true);
-      parent_targets = std::make_shared<const Targets>(
-          getTrustedDelegation(fetched_role, *parent_targets, repo_, *storage_, *fetcher_, false));
+      parent_targets = getTrustedDelegation(fetched_role, *parent_targets, repo_, *storage_, *fetcher_, false);
     }
-    cur_targets_ =
-        std::make_shared<Targets>(getTrustedDelegation(role, *parent_targets, repo_, *storage_, *fetcher_, false));
+    cur_targets_ = getTrustedDelegation(role, *parent_targets, repo_, *storage_, *fetcher_, false);
   }
 }
 
@@ -111,11 +115,11 @@ const Target &LazyTargetsList::DelegationIterator::operator*() {
     renewTargetsData();
   }
 
-  if (!cur_targets_ || target_idx_ >= cur_targets_->targets.size()) {
+  if (!cur_targets_ || target_idx_ >= cur_targets_->targets().size()) {
     throw std::runtime_error("Inconsistent delegation iterator");
   }
 
-  return cur_targets_->targets[target_idx_];
+  return cur_targets_->targets()[target_idx_];
 }
 
 LazyTargetsList::DelegationIterator LazyTargetsList::DelegationIterator::operator++() {
@@ -128,7 +132,7 @@ LazyTargetsList::DelegationIterator LazyTargetsList::DelegationIterator::operato
   }
 
   // first iterate over current role's targets
-  if (target_idx_ + 1 < cur_targets_->targets.size()) {
+  if (target_idx_ + 1 < cur_targets_->targets().size()) {
     ++target_idx_;
     return *this;
   }
@@ -183,7 +187,7 @@ LazyTargetsList::DelegationIterator LazyTargetsList::DelegationIterator::operato
     cur_targets_.reset();
     tree_node_ = new_tree_node;
     renewTargetsData();
-    target_idx_ = cur_targets_->targets.size();  // mark targets as exhausted
+    target_idx_ = cur_targets_->targets().size();  // mark targets as exhausted
     return ++(*this);                            // reiterate to find the next target
   }
 
@@ -6,8 +6,14 @@
 
 namespace Uptane {
 
-Targets getTrustedDelegation(const Role &delegate_role, const Targets &parent_targets,
-                             const ImageRepository &image_repo, INvStorage &storage, Fetcher &fetcher, bool offline);
+/**
+ * Load, fetch if necessary, and verify the metadata of a delegated role. The
+ * result is kept in image_repo for the rest of the update cycle, so that each
+ * role is verified only once however often the delegation tree is walked.
+ */
+std::shared_ptr<const Targets> getTrustedDelegation(const Role &delegate_role, const Targets &parent_targets,
+                                                    const ImageRepository &image_repo, INvStorage &storage,
+                                                    Fetcher &fetcher, bool offline);
 
 class LazyTargetsList {
  public:
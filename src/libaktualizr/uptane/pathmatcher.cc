@@ -0,0 +1,222 @@
+#include "pathmatcher.h"
+
+#include <fnmatch.h>
+#include <algorithm>
+#include <clocale>
+#include <cstring>
+
+namespace Uptane {
+
+namespace {
+
+bool isCLocale(int category) {
+  const char *name = setlocale(category, nullptr);
+  return name != nullptr && (std::strcmp(name, "C") == 0 || std::strcmp(name, "POSIX") == 0);
+}
+
+}  // namespace
+
+void PathMatcher::add(const size_t role, const std::string &pattern) {
+  Pattern compiled;
+  compiled.role = role;
+  compiled.original = pattern;
+
+  // In other locales, fnmatch() works on multibyte characters and collation
+  // order, which byte-wise matching cannot reproduce.
+  std::string prefix;
+  if (isCLocale(LC_CTYPE) && isCLocale(LC_COLLATE)) {
+    compiled.use_fnmatch = !compile(pattern.c_str(), &prefix, &compiled.tokens);
+  } else {
+    compiled.use_fnmatch = true;
+  }
+  if (compiled.use_fnmatch) {
+    compiled.tokens.clear();
+  }
+
+  if (nodes_.empty()) {
+    nodes_.emplace_back();
+  }
+  size_t node = 0;
+  for (const char c : prefix) {
+    const auto child = nodes_[node].children.find(c);
+    if (child != nodes_[node].children.end()) {
+      node = child->second;
+    } else {
+      nodes_.emplace_back();
+      nodes_[node].children.emplace(c, nodes_.size() - 1);
+      node = nodes_.size() - 1;
+    }
+  }
+  nodes_[node].patterns.push_back(patterns_.size());
+  patterns_.push_back(std::move(compiled));
+}
+
+std::vector<size_t> PathMatcher::match(const std::string &filename) const {
+  std::vector<size_t> roles;
+  if (nodes_.empty()) {
+    return roles;
+  }
+
+  // fnmatch() only sees the filename up to the first NUL character.
+  const char *name = filename.c_str();
+  const size_t len = std::strlen(name);
+  size_t node = 0;
+  for (size_t pos = 0;; ++pos) {
+    for (const size_t idx : nodes_[node].patterns) {
+      const Pattern &pattern = patterns_[idx];
+      const bool matched = pattern.use_fnmatch ? fnmatch(pattern.original.c_str(), name, 0) == 0
+                                               : matchTokens(pattern.tokens, name + pos, len - pos);
+      if (matched) {
+        roles.push_back(pattern.role);
+      }
+    }
+    if (pos == len) {
+      break;
+    }
+    const auto child = nodes_[node].children.find(name[pos]);
+    if (child == nodes_[node].children.end()) {
+      break;
+    }
+    node = child->second;
+  }
+
+  std::sort(roles.begin(), roles.end());
+  roles.erase(std::unique(roles.begin(), roles.end()), roles.end());
+  return roles;
+}
+
+// Returns false if the pattern has to be left to fnmatch(). The literal
+// characters the pattern starts with go to prefix, the rest to tokens.
+bool PathMatcher::compile(const char *p, std::string *prefix, std::vector<Token> *tokens) {
+  while (*p != '\0') {
+    const char c = *p++;
+    if (c == '*') {
+      if (tokens->empty() || tokens->back().op != Op::kAnyString) {
+        tokens->emplace_back(Op::kAnyString);
+      }
+    } else if (c == '?') {
+      tokens->emplace_back(Op::kAnyChar);
+    } else if (c == '[') {
+      Token token(Op::kSet);
+      if (!compileSet(&p, &token.set)) {
+        return false;
+      }
+      tokens->push_back(token);
+    } else {
+      char literal = c;
+      if (c == '\\') {
+        // A trailing backslash never matches.
+        if (*p == '\0') {
+          return false;
+        }
+        literal = *p++;
+      }
+      if (tokens->empty()) {
+        prefix->push_back(literal);
+      } else {
+        if (tokens->back().op != Op::kLiteral) {
+          tokens->emplace_back(Op::kLiteral);
+        }
+        tokens->back().literal.push_back(literal);
+      }
+    }
+  }
+  return true;
+}
+
+// Parses a bracket expression after the opening '[': an optional '!', then
+// characters and ranges up to a ']' that is not the first member.
+bool PathMatcher::compileSet(const char **p, std::bitset<256> *set) {
+  const char *s = *p;
+  bool negate = false;
+  // '^' only negates if POSIXLY_CORRECT is not set.
+  if (*s == '!') {
+    negate = true;
+    ++s;
+  } else if (*s == '^') {
+    return false;
+  }
+
+  for (bool first = true;; first = false) {
+    const auto c = static_cast<unsigned char>(*s);
+    if (c == '\0' || c == '\\' || c == '[') {
+      return false;
+    }
+    ++s;
+    if (c == ']' && !first) {
+      break;
+    }
+    if (s[0] == '-' && s[1] != '\0' && s[1] != ']') {
+      const auto end = static_cast<unsigned char>(s[1]);
+      if (end == '\\' || end == '[') {
+        return false;
+      }
+      for (unsigned int v = c; v <= end; ++v) {
+        set->set(v);
+      }
+      s += 2;
+    } else {
+      set->set(c);
+    }
+  }
+
+  if (negate) {
+    set->flip();
+  }
+  *p = s;
+  return true;
+}
+
+bool PathMatcher::matchTokens(const std::vector<Token> &tokens, const char *s, const size_t n) {
+  // Every token but '*' matches a fixed number of characters, so it is enough
+  // to backtrack to the last '*' seen and let it consume one more character.
+  size_t t = 0;
+  size_t i = 0;
+  bool have_star = false;
+  size_t star_t = 0;
+  size_t star_i = 0;
+  for (;;) {
+    if (t < tokens.size()) {
+      const Token &token = tokens[t];
+      if (token.op == Op::kAnyString) {
+        if (t + 1 == tokens.size()) {
+          return true;
+        }
+        // A final literal after the last '*' can only match the end of the name.
+        if (t + 2 == tokens.size() && tokens[t + 1].op == Op::kLiteral) {
+          const std::string &suffix = tokens[t + 1].literal;
+          return n - i >= suffix.size() && std::memcmp(s + n - suffix.size(), suffix.data(), suffix.size()) == 0;
+        }
+        have_star = true;
+        star_t = ++t;
+        star_i = i;
+        continue;
+      }
+      bool matched;
+      size_t len = 1;
+      if (token.op == Op::kLiteral) {
+        len = token.literal.size();
+        matched = i + len <= n && std::memcmp(s + i, token.literal.data(), len) == 0;
+      } else if (token.op == Op::kSet) {
+        matched = i < n && token.set.test(static_cast<unsigned char>(s[i]));
+      } else {
+        matched = i < n;
+      }
+      if (matched) {
+        i += len;
+        ++t;
+        continue;
+      }
+    } else if (i == n) {
+      return true;
+    }
+
+    if (!have_star || star_i >= n) {
+      return false;
+    }
+    i = ++star_i;
+    t = star_t;
+  }
+}
+
+}  // namespace Uptane
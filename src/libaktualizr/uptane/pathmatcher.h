@@ -0,0 +1,69 @@
+#ifndef AKTUALIZR_UPTANE_PATHMATCHER_H_
+#define AKTUALIZR_UPTANE_PATHMATCHER_H_
+
+#include <bitset>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Uptane {
+
+/**
+ * Matches a filename against the path patterns of all the delegated roles of
+ * a Targets metadata object at once.
+ *
+ * Patterns mean the same as with fnmatch(3) without flags. They are stored in
+ * a trie by their literal prefix, so that only the patterns that the filename
+ * starts with are evaluated, and the remainder of each pattern is compiled
+ * into a list of tokens. Constructs whose meaning depends on the locale or the
+ * C library version (character classes, unterminated brackets, escapes inside
+ * brackets...) are still handed to fnmatch(), and so is every pattern if the
+ * process does not use the "C" locale.
+ */
+class PathMatcher {
+ public:
+  /** Add a pattern for the role with the given index. */
+  void add(size_t role, const std::string &pattern);
+
+  /** Indices of the roles with a pattern that matches filename, in ascending order. */
+  std::vector<size_t> match(const std::string &filename) const;
+
+  void clear() {
+    nodes_.clear();
+    patterns_.clear();
+  }
+
+ private:
+  enum class Op { kLiteral, kAnyChar, kAnyString, kSet };
+
+  struct Token {
+    explicit Token(Op op_in) : op(op_in) {}
+    Op op;
+    std::string literal;   // kLiteral
+    std::bitset<256> set;  // kSet
+  };
+
+  struct Pattern {
+    size_t role{0};
+    bool use_fnmatch{false};
+    std::string original;
+    // What is left after the literal prefix, unless use_fnmatch is set.
+    std::vector<Token> tokens;
+  };
+
+  struct Node {
+    std::map<char, size_t> children;
+    std::vector<size_t> patterns;
+  };
+
+  static bool compile(const char *p, std::string *prefix, std::vector<Token> *tokens);
+  static bool compileSet(const char **p, std::bitset<256> *set);
+  static bool matchTokens(const std::vector<Token> &tokens, const char *s, size_t n);
+
+  std::vector<Node> nodes_;
+  std::vector<Pattern> patterns_;
+};
+
+}  // namespace Uptane
+
+#endif  // AKTUALIZR_UPTANE_PATHMATCHER_H_
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <fnmatch.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "uptane/pathmatcher.h"
+
+namespace {
+
+std::vector<size_t> fnmatchRoles(const std::vector<std::vector<std::string>> &roles, const std::string &filename) {
+  std::vector<size_t> result;
+  for (size_t i = 0; i < roles.size(); ++i) {
+    for (const auto &pattern : roles[i]) {
+      if (fnmatch(pattern.c_str(), filename.c_str(), 0) == 0) {
+        result.push_back(i);
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+std::string randomString(std::mt19937 &gen, const std::string &alphabet, size_t max_len) {
+  std::uniform_int_distribution<size_t> len_dist(0, max_len);
+  std::uniform_int_distribution<size_t> char_dist(0, alphabet.size() - 1);
+  std::string result;
+  for (size_t len = len_dist(gen); len > 0; --len) {
+    result.push_back(alphabet[char_dist(gen)]);
+  }
+  return result;
+}
+
+}  // namespace
+
+/* Common delegation patterns. */
+TEST(PathMatcher, Examples) {
+  Uptane::PathMatcher matcher;
+  matcher.add(0, "abc/*");
+  matcher.add(1, "*.bin");
+  matcher.add(2, "abc/target[0-2]");
+  matcher.add(3, "ab?/target0");
+  matcher.add(4, "def/target0");
+  matcher.add(4, "[!a]*");
+
+  EXPECT_EQ(matcher.match("abc/target0"), std::vector<size_t>({0, 2, 3}));
+  EXPECT_EQ(matcher.match("abc/target3"), std::vector<size_t>({0}));
+  EXPECT_EQ(matcher.match("abc/sub/image.bin"), std::vector<size_t>({0, 1}));
+  EXPECT_EQ(matcher.match("def/target0"), std::vector<size_t>({4}));
+  EXPECT_EQ(matcher.match("abd/target0"), std::vector<size_t>({3}));
+  EXPECT_TRUE(matcher.match("abc").empty());
+
+  matcher.clear();
+  EXPECT_TRUE(matcher.match("abc/target0").empty());
+}
+
+/* Results are the same as with fnmatch() for random patterns and filenames,
+ * including bracket expressions, escapes and malformed patterns. */
+TEST(PathMatcher, SameAsFnmatch) {
+  std::mt19937 gen(4242);
+  const std::string pattern_alphabet = "ab/.-*?[]!^\\\xe9";
+  const std::string name_alphabet = "ab/.-*?[]!^\\z\xe9";
+  std::uniform_int_distribution<size_t> roles_dist(1, 4);
+  std::uniform_int_distribution<size_t> patterns_dist(1, 3);
+
+  for (int round = 0; round < 20000; ++round) {
+    std::vector<std::vector<std::string>> roles(roles_dist(gen));
+    Uptane::PathMatcher matcher;
+    for (size_t i = 0; i < roles.size(); ++i) {
+      for (size_t j = patterns_dist(gen); j > 0; --j) {
+        roles[i].push_back(randomString(gen, pattern_alphabet, 8));
+        matcher.add(i, roles[i].back());
+      }
+    }
+
+    for (int k = 0; k < 10; ++k) {
+      const std::string filename = randomString(gen, name_alphabet, 8);
+      ASSERT_EQ(matcher.match(filename), fnmatchRoles(roles, filename))
+          << "filename: " << filename << ", first pattern: " << roles[0][0];
+    }
+  }
+}
+
+/* Patterns made of literal prefixes and globs, as used in practice. */
+TEST(PathMatcher, SameAsFnmatchPaths) {
+  std::mt19937 gen(2424);
+  const std::vector<std::string> parts = {"abc", "abd", "a", "/", "*", "?", "[a-c]", "[!b]", "[]a]", "[a-]", "\\*",
+                                          ".bin"};
+  std::uniform_int_distribution<size_t> part_dist(0, parts.size() - 1);
+  std::uniform_int_distribution<size_t> len_dist(0, 5);
+
+  std::vector<std::vector<std::string>> roles(100);
+  Uptane::PathMatcher matcher;
+  for (size_t i = 0; i < roles.size(); ++i) {
+    for (int j = 0; j < 3; ++j) {
+      std::string pattern;
+      for (size_t len = len_dist(gen); len > 0; --len) {
+        pattern += parts[part_dist(gen)];
+      }
+      roles[i].push_back(pattern);
+      matcher.add(i, pattern);
+    }
+  }
+
+  for (int k = 0; k < 20000; ++k) {
+    const std::string filename = randomString(gen, "abcd/.]*-bin", 12);
+    ASSERT_EQ(matcher.match(filename), fnmatchRoles(roles, filename)) << "filename: " << filename;
+  }
+}
+
+/* Like fnmatch(), only look at the filename up to the first NUL character. */
+TEST(PathMatcher, EmbeddedNul) {
+  Uptane::PathMatcher matcher;
+  matcher.add(0, "abc");
+  matcher.add(1, "abc*");
+  EXPECT_EQ(matcher.match(std::string("abc\0def", 7)), std::vector<size_t>({0, 1}));
+}
+
+#ifndef __NO_MAIN__
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+#endif
@@ -82,64 +82,80 @@ std::vector<Hash> Hash::decodeVector(std::string hashes_str) {
   return hash_v;
 }
 
-Target::Target(std::string filename, const Json::Value &content) : filename_(std::move(filename)) {
+Target::Target(std::string filename, const Json::Value &content) : data_(std::make_shared<Data>()) {
+  data_->filename = std::move(filename);
   if (content.isMember("custom")) {
     updateCustom(content["custom"]);
   }
 
-  length_ = content["length"].asUInt64();
+  data_->length = content["length"].asUInt64();
 
   const Json::Value hashes = content["hashes"];
   for (auto i = hashes.begin(); i != hashes.end(); ++i) {
     Hash h(i.key().asString(), (*i).asString());
     if (h.HaveAlgorithm()) {
-      hashes_.push_back(h);
+      data_->hashes.push_back(h);
     }
   }
   // sort hashes so that higher priority hash algorithm goes first
-  std::sort(hashes_.begin(), hashes_.end(), [](const Hash &l, const Hash &r) { return l.type() < r.type(); });
+  std::sort(data_->hashes.begin(), data_->hashes.end(),
+            [](const Hash &l, const Hash &r) { return l.type() < r.type(); });
 }
 
 void Target::updateCustom(const Json::Value &custom) {
-  custom_ = custom;
+  Data &data = mutableData();
+  Json::Value custom_json = custom;
 
   // Image repo provides an array of hardware IDs.
-  if (custom_.isMember("hardwareIds")) {
-    Json::Value hwids = custom_["hardwareIds"];
+  if (custom_json.isMember("hardwareIds")) {
+    Json::Value hwids = custom_json["hardwareIds"];
     for (auto i = hwids.begin(); i != hwids.end(); ++i) {
-      hwids_.emplace_back(HardwareIdentifier((*i).asString()));
+      data.hwids.emplace_back(HardwareIdentifier((*i).asString()));
     }
   }
 
   // Director provides a map of ECU serials to hardware IDs.
-  Json::Value ecus = custom_["ecuIdentifiers"];
+  Json::Value ecus = custom_json["ecuIdentifiers"];
   for (auto i = ecus.begin(); i != ecus.end(); ++i) {
-    ecus_.insert({EcuSerial(i.key().asString()), HardwareIdentifier((*i)["hardwareId"].asString())});
+    data.ecus.insert({EcuSerial(i.key().asString()), HardwareIdentifier((*i)["hardwareId"].asString())});
   }
 
-  if (custom_.isMember("targetFormat")) {
-    type_ = custom_["targetFormat"].asString();
+  if (custom_json.isMember("targetFormat")) {
+    data.type = custom_json["targetFormat"].asString();
   }
 
-  if (custom_.isMember("uri")) {
-    std::string custom_uri = custom_["uri"].asString();
+  if (custom_json.isMember("uri")) {
+    std::string custom_uri = custom_json["uri"].asString();
     // Ignore this exact URL for backwards compatibility with old defaults that inserted it.
     if (custom_uri != "https://example.com/") {
-      uri_ = std::move(custom_uri);
+      data.uri = std::move(custom_uri);
     }
   }
+
+  data.custom = std::move(custom_json);
+}
+
+Json::Value Target::custom_data() const { return data_->custom; }
+
+Target::Data &Target::mutableData() {
+  if (data_.use_count() > 1) {
+    data_ = std::make_shared<Data>(*data_);
+  }
+  return *data_;
 }
 
 // Internal use only.
 Target::Target(std::string filename, EcuMap ecus, std::vector<Hash> hashes, uint64_t length, std::string correlation_id)
-    : filename_(std::move(filename)),
-      ecus_(std::move(ecus)),
-      hashes_(std::move(hashes)),
-      length_(length),
-      correlation_id_(std::move(correlation_id)) {
+    : data_(std::make_shared<Data>()) {
+  data_->filename = std::move(filename);
+  data_->ecus = std::move(ecus);
+  data_->hashes = std::move(hashes);
+  data_->length = length;
+  data_->correlation_id = std::move(correlation_id);
   // sort hashes so that higher priority hash algorithm goes first
-  std::sort(hashes_.begin(), hashes_.end(), [](const Hash &l, const Hash &r) { return l.type() < r.type(); });
-  type_ = "UNKNOWN";
+  std::sort(data_->hashes.begin(), data_->hashes.end(),
+            [](const Hash &l, const Hash &r) { return l.type() < r.type(); });
+  data_->type = "UNKNOWN";
 }
 
 Target Target::Unknown() {
@@ -154,12 +170,12 @@ Target Target::Unknown() {
 }
 
 bool Target::MatchHash(const Hash &hash) const {
-  return (std::find(hashes_.begin(), hashes_.end(), hash) != hashes_.end());
+  return (std::find(data_->hashes.begin(), data_->hashes.end(), hash) != data_->hashes.end());
 }
 
 std::string Target::hashString(Hash::Type type) const {
   std::vector<Hash>::const_iterator it;
-  for (it = hashes_.begin(); it != hashes_.end(); it++) {
+  for (it = data_->hashes.begin(); it != data_->hashes.end(); it++) {
     if (it->type() == type) {
       return boost::algorithm::to_lower_copy(it->HashString());
     }
@@ -173,7 +189,7 @@ std::string Target::sha512Hash() const { return hashString(Hash::Type::kSha512);
 
 std::string Target::custom_version() const {
   try {
-    return custom_["version"].asString();
+    return custom_data()["version"].asString();
   } catch (const std::exception &ex) {
     LOG_ERROR << "Unable to parse custom version: " << ex.what();
     return "";
@@ -182,10 +198,10 @@ std::string Target::custom_version() const {
 
 bool Target::IsOstree() const {
   // NOLINTNEXTLINE(bugprone-branch-clone)
-  if (type_ == "OSTREE") {
+  if (data_->type == "OSTREE") {
     // Modern servers explicitly specify the type of the target
     return true;
-  } else if (type_.empty() && length() == 0) {
+  } else if (data_->type.empty() && length() == 0) {
     // Older servers don't specify the type of the target. Assume that it is
     // an OSTree target if the length is zero.
     return true;
@@ -197,16 +213,16 @@ bool Target::IsOstree() const {
 }
 
 bool Target::MatchTarget(const Target &t2) const {
-  // type_ (targetFormat) is only provided by the Image repo.
-  // ecus_ is only provided by the Image repo.
-  // correlation_id_ is only provided by the Director.
-  // uri_ is not matched. If the Director provides it, we use that. If not, but
+  // type (targetFormat) is only provided by the Image repo.
+  // ecus is only provided by the Image repo.
+  // correlation_id is only provided by the Director.
+  // uri is not matched. If the Director provides it, we use that. If not, but
   // the Image repository does, use that. Otherwise, leave it empty and use the
   // default.
-  if (filename_ != t2.filename_) {
+  if (data_->filename != t2.data_->filename) {
     return false;
   }
-  if (length_ != t2.length_) {
+  if (data_->length != t2.data_->length) {
     return false;
   }
 
@@ -215,15 +231,15 @@ bool Target::MatchTarget(const Target &t2) const {
   // empty) and a Target from the Image repo (HWID vector populated,
   // ECU->HWID map empty). Figure out which Target has the map, and then for
   // every item in the map, make sure it's in the other Target's HWID vector.
-  if (hwids_ != t2.hwids_ || ecus_ != t2.ecus_) {
+  if (data_->hwids != t2.data_->hwids || data_->ecus != t2.data_->ecus) {
     std::shared_ptr<EcuMap> ecu_map;                               // Director
     std::shared_ptr<std::vector<HardwareIdentifier>> hwid_vector;  // Image repo
-    if (!hwids_.empty() && ecus_.empty() && t2.hwids_.empty() && !t2.ecus_.empty()) {
-      ecu_map = std::make_shared<EcuMap>(t2.ecus_);
-      hwid_vector = std::make_shared<std::vector<HardwareIdentifier>>(hwids_);
-    } else if (!t2.hwids_.empty() && t2.ecus_.empty() && hwids_.empty() && !ecus_.empty()) {
-      ecu_map = std::make_shared<EcuMap>(ecus_);
-      hwid_vector = std::make_shared<std::vector<HardwareIdentifier>>(t2.hwids_);
+    if (!data_->hwids.empty() && data_->ecus.empty() && t2.data_->hwids.empty() && !t2.data_->ecus.empty()) {
+      ecu_map = std::make_shared<EcuMap>(t2.data_->ecus);
+      hwid_vector = std::make_shared<std::vector<HardwareIdentifier>>(data_->hwids);
+    } else if (!t2.data_->hwids.empty() && t2.data_->ecus.empty() && data_->hwids.empty() && !data_->ecus.empty()) {
+      ecu_map = std::make_shared<EcuMap>(data_->ecus);
+      hwid_vector = std::make_shared<std::vector<HardwareIdentifier>>(t2.data_->hwids);
     } else {
       return false;
     }
@@ -239,8 +255,8 @@ bool Target::MatchTarget(const Target &t2) const {
   // - all hashes of the same type should match
   // - at least one pair of hashes should match
   bool oneMatchingHash = false;
-  for (const Hash &hash : hashes_) {
-    for (const Hash &hash2 : t2.hashes_) {
+  for (const Hash &hash : data_->hashes) {
+    for (const Hash &hash2 : t2.data_->hashes) {
       if (hash.type() == hash2.type() && !(hash == hash2)) {
         return false;
       }
@@ -254,40 +270,40 @@ bool Target::MatchTarget(const Target &t2) const {
 
 Json::Value Target::toDebugJson() const {
   Json::Value res;
-  for (const auto &ecu : ecus_) {
+  for (const auto &ecu : data_->ecus) {
     res["custom"]["ecuIdentifiers"][ecu.first.ToString()]["hardwareId"] = ecu.second.ToString();
   }
-  if (!hwids_.empty()) {
+  if (!data_->hwids.empty()) {
     Json::Value hwids;
-    for (Json::Value::ArrayIndex i = 0; i < static_cast<Json::Value::ArrayIndex>(hwids_.size()); ++i) {
-      hwids[i] = hwids_[i].ToString();
+    for (Json::Value::ArrayIndex i = 0; i < static_cast<Json::Value::ArrayIndex>(data_->hwids.size()); ++i) {
+      hwids[i] = data_->hwids[i].ToString();
     }
     res["custom"]["hardwareIds"] = hwids;
   }
-  res["custom"]["targetFormat"] = type_;
+  res["custom"]["targetFormat"] = data_->type;
 
-  for (const auto &hash : hashes_) {
+  for (const auto &hash : data_->hashes) {
     res["hashes"][hash.TypeString()] = hash.HashString();
   }
-  res["length"] = Json::Value(static_cast<Json::Value::Int64>(length_));
+  res["length"] = Json::Value(static_cast<Json::Value::Int64>(data_->length));
   return res;
 }
 
 std::ostream &Uptane::operator<<(std::ostream &os, const Target &t) {
-  os << "Target(" << t.filename_;
+  os << "Target(" << t.data_->filename;
   os << " ecu_identifiers: (";
-  for (const auto &ecu : t.ecus_) {
+  for (const auto &ecu : t.data_->ecus) {
     os << ecu.first << " (hw_id: " << ecu.second << "), ";
   }
   os << ")"
      << " hw_ids: (";
-  for (const auto &hwid : t.hwids_) {
+  for (const auto &hwid : t.data_->hwids) {
     os << hwid << ", ";
   }
   os << ")"
      << " length:" << t.length();
   os << " hashes: (";
-  for (const auto &hash : t.hashes_) {
+  for (const auto &hash : t.data_->hashes) {
     os << hash << ", ";
   }
   os << "))";
@@ -328,9 +344,11 @@ void Uptane::Targets::init(const Json::Value &json) {
   }
 
   const Json::Value target_list = json["signed"]["targets"];
+  targets_.reserve(target_list.size());
+  filename_index_.reserve(target_list.size());
   for (auto t_it = target_list.begin(); t_it != target_list.end(); t_it++) {
-    Target t(t_it.key().asString(), *t_it);
-    targets.push_back(t);
+    targets_.emplace_back(t_it.key().asString(), *t_it);
+    filename_index_.emplace(targets_.back().filename(), targets_.size() - 1);
   }
 
   if (json["signed"]["delegations"].isObject()) {
@@ -353,6 +371,12 @@ void Uptane::Targets::init(const Json::Value &json) {
 
       terminating_role_[role] = (*it)["terminating"].asBool();
     }
+
+    for (size_t i = 0; i < delegated_role_names_.size(); ++i) {
+      for (const auto &path : paths_for_role_[Role::Delegation(delegated_role_names_[i])]) {
+        delegation_paths_.add(i, path);
+      }
+    }
   }
 
   if (json["signed"]["custom"].isObject()) {
@@ -364,6 +388,22 @@ void Uptane::Targets::init(const Json::Value &json) {
 
 Uptane::Targets::Targets(const Json::Value &json) : MetaWithKeys(json) { init(json); }
 
+const Uptane::Target *Uptane::Targets::findTarget(const Target &target) const {
+  const auto it = filename_index_.find(target.filename());
+  if (it == filename_index_.end() || !targets_[it->second].MatchTarget(target)) {
+    return nullptr;
+  }
+  return &targets_[it->second];
+}
+
+std::vector<std::string> Uptane::Targets::matchingDelegations(const std::string &filename) const {
+  std::vector<std::string> names;
+  for (const size_t idx : delegation_paths_.match(filename)) {
+    names.push_back(delegated_role_names_[idx]);
+  }
+  return names;
+}
+
 Uptane::Targets::Targets(RepositoryType repo, const Role &role, const Json::Value &json,
                          const std::shared_ptr<MetaWithKeys> &signer)
     : MetaWithKeys(repo, role, json, signer), name_(role.ToString()) {
@@ -15,6 +15,7 @@
 #include "crypto/crypto.h"
 #include "libaktualizr/types.h"
 #include "uptane/exceptions.h"
+#include "uptane/pathmatcher.h"
 
 namespace Uptane {
 
@@ -276,22 +277,39 @@ class Targets : public MetaWithKeys {
   ~Targets() override = default;
 
   bool operator==(const Targets &rhs) const {
-    return version_ == rhs.version() && expiry_ == rhs.expiry() && MatchTargetVector(targets, rhs.targets);
+    return version_ == rhs.version() && expiry_ == rhs.expiry() && MatchTargetVector(targets_, rhs.targets_);
   }
 
   const std::string &correlation_id() const { return correlation_id_; }
+  /** Name of the role this metadata was verified for. */
+  const std::string &name() const { return name_; }
 
   void clear() {
-    targets.clear();
+    targets_.clear();
     delegated_role_names_.clear();
     paths_for_role_.clear();
     terminating_role_.clear();
+    filename_index_.clear();
+    delegation_paths_.clear();
   }
 
+  /**
+   * Find the Target matching the given one according to Target::MatchTarget().
+   * Looks the candidate up by filename, so the cost does not depend on the
+   * number of Targets. Returns nullptr if there is no match.
+   */
+  const Target *findTarget(const Target &target) const;
+
+  /**
+   * Names of the delegated roles with a path pattern that matches filename,
+   * in the order the delegations are listed in.
+   */
+  std::vector<std::string> matchingDelegations(const std::string &filename) const;
+
   std::vector<Uptane::Target> getTargets(const Uptane::EcuSerial &ecu_id,
                                          const Uptane::HardwareIdentifier &hw_id) const {
     std::vector<Uptane::Target> result;
-    for (auto it = targets.begin(); it != targets.end(); ++it) {
+    for (auto it = targets_.begin(); it != targets_.end(); ++it) {
       auto found_loc = std::find_if(it->ecus().begin(), it->ecus().end(),
                                     [ecu_id, hw_id](const std::pair<EcuSerial, HardwareIdentifier> &val) {
                                       return ((ecu_id == val.first) && (hw_id == val.second));
@@ -304,7 +322,9 @@ class Targets : public MetaWithKeys {
     return result;
   }
 
-  std::vector<Uptane::Target> targets;
+  /** Targets in the order they are listed in. Read-only so that the lookup index stays valid. */
+  const std::vector<Uptane::Target> &targets() const { return targets_; }
+
   std::vector<std::string> delegated_role_names_;
   std::map<Role, std::vector<std::string>> paths_for_role_;
   std::map<Role, bool> terminating_role_;
@@ -314,6 +334,11 @@ class Targets : public MetaWithKeys {
 
   std::string name_;
   std::string correlation_id_;  // custom non-tuf
+  std::vector<Uptane::Target> targets_;
+  // Positions in targets_ by filename, built at parse time.
+  std::unordered_map<std::string, size_t> filename_index_;
+  // Path patterns of the roles in delegated_role_names_, by position.
+  PathMatcher delegation_paths_;
 };
 
 class TimestampMeta : public BaseMeta {
@@ -0,0 +1,160 @@
+#include <benchmark/benchmark.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <boost/algorithm/hex.hpp>
+
+#include "crypto/crypto.h"
+#include "crypto/keymanager.h"
+#include "libaktualizr/config.h"
+#include "storage/invstorage.h"
+#include "uptane/pathmatcher.h"
+#include "uptane/tuf.h"
+#include "utilities/utils.h"
+
+namespace {
+
+KeyType keyTypeArg(const benchmark::State &state) { return static_cast<KeyType>(state.range(0)); }
+
+void keyTypeArgs(benchmark::internal::Benchmark *b) {
+  b->Arg(static_cast<int64_t>(KeyType::kRSA2048))->Arg(static_cast<int64_t>(KeyType::kED25519));
+}
+
+/* Check the signature on Targets metadata with 64 targets against a Root that trusts a single key. */
+void BM_UnpackSignedObject(benchmark::State &state) {
+  TemporaryDirectory temp_dir;
+  Config config;
+  config.storage.path = temp_dir.Path();
+  config.uptane.key_type = keyTypeArg(state);
+  auto storage = INvStorage::newStorage(config.storage);
+  KeyManager keys(storage, config.keymanagerConfig());
+  keys.generateUptaneKeyPair();
+  const PublicKey public_key = keys.UptanePublicKey();
+
+  Json::Value root;
+  root["_type"] = "Root";
+  root["expires"] = "2038-01-19T03:14:06Z";
+  root["version"] = 1;
+  root["keys"][public_key.KeyId()] = public_key.ToUptane();
+  for (const std::string role : {"root", "snapshot", "targets", "timestamp"}) {
+    root["roles"][role]["keyids"][0] = public_key.KeyId();
+    root["roles"][role]["threshold"] = 1;
+  }
+  Uptane::Root trusted(Uptane::RepositoryType::Image(), keys.signTuf(root));
+
+  Json::Value targets;
+  targets["_type"] = "Targets";
+  targets["expires"] = "2038-01-19T03:14:06Z";
+  targets["version"] = 1;
+  for (int i = 0; i < 64; ++i) {
+    Json::Value &target = targets["targets"]["firmware-" + std::to_string(i) + ".bin"];
+    target["hashes"]["sha256"] = std::string(64, 'a');
+    target["length"] = 1024 * i;
+  }
+  const Json::Value signed_targets = keys.signTuf(targets);
+
+  for (auto _ : state) {
+    trusted.UnpackSignedObject(Uptane::RepositoryType::Image(), Uptane::Role::Targets(), signed_targets);
+  }
+}
+BENCHMARK(BM_UnpackSignedObject)->Apply(keyTypeArgs);
+
+/* Match a Director Target against Image repo Targets metadata with the given number of targets. */
+void BM_FindTarget(benchmark::State &state) {
+  const int count = static_cast<int>(state.range(0));
+  Json::Value targets;
+  targets["signed"]["_type"] = "Targets";
+  targets["signed"]["expires"] = "2038-01-19T03:14:06Z";
+  targets["signed"]["version"] = 1;
+  for (int i = 0; i < count; ++i) {
+    Json::Value &target = targets["signed"]["targets"]["firmware-" + std::to_string(i) + ".bin"];
+    target["hashes"]["sha256"] = boost::algorithm::hex(Crypto::sha256digest(std::to_string(i)));
+    target["length"] = 1024 * i;
+    target["custom"]["hardwareIds"][0] = "bench_hw";
+  }
+  const Uptane::Targets image_targets(targets);
+
+  Json::Value queried = targets["signed"]["targets"]["firmware-" + std::to_string(count - 1) + ".bin"];
+  queried.removeMember("custom");
+  queried["custom"]["ecuIdentifiers"]["bench_ecu"]["hardwareId"] = "bench_hw";
+  const Uptane::Target director_target("firmware-" + std::to_string(count - 1) + ".bin", queried);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(image_targets.findTarget(director_target));
+  }
+}
+BENCHMARK(BM_FindTarget)->Arg(16)->Arg(16384);
+
+#ifdef __GLIBC__
+size_t heapInUse() {
+#if __GLIBC_PREREQ(2, 33)
+  return mallinfo2().uordblks;
+#else
+  return static_cast<size_t>(mallinfo().uordblks);
+#endif
+}
+#else
+size_t heapInUse() { return 0; }
+#endif
+
+/* Parse Image repo Targets metadata with the given number of targets and copy
+ * the targets around the way the update check does. Reports the heap in use
+ * for the parsed metadata and for the copies (glibc only). */
+void BM_TargetsHeap(benchmark::State &state) {
+  const int count = static_cast<int>(state.range(0));
+  Json::Value targets;
+  targets["signed"]["_type"] = "Targets";
+  targets["signed"]["expires"] = "2038-01-19T03:14:06Z";
+  targets["signed"]["version"] = 1;
+  for (int i = 0; i < count; ++i) {
+    Json::Value &target = targets["signed"]["targets"]["firmware-" + std::to_string(i) + ".bin"];
+    target["hashes"]["sha256"] = boost::algorithm::hex(Crypto::sha256digest(std::to_string(i)));
+    target["length"] = 1024 * i;
+    target["custom"]["hardwareIds"][0] = "bench_hw";
+    target["custom"]["name"] = "firmware";
+    target["custom"]["version"] = std::to_string(i);
+    target["custom"]["targetFormat"] = "BINARY";
+    target["custom"]["createdAt"] = "2020-10-27T12:00:00Z";
+    target["custom"]["updatedAt"] = "2020-10-27T12:00:00Z";
+  }
+
+  size_t parsed_bytes = 0;
+  size_t copied_bytes = 0;
+  for (auto _ : state) {
+    const size_t before = heapInUse();
+    const Uptane::Targets image_targets(targets);
+    const size_t parsed = heapInUse();
+    std::vector<Uptane::Target> copies(image_targets.targets());
+    copies.insert(copies.end(), image_targets.targets().begin(), image_targets.targets().end());
+    const size_t copied = heapInUse();
+    parsed_bytes = parsed - before;
+    copied_bytes = copied - parsed;
+    benchmark::DoNotOptimize(copies.data());
+  }
+  state.counters["parsed_bytes"] = static_cast<double>(parsed_bytes);
+  state.counters["copied_bytes"] = static_cast<double>(copied_bytes);
+}
+BENCHMARK(BM_TargetsHeap)->Arg(1024)->Arg(16384);
+
+/* Find the delegated roles for a filename among the given number of roles with three path patterns each. */
+void BM_MatchDelegationPaths(benchmark::State &state) {
+  const auto roles = static_cast<size_t>(state.range(0));
+  Uptane::PathMatcher matcher;
+  for (size_t i = 0; i < roles; ++i) {
+    const std::string dir = "dir-" + std::to_string(i);
+    matcher.add(i, dir + "/*");
+    matcher.add(i, dir + "/firmware-[0-9]*.bin");
+    matcher.add(i, "*." + dir);
+  }
+  const std::string filename = "dir-" + std::to_string(roles / 2) + "/firmware-1.bin";
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(matcher.match(filename));
+  }
+}
+BENCHMARK(BM_MatchDelegationPaths)->Arg(16)->Arg(1024);
+
+}  // namespace
+
+BENCHMARK_MAIN();
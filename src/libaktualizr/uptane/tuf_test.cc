@@ -272,6 +272,39 @@ TEST(Target, HashMismatch) {
   EXPECT_FALSE(target2.MatchTarget(target1));
 }
 
+/* Targets are looked up by filename and by hash. */
+TEST(Targets, FindTarget) {
+  Uptane::HardwareIdentifier hwid("fake-test");
+  std::vector<Uptane::HardwareIdentifier> hardwareIds{hwid};
+  Uptane::EcuMap ecu_map{{Uptane::EcuSerial("serial"), hwid}};
+
+  Json::Value json;
+  json["signed"]["_type"] = "Targets";
+  json["signed"]["version"] = 1;
+  json["signed"]["expires"] = "2038-01-19T03:14:06Z";
+  for (int i = 0; i < 100; ++i) {
+    json["signed"]["targets"]["file" + std::to_string(i)] =
+        generateImageTarget("hash" + std::to_string(i), i, hardwareIds);
+  }
+  const Uptane::Targets targets(json);
+
+  const Uptane::Target director_target("file42", generateDirectorTarget("hash42", 42, ecu_map));
+  const Uptane::Target* found = targets.findTarget(director_target);
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->filename(), "file42");
+  EXPECT_TRUE(found->MatchTarget(director_target));
+
+  // A Target with the same filename has to match otherwise too.
+  EXPECT_EQ(targets.findTarget(Uptane::Target("file42", generateDirectorTarget("hash43", 42, ecu_map))), nullptr);
+  EXPECT_EQ(targets.findTarget(Uptane::Target("file42", generateDirectorTarget("hash42", 43, ecu_map))), nullptr);
+  EXPECT_EQ(targets.findTarget(Uptane::Target("file100", generateDirectorTarget("hash42", 42, ecu_map))), nullptr);
+
+  Uptane::Targets cleared(targets);
+  cleared.clear();
+  EXPECT_EQ(cleared.findTarget(director_target), nullptr);
+  EXPECT_NE(targets.findTarget(director_target), nullptr);
+}
+
 #ifndef __NO_MAIN__
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
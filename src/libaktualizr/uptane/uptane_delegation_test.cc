@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <map>
 #include <string>
 
 #include <boost/filesystem.hpp>
@@ -10,6 +11,7 @@
 #include "libaktualizr/events.h"
 
 #include "httpfake.h"
+#include "storage/sqlstorage.h"
 #include "uptane_test_common.h"
 
 boost::filesystem::path uptane_generator_path;
@@ -229,6 +231,47 @@ TEST(Delegation, IterateAll) {
   EXPECT_TRUE(expected_target_names.empty());
 }
 
+/* Each delegated role is loaded and verified only once per update cycle, however
+ * often the delegation tree is searched. */
+TEST(Delegation, VerifyOncePerCycle) {
+  class CountingStorage : public SQLStorage {
+   public:
+    explicit CountingStorage(const StorageConfig& config) : SQLStorage(config, false) {}
+    bool loadDelegation(std::string* data, Uptane::Role role) const override {
+      ++loads[role.ToString()];
+      return SQLStorage::loadDelegation(data, role);
+    }
+    mutable std::map<std::string, int> loads;
+  };
+
+  TemporaryDirectory temp_dir;
+  auto delegation_path = temp_dir.Path() / "delegation_test";
+  delegation_nested(delegation_path, false);
+  auto http = std::make_shared<HttpFakeDelegation>(temp_dir.Path());
+
+  Config conf = UptaneTestCommon::makeTestConfig(temp_dir, http->tls_server);
+
+  auto storage = std::make_shared<CountingStorage>(conf.storage);
+  UptaneTestCommon::TestAktualizr aktualizr(conf, storage, http);
+
+  aktualizr.Initialize();
+  result::UpdateCheck update_result = aktualizr.CheckUpdates().get();
+  EXPECT_EQ(update_result.status, result::UpdateStatus::kUpdatesAvailable);
+  for (int i = 0; i < 2; ++i) {
+    size_t count = 0;
+    for (auto& target : aktualizr.uptane_client()->allTargets()) {
+      (void)target;
+      ++count;
+    }
+    EXPECT_EQ(count, 10);
+  }
+
+  EXPECT_FALSE(storage->loads.empty());
+  for (const auto& load : storage->loads) {
+    EXPECT_EQ(load.second, 1) << load.first;
+  }
+}
+
 #ifndef __NO_MAIN__
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
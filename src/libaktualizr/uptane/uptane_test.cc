@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -1388,6 +1389,43 @@ TEST(Uptane, IgnoreUnknownUpdate) {
   EXPECT_EQ(report.ecu_reports.size(), 0);
 }
 
+/* Parse the Secondary concurrency limits per type and ignore invalid ones. */
+TEST(Uptane, ParseTypeLimits) {
+  using Limits = std::map<std::string, size_t>;
+  EXPECT_EQ(SotaUptaneClient::parseTypeLimits(""), Limits());
+  EXPECT_EQ(SotaUptaneClient::parseTypeLimits("IP:4,virtual:1"), (Limits{{"IP", 4}, {"virtual", 1}}));
+  EXPECT_EQ(SotaUptaneClient::parseTypeLimits(" IP : 4 ,, virtual:1, "), (Limits{{"IP", 4}, {"virtual", 1}}));
+  EXPECT_EQ(SotaUptaneClient::parseTypeLimits("IP:4,IP:2"), (Limits{{"IP", 2}}));
+  EXPECT_EQ(SotaUptaneClient::parseTypeLimits("IP,virtual:"), Limits());
+  EXPECT_EQ(SotaUptaneClient::parseTypeLimits("IP:x,:3,virtual:-1,mock:4x"), Limits());
+  EXPECT_EQ(SotaUptaneClient::parseTypeLimits("IP:99999999999999999999999,virtual:2"), (Limits{{"virtual", 2}}));
+}
+
+/* Installations on critical ECUs are started first, then optionally the
+ * largest images first, otherwise in the order of the reports. */
+TEST(Uptane, SecondaryInstallOrder) {
+  std::vector<result::Install::EcuReport> reports;
+  const std::vector<std::pair<std::string, int64_t>> ecus{{"ecu0", 10}, {"ecu1", 30}, {"ecu2", 20},
+                                                          {"ecu3", 30}, {"ecu4", 5},  {"ecu5", 20}};
+  for (const auto &ecu : ecus) {
+    Json::Value target_json;
+    target_json["hashes"]["sha256"] = "hash";
+    target_json["length"] = Json::Int64(ecu.second);
+    reports.emplace_back(Uptane::Target("target-" + ecu.first, target_json), Uptane::EcuSerial(ecu.first),
+                         data::InstallationResult());
+  }
+
+  using Order = std::vector<size_t>;
+  EXPECT_EQ(SotaUptaneClient::secondaryInstallOrder(reports, "default", ""), (Order{0, 1, 2, 3, 4, 5}));
+  // Unknown orders fall back to the default.
+  EXPECT_EQ(SotaUptaneClient::secondaryInstallOrder(reports, "smallest_first", ""), (Order{0, 1, 2, 3, 4, 5}));
+  // Images of the same size keep their order.
+  EXPECT_EQ(SotaUptaneClient::secondaryInstallOrder(reports, "largest_first", ""), (Order{1, 3, 2, 5, 0, 4}));
+  EXPECT_EQ(SotaUptaneClient::secondaryInstallOrder(reports, "default", "ecu4, ecu2"), (Order{2, 4, 0, 1, 3, 5}));
+  EXPECT_EQ(SotaUptaneClient::secondaryInstallOrder(reports, "largest_first", "ecu4,ecu5,unknown"),
+            (Order{5, 4, 1, 3, 2, 0}));
+}
+
 #ifdef BUILD_P11
 TEST(Uptane, Pkcs11Provision) {
   Config config;
@@ -60,15 +60,17 @@ void RepositoryCommon::resetRoot() { root = Root(Root::Policy::kAcceptAll); }
 void RepositoryCommon::updateRoot(INvStorage& storage, const IMetadataFetcher& fetcher,
                                   const RepositoryType repo_type) {
   // 5.4.4.3.1. Load the previous Root metadata file.
-  {
-    std::string root_raw;
-    if (storage.loadLatestRoot(&root_raw, repo_type)) {
-      initRoot(repo_type, root_raw);
+  std::string latest_root_raw;
+  if (storage.loadLatestRoot(&latest_root_raw, repo_type)) {
+    if (!verified_root_raw_.empty() && latest_root_raw == verified_root_raw_) {
+      root = verified_root_;
     } else {
-      fetcher.fetchRole(&root_raw, kMaxRootSize, repo_type, Role::Root(), Version(1));
-      initRoot(repo_type, root_raw);
-      storage.storeRoot(root_raw, repo_type, Version(1));
+      initRoot(repo_type, latest_root_raw);
     }
+  } else {
+    fetcher.fetchRole(&latest_root_raw, kMaxRootSize, repo_type, Role::Root(), Version(1));
+    initRoot(repo_type, latest_root_raw);
+    storage.storeRoot(latest_root_raw, repo_type, Version(1));
   }
 
   // 5.4.4.3.2. Update to the latest Root metadata file.
@@ -87,7 +89,10 @@ void RepositoryCommon::updateRoot(INvStorage& storage, const IMetadataFetcher& f
     // file.
     storage.storeRoot(root_raw, repo_type, Version(version));
     storage.clearNonRootMeta(repo_type);
+    latest_root_raw = std::move(root_raw);
   }
+  verified_root_raw_ = std::move(latest_root_raw);
+  verified_root_ = root;
 
   // 5.4.4.3.3. Check that the current (or latest securely attested) time is
   // lower than the expiration timestamp in the latest Root metadata file.
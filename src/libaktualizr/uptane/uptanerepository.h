@@ -25,6 +25,12 @@ class RepositoryCommon {
 
   Root root;
   RepositoryType type;
+
+ private:
+  // The latest Root metadata verified by updateRoot(), so that it is not
+  // parsed and verified again as long as the stored copy is unchanged.
+  std::string verified_root_raw_;
+  Root verified_root_;
 };
 }  // namespace Uptane
 
@@ -48,6 +48,74 @@ TEST(Types, ResultCode) {
   EXPECT_EQ(data::ResultCode::fromRepr("OK"), data::ResultCode(data::ResultCode::Numeric::kUnknown, "OK"));
 }
 
+static Uptane::Target makeTarget() {
+  Json::Value target_json;
+  target_json["hashes"]["sha256"] = "4c5eed7a9f8e4c7c7a2b5b1e8e46bbd0bb4b3f6f1ae8a5e8cfae2c0d0e7a5c3b";
+  target_json["length"] = 123;
+  target_json["custom"]["targetFormat"] = "BINARY";
+  target_json["custom"]["uri"] = "https://example.com/original";
+  target_json["custom"]["version"] = "1.0";
+  target_json["custom"]["ecuIdentifiers"]["ecu1"]["hardwareId"] = "hw1";
+  Uptane::Target target("target", target_json);
+  target.setCorrelationId("original-id");
+  return target;
+}
+
+/* Copies of a Target share their data until one of them is modified. */
+TEST(Types, TargetCopiesShareData) {
+  const Uptane::Target original = makeTarget();
+  const Uptane::Target copy = original;  // NOLINT(performance-unnecessary-copy-initialization)
+  Uptane::Target assigned = Uptane::Target::Unknown();
+  assigned = original;
+
+  EXPECT_EQ(&copy.hashes(), &original.hashes());
+  EXPECT_EQ(&copy.ecus(), &original.ecus());
+  EXPECT_EQ(&assigned.ecus(), &original.ecus());
+  EXPECT_TRUE(copy.MatchTarget(original));
+  EXPECT_EQ(copy.custom_version(), "1.0");
+}
+
+/* Modifying a copy of a Target leaves the original unchanged. */
+TEST(Types, TargetCopyOnWrite) {
+  const Uptane::Target original = makeTarget();
+
+  Uptane::Target uri_copy = original;
+  uri_copy.setUri("https://example.com/changed");
+  EXPECT_EQ(uri_copy.uri(), "https://example.com/changed");
+  EXPECT_EQ(original.uri(), "https://example.com/original");
+  EXPECT_NE(&uri_copy.ecus(), &original.ecus());
+
+  Uptane::Target correlation_copy = original;
+  correlation_copy.setCorrelationId("changed-id");
+  EXPECT_EQ(correlation_copy.correlation_id(), "changed-id");
+  EXPECT_EQ(original.correlation_id(), "original-id");
+
+  Uptane::Target ecu_copy = original;
+  ecu_copy.InsertEcu({Uptane::EcuSerial("ecu2"), Uptane::HardwareIdentifier("hw2")});
+  EXPECT_EQ(ecu_copy.ecus().size(), 2);
+  EXPECT_TRUE(ecu_copy.IsForEcu(Uptane::EcuSerial("ecu2")));
+  EXPECT_EQ(original.ecus().size(), 1);
+  EXPECT_FALSE(original.IsForEcu(Uptane::EcuSerial("ecu2")));
+
+  Json::Value custom = original.custom_data();
+  custom["version"] = "2.0";
+  Uptane::Target custom_copy = original;
+  custom_copy.updateCustom(custom);
+  EXPECT_EQ(custom_copy.custom_version(), "2.0");
+  EXPECT_EQ(original.custom_version(), "1.0");
+
+  // Copies of the modified copy share its new data.
+  const Uptane::Target second_copy = ecu_copy;  // NOLINT(performance-unnecessary-copy-initialization)
+  EXPECT_EQ(&second_copy.ecus(), &ecu_copy.ecus());
+  EXPECT_EQ(second_copy.ecus().size(), 2);
+
+  // The original is untouched by all of the above.
+  EXPECT_EQ(original.uri(), "https://example.com/original");
+  EXPECT_EQ(original.correlation_id(), "original-id");
+  EXPECT_EQ(original.ecus().size(), 1);
+  EXPECT_EQ(original.custom_data()["targetFormat"].asString(), "BINARY");
+}
+
 #ifndef __NO_MAIN__
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
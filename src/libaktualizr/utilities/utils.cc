@@ -678,6 +678,80 @@ void Utils::removeFileFromArchive(const boost::filesystem::path &archive_path, c
   }
 }
 
+std::string Utils::gzipCompress(const std::string &data) {
+  StructGuardInt<struct archive> a(archive_write_new(), archive_write_free);
+  if (a == nullptr) {
+    LOG_ERROR << "archive error: could not initialize archive object";
+    throw std::runtime_error("archive error");
+  }
+  archive_write_set_format_raw(a.get());
+  archive_write_add_filter_gzip(a.get());
+  // Don't pad the output to a full block.
+  archive_write_set_bytes_in_last_block(a.get(), 1);
+
+  std::ostringstream out;
+  int r = archive_write_open(a.get(), reinterpret_cast<void *>(&out), nullptr, write_cb, nullptr);
+  if (r != ARCHIVE_OK) {
+    LOG_ERROR << "archive error: " << archive_error_string(a.get());
+    throw std::runtime_error("archive error");
+  }
+
+  StructGuard<struct archive_entry> entry(archive_entry_new(), archive_entry_free);
+  archive_entry_set_filetype(entry.get(), AE_IFREG);
+  archive_entry_set_size(entry.get(), static_cast<ssize_t>(data.size()));
+  if (archive_write_header(a.get(), entry.get()) != ARCHIVE_OK ||
+      archive_write_data(a.get(), data.data(), data.size()) < 0 || archive_write_close(a.get()) != ARCHIVE_OK) {
+    LOG_ERROR << "archive error: " << archive_error_string(a.get());
+    throw std::runtime_error("archive error");
+  }
+  return out.str();
+}
+
+std::string Utils::gzipDecompress(const std::string &data, const size_t max_size) {
+  StructGuardInt<struct archive> a(archive_read_new(), archive_read_free);
+  if (a == nullptr) {
+    LOG_ERROR << "archive error: could not initialize archive object";
+    throw std::runtime_error("archive error");
+  }
+  archive_read_support_filter_gzip(a.get());
+  archive_read_support_format_raw(a.get());
+  // The raw format does not recognize empty data.
+  archive_read_support_format_empty(a.get());
+
+  std::string result;
+  struct archive_entry *entry;
+  if (archive_read_open_memory(a.get(), data.data(), data.size()) != ARCHIVE_OK) {
+    LOG_ERROR << "archive error: " << archive_error_string(a.get());
+    throw std::runtime_error("archive error");
+  }
+  const int r = archive_read_next_header(a.get(), &entry);
+  if (r == ARCHIVE_EOF) {
+    return result;
+  }
+  if (r != ARCHIVE_OK) {
+    LOG_ERROR << "archive error: " << archive_error_string(a.get());
+    throw std::runtime_error("archive error");
+  }
+
+  std::array<char, BSIZE> buf{};
+  for (;;) {
+    const la_ssize_t size = archive_read_data(a.get(), buf.data(), buf.size());
+    if (size < 0) {
+      LOG_ERROR << "archive error: " << archive_error_string(a.get());
+      throw std::runtime_error("archive error");
+    }
+    if (size == 0) {
+      break;
+    }
+    if (result.size() + static_cast<size_t>(size) > max_size) {
+      throw std::runtime_error("Decompressed data exceeds the maximum size of " + std::to_string(max_size) +
+                               " bytes");
+    }
+    result.append(buf.data(), static_cast<size_t>(size));
+  }
+  return result;
+}
+
 sockaddr_storage Utils::ipGetSockaddr(int fd) {
   sockaddr_storage ss{};
   socklen_t len = sizeof(ss);
@@ -32,6 +32,9 @@ struct Utils {
   static std::string readFileFromArchive(std::istream &as, const std::string &filename, bool trim = false);
   static void writeArchive(const std::map<std::string, std::string> &entries, std::ostream &as);
   static void removeFileFromArchive(const boost::filesystem::path &archive_path, const std::string &filename);
+  static std::string gzipCompress(const std::string &data);
+  // Throws if the data is invalid or decompresses to more than max_size bytes.
+  static std::string gzipDecompress(const std::string &data, size_t max_size);
   static Json::Value getHardwareInfo();
   static Json::Value getNetworkInfo();
   static std::string getHostname();
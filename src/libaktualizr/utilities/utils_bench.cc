@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+
+#include "utilities/dequeue_buffer.h"
+#include "utilities/utils.h"
+
+namespace {
+
+/* Targets metadata with the given number of targets, similar to what the Image repository serves. */
+Json::Value targetsMetadata(int64_t num_targets) {
+  Json::Value targets;
+  targets["_type"] = "Targets";
+  targets["expires"] = "2038-01-19T03:14:06Z";
+  targets["version"] = 42;
+  for (int64_t i = 0; i < num_targets; ++i) {
+    Json::Value &target = targets["targets"]["firmware-" + std::to_string(i) + ".bin"];
+    target["hashes"]["sha256"] = std::string(64, 'a');
+    target["hashes"]["sha512"] = std::string(128, 'b');
+    target["length"] = static_cast<Json::UInt64>(1024 * i);
+    target["custom"]["hardwareIds"][0] = "primary_hw";
+    target["custom"]["targetFormat"] = "BINARY";
+    target["custom"]["version"] = std::to_string(i);
+  }
+  return targets;
+}
+
+void BM_JsonToCanonicalStr(benchmark::State &state) {
+  const Json::Value targets = targetsMetadata(state.range(0));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    bytes += Utils::jsonToCanonicalStr(targets).size();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_JsonToCanonicalStr)->Arg(16)->Arg(1024);
+
+void BM_ParseJSON(benchmark::State &state) {
+  const std::string targets = Utils::jsonToCanonicalStr(targetsMetadata(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Utils::parseJSON(targets));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * targets.size()));
+}
+BENCHMARK(BM_ParseJSON)->Arg(16)->Arg(1024);
+
+/* Fill the buffer with chunks of the given size and consume them, as Asn1Rpc() does with received data. */
+void BM_DequeueBuffer(benchmark::State &state) {
+  const std::string chunk(static_cast<size_t>(state.range(0)), 'x');
+  DequeueBuffer buffer;
+  for (auto _ : state) {
+    memcpy(buffer.Tail(), chunk.data(), chunk.size());
+    buffer.HaveEnqueued(chunk.size());
+    benchmark::DoNotOptimize(buffer.Head());
+    buffer.Consume(buffer.Size());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DequeueBuffer)->Arg(64)->Arg(1024)->Arg(4096);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -215,6 +215,21 @@ TEST(Utils, ArchiveRemoveFile) {
   }
 }
 
+/* Compress and decompress data in memory with gzip. */
+TEST(Utils, Gzip) {
+  std::string data;
+  for (int i = 0; i < 10000; ++i) {
+    data += "{\"target" + std::to_string(i) + "\": {\"length\": " + std::to_string(i * 17) + "}}";
+  }
+  const std::string compressed = Utils::gzipCompress(data);
+  EXPECT_LT(compressed.size(), data.size() / 4);
+  EXPECT_EQ(Utils::gzipDecompress(compressed, data.size()), data);
+  EXPECT_THROW(Utils::gzipDecompress(compressed, data.size() - 1), std::runtime_error);
+
+  EXPECT_EQ(Utils::gzipDecompress(Utils::gzipCompress(""), 0), "");
+  EXPECT_THROW(Utils::gzipDecompress(compressed.substr(0, compressed.size() / 2), data.size()), std::runtime_error);
+}
+
 /* Create a temporary directory. */
 TEST(Utils, TemporaryDirectory) {
   boost::filesystem::path p;
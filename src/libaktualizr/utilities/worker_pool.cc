@@ -0,0 +1,96 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include "logging/logging.h"
+
+using Clock = std::chrono::steady_clock;
+
+static void runJob(const std::function<void()>& job) {
+  try {
+    job();
+  } catch (const std::exception& ex) {
+    LOG_ERROR << "Unhandled exception in worker job: " << ex.what();
+  }
+}
+
+static std::chrono::milliseconds toMs(Clock::duration d) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(d);
+}
+
+std::vector<WorkerPool::JobTimes> WorkerPool::run() {
+  std::vector<Job> jobs;
+  jobs.swap(jobs_);
+  std::vector<JobTimes> times(jobs.size());
+  const Clock::time_point queued = Clock::now();
+  const size_t workers = std::min(max_workers_, jobs.size());
+  if (workers <= 1) {
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      const Clock::time_point start = Clock::now();
+      runJob(jobs[i].run);
+      times[i].queued = toMs(start - queued);
+      times[i].active = toMs(Clock::now() - start);
+    }
+    return times;
+  }
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::list<size_t> pending;
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    pending.push_back(i);
+  }
+  std::map<std::string, size_t> running;
+
+  // Take the first pending job whose group is not at its limit, if any.
+  auto next_job = [this, &jobs, &pending, &running](size_t* job) {
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+      const std::string& group = jobs[*it].group;
+      auto limit = group_limits_.find(group);
+      if (limit == group_limits_.end() || running[group] < limit->second) {
+        *job = *it;
+        pending.erase(it);
+        running[group]++;
+        return true;
+      }
+    }
+    return false;
+  };
+
+  auto worker = [&]() {
+    std::unique_lock<std::mutex> lock(m);
+    for (;;) {
+      size_t current;
+      if (!next_job(&current)) {
+        if (pending.empty()) {
+          return;
+        }
+        cv.wait(lock);
+        continue;
+      }
+      lock.unlock();
+      const Clock::time_point start = Clock::now();
+      runJob(jobs[current].run);
+      const Clock::time_point end = Clock::now();
+      lock.lock();
+      times[current].queued = toMs(start - queued);
+      times[current].active = toMs(end - start);
+      running[jobs[current].group]--;
+      cv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(workers);
+  for (size_t i = 0; i < workers; ++i) {
+    threads.emplace_back(worker);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return times;
+}
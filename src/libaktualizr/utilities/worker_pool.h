@@ -0,0 +1,52 @@
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Runs a batch of jobs on a bounded number of threads.
+ *
+ * Jobs are started in the order they were added, each as soon as one of at
+ * most max_workers threads is free. A job can belong to a group with its own
+ * limit, in which case it is passed over by later jobs while that many jobs
+ * of its group are running. With a single worker, the jobs run one after
+ * another on the calling thread. Jobs are expected to report their results
+ * themselves; an exception escaping a job is logged and otherwise ignored.
+ */
+class WorkerPool {
+ public:
+  /** How long a job waited for a worker, and how long it ran. */
+  struct JobTimes {
+    std::chrono::milliseconds queued{0};
+    std::chrono::milliseconds active{0};
+  };
+
+  explicit WorkerPool(size_t max_workers) : max_workers_(max_workers > 0 ? max_workers : 1) {}
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  /** Run at most limit jobs of the given group at the same time. */
+  void setGroupLimit(const std::string& group, size_t limit) { group_limits_[group] = limit > 0 ? limit : 1; }
+  void add(std::function<void()> job, std::string group = "") {
+    jobs_.push_back(Job{std::move(job), std::move(group)});
+  }
+  /** Run all the jobs added so far and wait for them to complete. Returns the times in the order of the jobs. */
+  std::vector<JobTimes> run();
+
+ private:
+  struct Job {
+    std::function<void()> run;
+    std::string group;
+  };
+
+  const size_t max_workers_;
+  std::map<std::string, size_t> group_limits_;
+  std::vector<Job> jobs_;
+};
+
+#endif  // WORKER_POOL_H_
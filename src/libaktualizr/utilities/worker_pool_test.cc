@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "utilities/worker_pool.h"
+
+/* No more than max_workers jobs run at the same time, and all of them run. */
+TEST(WorkerPool, Bounded) {
+  WorkerPool pool(3);
+  std::atomic<int> active{0};
+  std::atomic<int> max_active{0};
+  std::atomic<int> done{0};
+  for (int i = 0; i < 12; ++i) {
+    pool.add([&]() {
+      const int now = ++active;
+      int prev = max_active.load();
+      while (now > prev && !max_active.compare_exchange_weak(prev, now)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      --active;
+      ++done;
+    });
+  }
+  pool.run();
+  EXPECT_EQ(done, 12);
+  EXPECT_EQ(max_active, 3);
+}
+
+/* With a single worker, jobs run in order on the calling thread. */
+TEST(WorkerPool, Sequential) {
+  WorkerPool pool(1);
+  std::vector<int> order;
+  const std::thread::id caller = std::this_thread::get_id();
+  for (int i = 0; i < 5; ++i) {
+    pool.add([&order, i, caller]() {
+      EXPECT_EQ(std::this_thread::get_id(), caller);
+      order.push_back(i);
+    });
+  }
+  pool.run();
+  EXPECT_EQ(order, std::vector<int>({0, 1, 2, 3, 4}));
+}
+
+/* A throwing job does not prevent the others from running. */
+TEST(WorkerPool, Exception) {
+  WorkerPool pool(2);
+  std::atomic<int> done{0};
+  pool.add([]() { throw std::runtime_error("failure"); });
+  for (int i = 0; i < 4; ++i) {
+    pool.add([&done]() { ++done; });
+  }
+  pool.run();
+  EXPECT_EQ(done, 4);
+
+  // The pool can be reused.
+  pool.add([&done]() { ++done; });
+  pool.run();
+  EXPECT_EQ(done, 5);
+}
+
+/* Jobs of a group with a limit are held back while the others are started. */
+TEST(WorkerPool, GroupLimit) {
+  WorkerPool pool(4);
+  pool.setGroupLimit("slow", 1);
+  std::mutex m;
+  std::vector<std::string> started;
+  std::atomic<int> slow_active{0};
+  std::atomic<int> slow_max_active{0};
+  // The slow jobs only finish once the job added after them has started, so
+  // that one must not be held back behind them.
+  std::promise<void> fast_started;
+  std::shared_future<void> fast_started_future = fast_started.get_future().share();
+  std::atomic<int> slow_saw_fast{0};
+  for (int i = 0; i < 3; ++i) {
+    pool.add(
+        [&]() {
+          {
+            std::lock_guard<std::mutex> lock(m);
+            started.emplace_back("slow");
+          }
+          const int now = ++slow_active;
+          int prev = slow_max_active.load();
+          while (now > prev && !slow_max_active.compare_exchange_weak(prev, now)) {
+          }
+          if (fast_started_future.wait_for(std::chrono::seconds(10)) == std::future_status::ready) {
+            ++slow_saw_fast;
+          }
+          --slow_active;
+        },
+        "slow");
+  }
+  pool.add([&]() {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      started.emplace_back("fast");
+    }
+    fast_started.set_value();
+  });
+  const std::vector<WorkerPool::JobTimes> times = pool.run();
+
+  EXPECT_EQ(slow_max_active, 1);
+  EXPECT_EQ(slow_saw_fast, 3);
+  ASSERT_EQ(started.size(), 4);
+  // Only the first slow job can have started before the fast one.
+  EXPECT_TRUE(started[0] == "fast" || started[1] == "fast");
+  EXPECT_EQ(started[2], "slow");
+  EXPECT_EQ(started[3], "slow");
+  EXPECT_EQ(times.size(), 4);
+}
+
+#ifndef __NO_MAIN__
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+#endif
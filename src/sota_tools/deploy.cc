@@ -1,5 +1,7 @@
 #include "deploy.h"
 
+#include <memory>
+
 #include <boost/filesystem.hpp>
 #include <boost/intrusive_ptr.hpp>
 
@@ -9,6 +11,7 @@
 #include "rate_controller.h"
 #include "request_pool.h"
 #include "treehub_server.h"
+#include "upload_journal.h"
 #include "utilities/utils.h"
 
 bool CheckPoolState(const OSTreeObject::ptr &root_object, const RequestPool &request_pool) {
@@ -24,7 +27,8 @@ bool CheckPoolState(const OSTreeObject::ptr &root_object, const RequestPool &req
 }
 
 bool UploadToTreehub(const OSTreeRepo::ptr &src_repo, TreehubServer &push_server, const OSTreeHash &ostree_commit,
-                     const RunMode mode, const int max_curl_requests) {
+                     const RunMode mode, const int max_curl_requests, const RateControlAlgorithm rate_control,
+                     const boost::filesystem::path &stats_json, const boost::filesystem::path &journal_path) {
   assert(max_curl_requests > 0);
 
   OSTreeObject::ptr root_object;
@@ -35,7 +39,21 @@ bool UploadToTreehub(const OSTreeRepo::ptr &src_repo, TreehubServer &push_server
     return false;
   }
 
-  RequestPool request_pool(push_server, max_curl_requests, mode);
+  std::unique_ptr<UploadJournal> journal;
+  if (!journal_path.empty() && mode == RunMode::kDefault) {
+    try {
+      journal = std_::make_unique<UploadJournal>(journal_path, push_server.root_url());
+      if (journal->resumed() > 0) {
+        LOG_INFO << "Resuming upload, " << journal->resumed() << " objects are already on the server according to "
+                 << journal_path;
+      }
+    } catch (const std::exception &ex) {
+      LOG_WARNING << ex.what() << ", the upload will not be resumable";
+    }
+  }
+
+  RequestPool request_pool(push_server, max_curl_requests, mode, rate_control);
+  request_pool.SetJournal(journal.get());
 
   // Add commit object to the queue.
   request_pool.AddQuery(root_object);
@@ -60,7 +78,24 @@ bool UploadToTreehub(const OSTreeRepo::ptr &src_repo, TreehubServer &push_server
     LOG_ERROR << "One or more errors while pushing";
   }
 
-  return root_object->is_on_server() == PresenceOnServer::kObjectPresent;
+  const bool succeeded = root_object->is_on_server() == PresenceOnServer::kObjectPresent;
+  if (succeeded && journal) {
+    request_pool.SetJournal(nullptr);
+    journal->Remove();
+  }
+  if (!stats_json.empty()) {
+    Json::Value stats = request_pool.stats().ToJson();
+    stats["succeeded"] = succeeded;
+    stats["head_requests"] = request_pool.head_requests_made();
+    stats["put_requests"] = request_pool.put_requests_made();
+    try {
+      Utils::writeFile(stats_json, stats, !stats_json.parent_path().empty());
+    } catch (const std::exception &ex) {
+      LOG_ERROR << "Could not write upload statistics to " << stats_json << ": " << ex.what();
+    }
+  }
+
+  return succeeded;
 }
 
 bool OfflineSignRepo(const ServerCredentials &push_credentials, const std::string &name, const OSTreeHash &hash,
@@ -3,9 +3,12 @@
 
 #include <string>
 
+#include <boost/filesystem.hpp>
+
 #include "garage_common.h"
 #include "ostree_ref.h"
 #include "ostree_repo.h"
+#include "rate_controller.h"
 #include "server_credentials.h"
 
 /*
@@ -25,9 +28,20 @@ bool CheckPoolState(const OSTreeObject::ptr& root_object, const RequestPool& req
  * \param ostree_commit
  * \param mode
  * \param max_curl_requests
+ * \param rate_control Congestion control algorithm used to pace the requests.
+ * \param stats_json If not empty, a JSON summary of the throughput, retries
+ *                   and request latencies is written to this file.
+ * \param journal_path If not empty, objects confirmed on the server are
+ *                     recorded in this file, and objects recorded by an
+ *                     earlier, interrupted run are not queried again. The file
+ *                     is removed once the upload succeeds. Only used in
+ *                     RunMode::kDefault.
  */
 bool UploadToTreehub(const OSTreeRepo::ptr& src_repo, TreehubServer& push_server, const OSTreeHash& ostree_commit,
-                     RunMode mode, int max_curl_requests);
+                     RunMode mode, int max_curl_requests,
+                     RateControlAlgorithm rate_control = RateControlAlgorithm::kAimd,
+                     const boost::filesystem::path& stats_json = boost::filesystem::path(),
+                     const boost::filesystem::path& journal_path = boost::filesystem::path());
 
 /**
  * Use the garage-sign tool and the Image repo targets.json keys in credentials.zip
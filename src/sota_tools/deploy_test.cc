@@ -43,6 +43,28 @@ TEST(deploy, UploadToTreehub) {
   EXPECT_EQ(result, 0) << "Diff between the source repo refs and the destination repos refs is nonzero.";
 }
 
+/* The journal of a successful upload is removed and the statistics are written out. */
+TEST(deploy, UploadToTreehubJournal) {
+  OSTreeRepo::ptr src_repo = std::make_shared<OSTreeDirRepo>("tests/sota_tools/repo");
+  boost::filesystem::path filepath = (temp_dir.Path() / "auth.json").string();
+  boost::filesystem::path cert_path = "tests/fake_http_server/server.crt";
+  auto server_creds = ServerCredentials(filepath);
+  auto test_ref = src_repo->GetRef("master");
+
+  TreehubServer push_server;
+  EXPECT_EQ(authenticate(cert_path.string(), server_creds, push_server), EXIT_SUCCESS);
+  TemporaryDirectory session_dir;
+  const boost::filesystem::path journal = session_dir / "journal";
+  const boost::filesystem::path stats = session_dir / "stats.json";
+  EXPECT_TRUE(UploadToTreehub(src_repo, push_server, test_ref.GetHash(), RunMode::kDefault, 2,
+                              RateControlAlgorithm::kAimd, stats, journal));
+
+  EXPECT_FALSE(boost::filesystem::exists(journal));
+  const Json::Value stats_json = Utils::parseJSONFile(stats);
+  EXPECT_TRUE(stats_json["succeeded"].asBool());
+  EXPECT_GE(stats_json["head_requests"].asInt(), 1);
+}
+
 #ifndef __NO_MAIN__
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
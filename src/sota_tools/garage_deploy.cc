@@ -26,6 +26,9 @@ int main(int argc, char **argv) {
   std::string hardwareids;
   std::string cacerts;
   int max_curl_requests;
+  RateControlAlgorithm rate_control;
+  boost::filesystem::path stats_json;
+  boost::filesystem::path journal;
   RunMode mode = RunMode::kDefault;
   po::options_description desc("garage-deploy command line options");
   // clang-format off
@@ -42,6 +45,9 @@ int main(int argc, char **argv) {
     ("hardwareids,h", po::value<std::string>(&hardwareids)->required(), "list of hardware ids")
     ("cacert", po::value<std::string>(&cacerts), "override path to CA root certificates, in the same format as curl --cacert")
     ("jobs", po::value<int>(&max_curl_requests)->default_value(30), "maximum number of parallel requests")
+    ("rate-control", po::value<RateControlAlgorithm>(&rate_control)->default_value(RateControlAlgorithm::kAimd), "algorithm used to adapt the number of parallel requests to the server: aimd or vegas")
+    ("stats-json", po::value<boost::filesystem::path>(&stats_json), "write a JSON summary of throughput, retries and request latencies to this file")
+    ("journal", po::value<boost::filesystem::path>(&journal), "record uploaded objects in this file, so that an interrupted upload can be resumed by running again with the same file")
     ("dry-run,n", "check arguments and authenticate but don't upload");
   // clang-format on
 
@@ -115,7 +121,7 @@ int main(int argc, char **argv) {
     // Since the fetches happen on a single thread in OSTreeHttpRepo, there
     // isn't much reason to upload in parallel, but why hold the system back if
     // the fetching is faster than the uploading?
-    if (!UploadToTreehub(src_repo, push_server, commit, mode, max_curl_requests)) {
+    if (!UploadToTreehub(src_repo, push_server, commit, mode, max_curl_requests, rate_control, stats_json, journal)) {
       LOG_FATAL << "Upload to treehub failed";
       return EXIT_FAILURE;
     }
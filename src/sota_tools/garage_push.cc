@@ -23,6 +23,9 @@ int main(int argc, char **argv) {
   std::string cacerts;
   boost::filesystem::path manifest_path;
   int max_curl_requests;
+  RateControlAlgorithm rate_control;
+  boost::filesystem::path stats_json;
+  boost::filesystem::path journal;
   RunMode mode = RunMode::kDefault;
   po::options_description desc("garage-push command line options");
   // clang-format off
@@ -38,6 +41,9 @@ int main(int argc, char **argv) {
     ("cacert", po::value<std::string>(&cacerts), "override path to CA root certificates, in the same format as curl --cacert")
     ("repo-manifest", po::value<boost::filesystem::path>(&manifest_path), "manifest describing repository branches used in the image, to be sent as attached metadata")
     ("jobs", po::value<int>(&max_curl_requests)->default_value(30), "maximum number of parallel requests")
+    ("rate-control", po::value<RateControlAlgorithm>(&rate_control)->default_value(RateControlAlgorithm::kAimd), "algorithm used to adapt the number of parallel requests to the server: aimd or vegas")
+    ("stats-json", po::value<boost::filesystem::path>(&stats_json), "write a JSON summary of throughput, retries and request latencies to this file")
+    ("journal", po::value<boost::filesystem::path>(&journal), "record uploaded objects in this file, so that an interrupted upload can be resumed by running again with the same file")
     ("dry-run,n", "check arguments and authenticate but don't upload")
     ("walk-tree,w", "walk entire tree and upload all missing objects");
   // clang-format on
@@ -135,7 +141,7 @@ int main(int argc, char **argv) {
       LOG_FATAL << "Authentication with push server failed";
       return EXIT_FAILURE;
     }
-    if (!UploadToTreehub(src_repo, push_server, *commit, mode, max_curl_requests)) {
+    if (!UploadToTreehub(src_repo, push_server, *commit, mode, max_curl_requests, rate_control, stats_json, journal)) {
       LOG_FATAL << "Upload to treehub failed";
       return EXIT_FAILURE;
     }
@@ -1,11 +1,13 @@
 #include "ostree_object.h"
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
 
 #include <glib.h>
+#include <boost/algorithm/string.hpp>
 
 #include "logging/logging.h"
 #include "ostree_repo.h"
@@ -14,6 +16,14 @@
 
 using std::string;
 
+namespace {
+// Objects at least this large are read and sent in bigger chunks than the
+// libcurl and stdio defaults, saving system calls and curl callbacks on
+// multi-megabyte files.
+const off_t kLargeObjectSize = 1024 * 1024;
+const long kLargeUploadBufferSize = 512 * 1024;  // NOLINT(google-runtime-int)
+}  // namespace
+
 OSTreeObject::OSTreeObject(const OSTreeRepo &repo, const std::string &object_name)
     : file_path_(repo.root() / "/objects/" / object_name),
       object_name_(object_name),
@@ -195,8 +205,11 @@ void OSTreeObject::MakeTestRequest(const TreehubServer &push_target, CURLM *curl
   curlEasySetoptWrapper(curl_handle_, CURLOPT_USERAGENT, Utils::getUserAgent());
   curlEasySetoptWrapper(curl_handle_, CURLOPT_WRITEFUNCTION, &OSTreeObject::curl_handle_write);
   curlEasySetoptWrapper(curl_handle_, CURLOPT_WRITEDATA, this);
+  curlEasySetoptWrapper(curl_handle_, CURLOPT_HEADERFUNCTION, &OSTreeObject::curl_handle_header);
+  curlEasySetoptWrapper(curl_handle_, CURLOPT_HEADERDATA, this);
   curlEasySetoptWrapper(curl_handle_, CURLOPT_PRIVATE, this);  // Used by ostree_object_from_curl
   http_response_.str("");                                      // Empty the response buffer
+  retry_after_ = std::chrono::seconds(0);
 
   const CURLMcode err = curl_multi_add_handle(curl_multi_handle, curl_handle_);
   if (err != 0) {
@@ -227,7 +240,10 @@ void OSTreeObject::Upload(TreehubServer &push_target, CURLM *curl_multi_handle,
   curlEasySetoptWrapper(curl_handle_, CURLOPT_USERAGENT, Utils::getUserAgent());
   curlEasySetoptWrapper(curl_handle_, CURLOPT_WRITEFUNCTION, &OSTreeObject::curl_handle_write);
   curlEasySetoptWrapper(curl_handle_, CURLOPT_WRITEDATA, this);
+  curlEasySetoptWrapper(curl_handle_, CURLOPT_HEADERFUNCTION, &OSTreeObject::curl_handle_header);
+  curlEasySetoptWrapper(curl_handle_, CURLOPT_HEADERDATA, this);
   http_response_.str("");  // Empty the response buffer
+  retry_after_ = std::chrono::seconds(0);
 
   struct stat file_info {};
   fd_ = fopen(file_path_.c_str(), "rb");
@@ -238,6 +254,14 @@ void OSTreeObject::Upload(TreehubServer &push_target, CURLM *curl_multi_handle,
       throw std::runtime_error("Could not get file information");
     }
   }
+  if (file_info.st_size >= kLargeObjectSize) {
+    if (setvbuf(fd_, nullptr, _IOFBF, static_cast<size_t>(kLargeUploadBufferSize)) != 0) {
+      LOG_DEBUG << "Could not enlarge the read buffer for " << object_name_;
+    }
+#if LIBCURL_VERSION_NUM >= 0x073e00  // CURLOPT_UPLOAD_BUFFERSIZE is available since 7.62.0
+    curlEasySetoptWrapper(curl_handle_, CURLOPT_UPLOAD_BUFFERSIZE, kLargeUploadBufferSize);
+#endif
+  }
   curlEasySetoptWrapper(curl_handle_, CURLOPT_READDATA, fd_);
   curlEasySetoptWrapper(curl_handle_, CURLOPT_POSTFIELDSIZE, file_info.st_size);
   curlEasySetoptWrapper(curl_handle_, CURLOPT_POST, 1);
@@ -295,6 +319,11 @@ void OSTreeObject::CurlDone(CURLM *curl_multi_handle, RequestPool &pool) {
   curl_easy_getinfo(curl_handle_, CURLINFO_EFFECTIVE_URL, &url);
   long rescode = 0;  // NOLINT(google-runtime-int)
   curl_easy_getinfo(curl_handle_, CURLINFO_RESPONSE_CODE, &rescode);
+  // Retry-After only asks for a pause together with 429 Too Many Requests or
+  // 503 Service Unavailable.
+  if (rescode != 429 && rescode != 503) {
+    retry_after_ = std::chrono::seconds(0);
+  }
   if (current_operation_ == CurrentOp::kOstreeObjectPresenceCheck) {
     // Sanity-check the handle's URL to make sure it contains the expected
     // object hash.
@@ -353,6 +382,26 @@ size_t OSTreeObject::curl_handle_write(void *buffer, size_t size, size_t nmemb,
   return size * nmemb;
 }
 
+// Only the delay-seconds form of Retry-After is supported; an HTTP-date is
+// ignored and the rate controller falls back to its own back-off.
+size_t OSTreeObject::curl_handle_header(char *buffer, size_t size, size_t nitems, void *userp) {
+  auto *that = static_cast<OSTreeObject *>(userp);
+  const size_t len = size * nitems;
+  const std::string header(buffer, len);
+  const std::string name = "retry-after:";
+  if (header.size() > name.size() && boost::algorithm::istarts_with(header, name)) {
+    const std::string value = boost::algorithm::trim_copy(header.substr(name.size()));
+    if (!value.empty() && std::all_of(value.begin(), value.end(), ::isdigit)) {
+      try {
+        that->retry_after_ = std::chrono::seconds(std::stol(value));
+      } catch (const std::out_of_range &) {
+        that->retry_after_ = std::chrono::seconds(0);
+      }
+    }
+  }
+  return len;
+}
+
 OSTreeObject::ptr ostree_object_from_curl(CURL *curlhandle) {
   void *p;
   curl_easy_getinfo(curlhandle, CURLINFO_PRIVATE, &p);
@@ -53,11 +53,18 @@ class OSTreeObject {
   uintmax_t GetSize() { return boost::filesystem::file_size(file_path_); }
 
   PresenceOnServer is_on_server() const { return is_on_server_; }
+  /* The object is known to be on the server without asking it, e.g. from the
+   * journal of a previous session. */
+  void MarkPresent() { is_on_server_ = PresenceOnServer::kObjectPresent; }
+  const std::string& name() const { return object_name_; }
   CurrentOp operation() const { return current_operation_; }
   bool children_ready() { return children_.empty(); }
   void LaunchNotify() { is_on_server_ = PresenceOnServer::kObjectInProgress; }
   std::chrono::steady_clock::time_point RequestStartTime() const { return request_start_time_; }
   ServerResponse LastOperationResult() const { return last_operation_result_; }
+  /* Delay requested by the server via a Retry-After header in the last
+   * response, if that was a 429 or a 503, or zero otherwise. */
+  std::chrono::seconds RetryAfter() const { return retry_after_; }
 
  private:
   using childiter = std::list<OSTreeObject::ptr>::iterator;
@@ -93,6 +100,7 @@ class OSTreeObject {
   void UploadError(RequestPool& pool, int64_t rescode);
 
   static size_t curl_handle_write(void* buffer, size_t size, size_t nmemb, void* userp);
+  static size_t curl_handle_header(char* buffer, size_t size, size_t nitems, void* userp);
 
   FRIEND_TEST(OstreeObject, Request);
   FRIEND_TEST(OstreeObject, UploadDryRun);
@@ -118,6 +126,7 @@ class OSTreeObject {
 
   std::chrono::steady_clock::time_point request_start_time_;
   ServerResponse last_operation_result_{ServerResponse::kNoResponse};
+  std::chrono::seconds retry_after_{0};
   OstreeObjectType type_{OstreeObjectType::OSTREE_OBJECT_TYPE_UNKNOWN};
 };
 
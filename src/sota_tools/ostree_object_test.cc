@@ -93,6 +93,48 @@ TEST(OstreeObject, MakeTestRequestMissing) {
   OstreeObject_Request_Test::MakeTestRequest(src_repo, hash, 404);
 }
 
+static std::chrono::seconds RetryAfterFromHead(const std::string& server_port, const OSTreeRepo::ptr& src_repo) {
+  TreehubServer push_server;
+  push_server.root_url("http://localhost:" + server_port);
+  RequestPool pool(push_server, 1, RunMode::kDefault);
+  CURLM* multi = curl_multi_init();
+  OSTreeObject::ptr object =
+      src_repo->GetObject(src_repo->GetRef("master").GetHash(), OstreeObjectType::OSTREE_OBJECT_TYPE_COMMIT);
+  object->MakeTestRequest(push_server, multi);
+
+  int running_requests;
+  do {
+    CURLMcode mc = curl_multi_perform(multi, &running_requests);
+    EXPECT_EQ(mc, CURLM_OK);
+  } while (running_requests > 0);
+
+  int msgs_in_queue;
+  do {
+    CURLMsg* msg = curl_multi_info_read(multi, &msgs_in_queue);
+    if ((msg != nullptr) && msg->msg == CURLMSG_DONE) {
+      ostree_object_from_curl(msg->easy_handle)->CurlDone(multi, pool);
+    }
+  } while (msgs_in_queue > 0);
+
+  curl_multi_cleanup(multi);
+  return object->RetryAfter();
+}
+
+/* A Retry-After header is only honored on a 503 (or 429) response, not on a
+ * successful one. */
+TEST(OstreeObject, RetryAfter) {
+  const std::string rp = TestUtils::getFreePort();
+  boost::process::child retry_server_process("tests/sota_tools/treehub_server.py", std::string("-p"), rp,
+                                             std::string("-d"), repo_path, std::string("-r"), std::string("7"));
+  TestUtils::waitForServer("http://localhost:" + rp + "/");
+
+  // Present: 200 with Retry-After.
+  EXPECT_EQ(RetryAfterFromHead(rp, std::make_shared<OSTreeDirRepo>(repo_path)), std::chrono::seconds(0));
+  // Missing: 503 with Retry-After.
+  EXPECT_EQ(RetryAfterFromHead(rp, std::make_shared<OSTreeDirRepo>("tests/sota_tools/bigger_repo")),
+            std::chrono::seconds(7));
+}
+
 /* Skip upload if dry run was specified. */
 TEST(OstreeObject, UploadDryRun) {
   TreehubServer push_server;
@@ -2,17 +2,63 @@
 
 #include <algorithm>  // min
 #include <cassert>
+#include <string>
 
 #include "logging/logging.h"
+#include "utilities/utils.h"
 
 const RateController::clock::duration RateController::kMaxSleepTime = std::chrono::seconds(30);
 
 const RateController::clock::duration RateController::kInitialSleepTime = std::chrono::seconds(1);
 
-RateController::RateController(const int concurrency_cap) : concurrency_cap_(concurrency_cap) { CheckInvariants(); }
+const RateController::clock::duration VegasRateController::kMaxRetryAfter = std::chrono::seconds(120);
 
-void RateController::RequestCompleted(const clock::time_point start_time, const clock::time_point end_time,
-                                      const bool succeeded) {
+std::ostream& operator<<(std::ostream& os, const RateControlAlgorithm algorithm) {
+  switch (algorithm) {
+    case RateControlAlgorithm::kAimd:
+      os << "aimd";
+      break;
+    case RateControlAlgorithm::kVegas:
+      os << "vegas";
+      break;
+    default:
+      os << "unknown";
+      break;
+  }
+  return os;
+}
+
+std::istream& operator>>(std::istream& is, RateControlAlgorithm& algorithm) {
+  std::string name;
+  is >> name;
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+  if (name == "aimd") {
+    algorithm = RateControlAlgorithm::kAimd;
+  } else if (name == "vegas") {
+    algorithm = RateControlAlgorithm::kVegas;
+  } else {
+    is.setstate(std::ios_base::failbit);
+  }
+  return is;
+}
+
+RateController::Ptr RateController::Create(const RateControlAlgorithm algorithm, const int concurrency_cap) {
+  switch (algorithm) {
+    case RateControlAlgorithm::kVegas:
+      return std_::make_unique<VegasRateController>(concurrency_cap);
+    case RateControlAlgorithm::kAimd:
+    default:
+      return std_::make_unique<AimdRateController>(concurrency_cap);
+  }
+}
+
+AimdRateController::AimdRateController(const int concurrency_cap) : concurrency_cap_(concurrency_cap) {
+  CheckInvariants();
+}
+
+void AimdRateController::RequestCompleted(const clock::time_point start_time, const clock::time_point end_time,
+                                          const bool succeeded) {
   if (last_concurrency_update_ < start_time) {
     const int prev_concurrency = max_concurrency_;
     last_concurrency_update_ = end_time;
@@ -33,23 +79,134 @@ void RateController::RequestCompleted(const clock::time_point start_time, const
   CheckInvariants();
 }
 
-int RateController::MaxConcurrency() const {
+int AimdRateController::MaxConcurrency() const {
   CheckInvariants();
   return max_concurrency_;
 }
 
-RateController::clock::duration RateController::GetSleepTime() const {
+RateController::clock::duration AimdRateController::GetSleepTime() const {
   CheckInvariants();
   return sleep_time_;
 }
 
-bool RateController::ServerHasFailed() const {
+bool AimdRateController::ServerHasFailed() const {
   CheckInvariants();
   return sleep_time_ > kMaxSleepTime;
 }
 
-void RateController::CheckInvariants() const {
+void AimdRateController::CheckInvariants() const {
   assert((sleep_time_ == clock::duration(0)) || (max_concurrency_ == 1));
   assert(0 < max_concurrency_);
   assert(max_concurrency_ <= concurrency_cap_);
 }
+
+VegasRateController::VegasRateController(const int concurrency_cap) : concurrency_cap_(concurrency_cap) {
+  CheckInvariants();
+}
+
+void VegasRateController::RequestCompleted(const clock::time_point start_time, const clock::time_point end_time,
+                                           const bool succeeded) {
+  last_completion_ = std::max(last_completion_, end_time);
+  if (pending_retry_after_ > clock::duration(0)) {
+    // Pause everything, but remember where we were.
+    if (max_concurrency_ > 1) {
+      resume_concurrency_ = std::max(1, max_concurrency_ / 2);
+    }
+    max_concurrency_ = 1;
+    slow_start_ = false;
+    paused_until_ = std::max(paused_until_, end_time + pending_retry_after_);
+    last_concurrency_update_ = end_time;
+    pending_retry_after_ = clock::duration(0);
+  }
+
+  if (!succeeded) {
+    OnFailure(start_time, end_time);
+    CheckInvariants();
+    return;
+  }
+
+  // Requests sent before the last change carry no new information.
+  if (!(last_concurrency_update_ < start_time)) {
+    CheckInvariants();
+    return;
+  }
+
+  const int prev_concurrency = max_concurrency_;
+  last_concurrency_update_ = end_time;
+  if (backoff_ > clock::duration(0) || paused_until_ != clock::time_point()) {
+    // First success after the server recovered.
+    backoff_ = clock::duration(0);
+    paused_until_ = clock::time_point();
+    max_concurrency_ = std::min(resume_concurrency_, concurrency_cap_);
+  } else {
+    const clock::duration rtt = end_time - start_time;
+    if (base_rtt_ == clock::duration::max()) {
+      base_rtt_ = rtt;
+    } else {
+      base_rtt_ += base_rtt_ / 100;
+    }
+    base_rtt_ = std::max(std::min(base_rtt_, rtt), clock::duration(1));
+
+    const double queued =
+        max_concurrency_ * (1.0 - std::chrono::duration<double>(base_rtt_) / std::chrono::duration<double>(rtt));
+    if (queued < kAlpha) {
+      max_concurrency_ = slow_start_ ? 2 * max_concurrency_ : max_concurrency_ + 1;
+    } else if (queued > kBeta) {
+      slow_start_ = false;
+      max_concurrency_ = max_concurrency_ - 1;
+    } else {
+      slow_start_ = false;
+    }
+    max_concurrency_ = std::max(1, std::min(max_concurrency_, concurrency_cap_));
+  }
+  resume_concurrency_ = max_concurrency_;
+
+  if (prev_concurrency != max_concurrency_) {
+    LOG_DEBUG << "Concurrency limit is now: " << max_concurrency_;
+  }
+  CheckInvariants();
+}
+
+void VegasRateController::OnFailure(const clock::time_point start_time, const clock::time_point end_time) {
+  if (!(last_concurrency_update_ < start_time)) {
+    return;
+  }
+  last_concurrency_update_ = end_time;
+  slow_start_ = false;
+  if (max_concurrency_ >= 2) {
+    max_concurrency_ = max_concurrency_ / 2;
+    resume_concurrency_ = max_concurrency_;
+    LOG_DEBUG << "Concurrency limit is now: " << max_concurrency_;
+  } else {
+    backoff_ = std::max(backoff_ * 2, kInitialSleepTime);
+  }
+}
+
+void VegasRateController::RetryAfter(const clock::duration delay) {
+  pending_retry_after_ = std::min(delay, kMaxRetryAfter);
+  LOG_DEBUG << "Server asked to retry after "
+            << std::chrono::duration_cast<std::chrono::seconds>(pending_retry_after_).count() << " seconds";
+}
+
+int VegasRateController::MaxConcurrency() const {
+  CheckInvariants();
+  return max_concurrency_;
+}
+
+RateController::clock::duration VegasRateController::GetSleepTime() const {
+  CheckInvariants();
+  const clock::duration pause =
+      paused_until_ > last_completion_ ? paused_until_ - last_completion_ : clock::duration(0);
+  return std::max(backoff_, pause);
+}
+
+bool VegasRateController::ServerHasFailed() const {
+  CheckInvariants();
+  return backoff_ > kMaxSleepTime;
+}
+
+void VegasRateController::CheckInvariants() const {
+  assert((backoff_ == clock::duration(0) && paused_until_ <= last_completion_) || (max_concurrency_ == 1));
+  assert(0 < max_concurrency_);
+  assert(max_concurrency_ <= concurrency_cap_);
+}
@@ -2,6 +2,19 @@
 #define SOTA_CLIENT_TOOLS_RATE_CONTROLLER_H_
 
 #include <chrono>
+#include <iostream>
+#include <memory>
+
+/** Congestion control algorithm used to pace requests to the server. */
+enum class RateControlAlgorithm {
+  /** Additive-increase/multiplicative-decrease, driven only by request failures. */
+  kAimd = 0,
+  /** Delay-based (TCP Vegas-like), driven by round-trip times, failures and Retry-After hints. */
+  kVegas,
+};
+
+std::ostream& operator<<(std::ostream& os, RateControlAlgorithm algorithm);
+std::istream& operator>>(std::istream& is, RateControlAlgorithm& algorithm);
 
 /**
  * Control the rate of outgoing requests.
@@ -10,25 +23,36 @@
  *    MaxConcurrency - The current estimate of the number of parallel requests that can be opened
  *    Sleep() - The number of seconds to sleep before sending the next request. 0.0 if MaxConcurrency is > 1
  *    Failed() - A boolean indicating that the server is broken, and to report an error up to the user.
- * The congestion control is loosely based on the original TCP AIMD scheme. Better performance might be available by
- * Stealing ideas from the later TCP conjection control algorithms
+ * The actual control law is left to the implementations below; use Create() to pick one.
  */
 class RateController {
  public:
   using clock = std::chrono::steady_clock;
-  explicit RateController(int concurrency_cap = 30);
+  using Ptr = std::unique_ptr<RateController>;
+
+  static Ptr Create(RateControlAlgorithm algorithm, int concurrency_cap);
+
+  RateController() = default;
+  virtual ~RateController() = default;
   RateController(const RateController&) = delete;
   RateController operator=(const RateController&) = delete;
 
-  void RequestCompleted(clock::time_point start_time, clock::time_point end_time, bool succeeded);
+  virtual void RequestCompleted(clock::time_point start_time, clock::time_point end_time, bool succeeded) = 0;
 
-  int MaxConcurrency() const;
+  /**
+   * The server explicitly asked us to back off (HTTP 429/503 with a
+   * Retry-After header). Called before RequestCompleted() for the same
+   * request. Ignored by default.
+   */
+  virtual void RetryAfter(clock::duration /* delay */) {}
 
-  clock::duration GetSleepTime() const;
+  virtual int MaxConcurrency() const = 0;
 
-  bool ServerHasFailed() const;
+  virtual clock::duration GetSleepTime() const = 0;
 
- private:
+  virtual bool ServerHasFailed() const = 0;
+
+ protected:
   /**
    * After sleeping this long and still getting a 500 error, assume the
    * server has failed permanently
@@ -40,7 +64,25 @@ class RateController {
    * before retrying. Following retries grow exponentially to kMaxSleepTime.
    */
   static const clock::duration kInitialSleepTime;
+};
+
+/**
+ * The congestion control is loosely based on the original TCP AIMD scheme. Better performance might be available by
+ * Stealing ideas from the later TCP conjection control algorithms, see VegasRateController.
+ */
+class AimdRateController : public RateController {
+ public:
+  explicit AimdRateController(int concurrency_cap = 30);
+
+  void RequestCompleted(clock::time_point start_time, clock::time_point end_time, bool succeeded) override;
+
+  int MaxConcurrency() const override;
+
+  clock::duration GetSleepTime() const override;
+
+  bool ServerHasFailed() const override;
 
+ private:
   const int concurrency_cap_;
   /**
    * After making a change to the system, we wait a full round-trip time to
@@ -55,4 +97,63 @@ class RateController {
   void CheckInvariants() const;
 };
 
+/**
+ * Delay-based congestion control, loosely based on TCP Vegas.
+ *
+ * The controller keeps track of the lowest round-trip time seen recently
+ * (the latency of an unloaded server) and, once per round trip, estimates how
+ * many of our requests are queued on the server side:
+ *    queued = limit * (1 - base_rtt / rtt)
+ * If fewer than kAlpha requests are queued, the limit is increased; if more
+ * than kBeta are queued, it is decreased. This keeps the server busy without
+ * pushing it into the region where it starts failing requests, so we avoid the
+ * AIMD sawtooth. Until the first sign of congestion the limit doubles every
+ * round trip (slow start).
+ *
+ * Failures still cause a multiplicative decrease (at most once per round
+ * trip), and with a concurrency of 1 the same exponential back-off as
+ * AimdRateController. A Retry-After hint from the server pauses all requests
+ * for the requested time (capped at kMaxRetryAfter), after which we resume at
+ * half of the previous limit.
+ */
+class VegasRateController : public RateController {
+ public:
+  explicit VegasRateController(int concurrency_cap = 30);
+
+  void RequestCompleted(clock::time_point start_time, clock::time_point end_time, bool succeeded) override;
+
+  void RetryAfter(clock::duration delay) override;
+
+  int MaxConcurrency() const override;
+
+  clock::duration GetSleepTime() const override;
+
+  bool ServerHasFailed() const override;
+
+ private:
+  /** Longest Retry-After we are willing to honor. */
+  static const clock::duration kMaxRetryAfter;
+  /** Lower and upper bound on the number of requests we want queued on the server. */
+  static constexpr double kAlpha = 2.0;
+  static constexpr double kBeta = 4.0;
+
+  const int concurrency_cap_;
+  int max_concurrency_{1};
+  /** Limit to restore after a Retry-After pause. */
+  int resume_concurrency_{1};
+  bool slow_start_{true};
+  /** Lowest recent round-trip time; drifts upwards slowly to follow permanent changes. */
+  clock::duration base_rtt_{clock::duration::max()};
+  /** Same meaning as in AimdRateController. */
+  clock::time_point last_concurrency_update_;
+  /** End of the last request we heard about; the pool sleeps relative to this. */
+  clock::time_point last_completion_;
+  clock::duration pending_retry_after_{0};
+  clock::time_point paused_until_;
+  clock::duration backoff_{0};
+
+  void OnFailure(clock::time_point start_time, clock::time_point end_time);
+  void CheckInvariants() const;
+};
+
 #endif  // SOTA_CLIENT_TOOLS_RATE_CONTROLLER_H_
@@ -1,16 +1,20 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <random>
+#include <vector>
+
 #include "rate_controller.h"
 
 /* Initial rate controller status is good. */
 TEST(initial, initially_ok) {
-  RateController dut;
+  AimdRateController dut;
   EXPECT_FALSE(dut.ServerHasFailed());
 }
 
 /* Rate controller aborts if it detects server or network failure. */
 TEST(failure, many_errors_cause_abort) {
-  RateController dut;
+  AimdRateController dut;
   EXPECT_FALSE(dut.ServerHasFailed());
   RateController::clock::time_point t = RateController::clock::now();
   RateController::clock::duration interval = std::chrono::seconds(2);
@@ -23,7 +27,7 @@ TEST(failure, many_errors_cause_abort) {
 
 /* Rate controller continues through intermittent errors. */
 TEST(failure, continues_through_occasional_errors) {
-  RateController dut;
+  AimdRateController dut;
   EXPECT_FALSE(dut.ServerHasFailed());
   RateController::clock::time_point t = RateController::clock::now();
   RateController::clock::duration interval = std::chrono::seconds(2);
@@ -37,7 +41,7 @@ TEST(failure, continues_through_occasional_errors) {
 
 /* Rate controller improves concurrency when network conditions are good. */
 TEST(control, good_results_improve_concurrency) {
-  RateController dut;
+  AimdRateController dut;
   RateController::clock::time_point t = RateController::clock::now();
   RateController::clock::duration interval = std::chrono::seconds(2);
   int initial_concurrency = dut.MaxConcurrency();
@@ -48,6 +52,187 @@ TEST(control, good_results_improve_concurrency) {
   EXPECT_GT(dut.MaxConcurrency(), initial_concurrency);
 }
 
+/* Vegas controller honors a Retry-After hint from the server. */
+TEST(control, retry_after_is_honored) {
+  VegasRateController dut;
+  RateController::clock::time_point t = RateController::clock::now();
+  RateController::clock::duration interval = std::chrono::milliseconds(100);
+  for (int i = 0; i < 50; i++) {
+    dut.RequestCompleted(t, t + interval, true);
+    t += interval;
+  }
+  EXPECT_GT(dut.MaxConcurrency(), 1);
+
+  dut.RetryAfter(std::chrono::seconds(5));
+  dut.RequestCompleted(t, t + interval, false);
+  t += interval;
+  EXPECT_EQ(dut.MaxConcurrency(), 1);
+  EXPECT_GE(dut.GetSleepTime(), std::chrono::seconds(5));
+  EXPECT_FALSE(dut.ServerHasFailed());
+
+  // A request sent after the server recovered lifts the throttle.
+  t += dut.GetSleepTime();
+  dut.RequestCompleted(t, t + interval, true);
+  EXPECT_EQ(dut.GetSleepTime(), RateController::clock::duration(0));
+}
+
+/* Vegas controller aborts if it detects server or network failure. */
+TEST(failure, vegas_many_errors_cause_abort) {
+  VegasRateController dut;
+  RateController::clock::time_point t = RateController::clock::now();
+  RateController::clock::duration interval = std::chrono::seconds(2);
+  for (int i = 0; i < 30; i++) {
+    dut.RequestCompleted(t, t + interval, false);
+    t += interval;
+  }
+  EXPECT_TRUE(dut.ServerHasFailed());
+}
+
+/*
+ * Simulation harness: replay a synthetic server trace against a rate
+ * controller and report the achieved throughput.
+ *
+ * The server serves `capacity` requests in parallel at `latency`; any further
+ * requests are queued, so their latency grows linearly with the load. Beyond
+ * `queue_limit` requests in flight it answers with an error, and beyond
+ * `throttle_above` (if non-zero) with a 429 and a Retry-After header. On top of
+ * that, a fraction `error_rate` of the requests fails at random.
+ */
+struct ServerPhase {
+  RateController::clock::duration length;
+  int capacity;
+  std::chrono::milliseconds latency;
+  int queue_limit;
+  double error_rate;
+  int throttle_above;
+  std::chrono::seconds retry_after;
+};
+
+struct SimulationResult {
+  int completed{0};
+  int failed_requests{0};
+  double seconds{0.0};
+  bool aborted{false};
+
+  double throughput() const { return seconds > 0 ? completed / seconds : 0.0; }
+};
+
+static SimulationResult Simulate(RateController &dut, const std::vector<ServerPhase> &trace, const int objects) {
+  using clock = RateController::clock;
+  struct Request {
+    clock::time_point start;
+    clock::time_point end;
+    bool ok;
+    std::chrono::seconds retry_after;
+  };
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  const clock::time_point begin = clock::now();
+  clock::time_point now = begin;
+  std::vector<Request> in_flight;
+  SimulationResult result;
+
+  auto phase_at = [&trace, &begin](const clock::time_point t) -> const ServerPhase & {
+    clock::duration offset = t - begin;
+    for (const auto &phase : trace) {
+      if (offset < phase.length) {
+        return phase;
+      }
+      offset -= phase.length;
+    }
+    return trace.back();
+  };
+
+  while (result.completed < objects) {
+    const ServerPhase &phase = phase_at(now);
+    while (static_cast<int>(in_flight.size()) < dut.MaxConcurrency() &&
+           result.completed + static_cast<int>(in_flight.size()) < objects) {
+      const int load = static_cast<int>(in_flight.size()) + 1;
+      Request r{now, now + phase.latency, true, std::chrono::seconds(0)};
+      if (phase.throttle_above > 0 && load > phase.throttle_above) {
+        r.ok = false;
+        r.retry_after = phase.retry_after;
+      } else if (load > phase.queue_limit || uniform(rng) < phase.error_rate) {
+        r.ok = false;
+      } else if (load > phase.capacity) {
+        r.end = now + phase.latency * load / phase.capacity;
+      }
+      in_flight.push_back(r);
+    }
+
+    auto next = std::min_element(in_flight.begin(), in_flight.end(),
+                                 [](const Request &a, const Request &b) { return a.end < b.end; });
+    now = next->end;
+    if (next->retry_after > std::chrono::seconds(0)) {
+      dut.RetryAfter(next->retry_after);
+    }
+    dut.RequestCompleted(next->start, next->end, next->ok);
+    if (next->ok) {
+      result.completed++;
+    } else {
+      result.failed_requests++;
+    }
+    in_flight.erase(next);
+
+    if (dut.ServerHasFailed()) {
+      result.aborted = true;
+      break;
+    }
+    now += dut.GetSleepTime();
+  }
+  result.seconds = std::chrono::duration<double>(now - begin).count();
+  return result;
+}
+
+static SimulationResult SimulateAndReport(const std::string &name, RateControlAlgorithm algorithm,
+                                          const std::vector<ServerPhase> &trace, const int objects) {
+  RateController::Ptr dut = RateController::Create(algorithm, 30);
+  SimulationResult result = Simulate(*dut, trace, objects);
+  std::cout << name << " / " << algorithm << ": " << result.completed << " objects in " << result.seconds << " s ("
+            << result.throughput() << " objects/s), " << result.failed_requests << " failed requests"
+            << (result.aborted ? ", aborted" : "") << std::endl;
+  return result;
+}
+
+/* Server with a hard limit on the number of parallel requests. */
+TEST(simulation, overloaded_server) {
+  const std::vector<ServerPhase> trace{
+      {std::chrono::hours(1), 8, std::chrono::milliseconds(100), 16, 0.01, 0, std::chrono::seconds(0)}};
+  SimulationResult aimd = SimulateAndReport("overloaded_server", RateControlAlgorithm::kAimd, trace, 5000);
+  SimulationResult vegas = SimulateAndReport("overloaded_server", RateControlAlgorithm::kVegas, trace, 5000);
+  EXPECT_FALSE(aimd.aborted);
+  EXPECT_FALSE(vegas.aborted);
+  // Latency-based control backs off before the server starts failing.
+  EXPECT_LT(vegas.failed_requests, aimd.failed_requests);
+  EXPECT_GT(vegas.throughput(), 0.8 * aimd.throughput());
+}
+
+/* CDN that throttles clients with 429 responses. */
+TEST(simulation, throttling_cdn) {
+  const std::vector<ServerPhase> trace{
+      {std::chrono::hours(1), 20, std::chrono::milliseconds(200), 30, 0.0, 12, std::chrono::seconds(2)}};
+  SimulationResult aimd = SimulateAndReport("throttling_cdn", RateControlAlgorithm::kAimd, trace, 2000);
+  SimulationResult vegas = SimulateAndReport("throttling_cdn", RateControlAlgorithm::kVegas, trace, 2000);
+  EXPECT_FALSE(aimd.aborted);
+  EXPECT_FALSE(vegas.aborted);
+  EXPECT_EQ(vegas.completed, 2000);
+  EXPECT_LT(vegas.failed_requests, aimd.failed_requests);
+}
+
+/* Server capacity drops for a while, then recovers. */
+TEST(simulation, capacity_change) {
+  const std::vector<ServerPhase> trace{
+      {std::chrono::seconds(60), 16, std::chrono::milliseconds(50), 24, 0.0, 0, std::chrono::seconds(0)},
+      {std::chrono::seconds(60), 4, std::chrono::milliseconds(200), 8, 0.0, 0, std::chrono::seconds(0)},
+      {std::chrono::hours(1), 16, std::chrono::milliseconds(50), 24, 0.0, 0, std::chrono::seconds(0)}};
+  SimulationResult aimd = SimulateAndReport("capacity_change", RateControlAlgorithm::kAimd, trace, 20000);
+  SimulationResult vegas = SimulateAndReport("capacity_change", RateControlAlgorithm::kVegas, trace, 20000);
+  EXPECT_FALSE(aimd.aborted);
+  EXPECT_FALSE(vegas.aborted);
+  EXPECT_LT(vegas.failed_requests, aimd.failed_requests);
+}
+
 #ifndef __NO_MAIN__
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
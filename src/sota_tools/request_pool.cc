@@ -7,8 +7,17 @@
 
 #include "logging/logging.h"
 
-RequestPool::RequestPool(TreehubServer& server, const int max_curl_requests, const RunMode mode)
-    : rate_controller_(max_curl_requests), running_requests_(0), server_(server), mode_(mode), stopped_(false) {
+const RateController::clock::duration RequestPool::kProgressReportInterval = std::chrono::seconds(10);
+
+RequestPool::RequestPool(TreehubServer& server, const int max_curl_requests, const RunMode mode,
+                         const RateControlAlgorithm rate_control)
+    : rate_controller_(RateController::Create(rate_control, max_curl_requests)),
+      running_requests_(0),
+      last_progress_report_(RateController::clock::now()),
+      server_(server),
+      mode_(mode),
+      stopped_(false) {
+  LOG_DEBUG << "Using " << rate_control << " rate control with at most " << max_curl_requests << " parallel requests";
   curl_global_init(CURL_GLOBAL_DEFAULT);
   multi_ = curl_multi_init();
   curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_HTTP1 | CURLPIPE_MULTIPLEX);
@@ -43,21 +52,21 @@ void RequestPool::AddQuery(const OSTreeObject::ptr& request) {
 void RequestPool::AddUpload(const OSTreeObject::ptr& request) {
   request->LaunchNotify();
   if (!stopped_) {
-    upload_queue_.push_back(request);
+    upload_queue_.emplace(request->GetSize(), request);
   }
 }
 
 void RequestPool::LoopLaunch() {
-  while (running_requests_ < rate_controller_.MaxConcurrency() && (!query_queue_.empty() || !upload_queue_.empty())) {
+  while (running_requests_ < rate_controller_->MaxConcurrency() && (!query_queue_.empty() || !upload_queue_.empty())) {
     OSTreeObject::ptr cur;
 
-    // Queries first, uploads second
+    // Queries first, uploads second (smallest first)
     if (query_queue_.empty()) {
-      cur = upload_queue_.front();
-      upload_queue_.pop_front();
+      cur = upload_queue_.begin()->second;
+      total_object_size_ += upload_queue_.begin()->first;
+      upload_queue_.erase(upload_queue_.begin());
       cur->Upload(server_, multi_, mode_);
       put_requests_made_++;
-      total_object_size_ += cur->GetSize();
       if (mode_ == RunMode::kDryRun || mode_ == RunMode::kWalkTree) {
         // Don't send an actual upload message, just skip to the part where we
         // acknowledge that the object has been uploaded.
@@ -66,6 +75,13 @@ void RequestPool::LoopLaunch() {
     } else {
       cur = query_queue_.front();
       query_queue_.pop_front();
+      if (journal_ != nullptr && mode_ == RunMode::kDefault && journal_->Contains(cur->name())) {
+        LOG_DEBUG << "Present according to the journal: " << cur;
+        cur->MarkPresent();
+        stats_.ObjectPresent();
+        cur->NotifyParents(*this);
+        continue;
+      }
       cur->MakeTestRequest(server_, multi_);
       head_requests_made_++;
     }
@@ -143,11 +159,25 @@ void RequestPool::LoopListen() {
       const bool server_responded_ok = h->LastOperationResult() == ServerResponse::kOk;
       const RateController::clock::time_point start_time = h->RequestStartTime();
       const RateController::clock::time_point end_time = RateController::clock::now();
-      rate_controller_.RequestCompleted(start_time, end_time, server_responded_ok);
-      if (rate_controller_.ServerHasFailed()) {
+      stats_.RequestCompleted(h->operation(), end_time - start_time, server_responded_ok);
+      if (server_responded_ok && h->is_on_server() == PresenceOnServer::kObjectPresent) {
+        if (h->operation() == CurrentOp::kOstreeObjectUploading) {
+          stats_.ObjectUploaded(h->GetSize());
+        } else {
+          stats_.ObjectPresent();
+        }
+        if (journal_ != nullptr && mode_ == RunMode::kDefault) {
+          journal_->Record(h->name());
+        }
+      }
+      if (h->RetryAfter() > std::chrono::seconds(0)) {
+        rate_controller_->RetryAfter(h->RetryAfter());
+      }
+      rate_controller_->RequestCompleted(start_time, end_time, server_responded_ok);
+      if (rate_controller_->ServerHasFailed()) {
         Abort();
       } else {
-        auto duration = rate_controller_.GetSleepTime();
+        auto duration = rate_controller_->GetSleepTime();
         if (duration > RateController::clock::duration(0)) {
           LOG_DEBUG << "Sleeping for " << std::chrono::duration_cast<std::chrono::seconds>(duration).count()
                     << " seconds due to server congestion.";
@@ -161,5 +191,15 @@ void RequestPool::LoopListen() {
 void RequestPool::Loop() {
   LoopLaunch();
   LoopListen();
+  MaybeReportProgress();
+}
+
+void RequestPool::MaybeReportProgress() {
+  stats_.UpdateConcurrency(running_requests_, rate_controller_->MaxConcurrency());
+  const RateController::clock::time_point now = RateController::clock::now();
+  if (now - last_progress_report_ >= kProgressReportInterval) {
+    last_progress_report_ = now;
+    LOG_INFO << stats_.ProgressReport(now);
+  }
 }
 // vim: set tabstop=2 shiftwidth=2 expandtab:
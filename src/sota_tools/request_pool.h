@@ -2,16 +2,20 @@
 #define SOTA_CLIENT_TOOLS_REQUEST_POOL_H_
 
 #include <list>
+#include <map>
 
 #include <curl/curl.h>
 
 #include "garage_common.h"
 #include "ostree_object.h"
 #include "rate_controller.h"
+#include "request_stats.h"
+#include "upload_journal.h"
 
 class RequestPool {
  public:
-  RequestPool(TreehubServer& server, int max_curl_requests, RunMode mode);
+  RequestPool(TreehubServer& server, int max_curl_requests, RunMode mode,
+              RateControlAlgorithm rate_control = RateControlAlgorithm::kAimd);
   ~RequestPool();
   void AddQuery(const OSTreeObject::ptr& request);
   void AddUpload(const OSTreeObject::ptr& request);
@@ -36,20 +40,39 @@ class RequestPool {
   int put_requests_made() { return put_requests_made_; }
   int head_requests_made() { return head_requests_made_; }
   uintmax_t total_object_size() { return total_object_size_; }
+  const RequestStats& stats() const { return stats_; }
+  /**
+   * Record confirmed objects in `journal` and skip the presence check for
+   * objects it already contains. Only used in RunMode::kDefault, where an
+   * object present on the server implies that all its children are too.
+   */
+  void SetJournal(UploadJournal* journal) { journal_ = journal; }
 
  private:
+  /** How often a progress report is logged while the pool is running. */
+  static const RateController::clock::duration kProgressReportInterval;
+
   void LoopLaunch();  // launches multiple requests from the queues
   void LoopListen();  // listens to the result of launched requests
+  void MaybeReportProgress();
 
-  RateController rate_controller_;
+  RateController::Ptr rate_controller_;
   int running_requests_;
   int head_requests_made_{0};
   int put_requests_made_{0};
   uintmax_t total_object_size_{0};
+  RequestStats stats_;
+  UploadJournal* journal_{nullptr};
+  RateController::clock::time_point last_progress_report_;
   TreehubServer& server_;
   CURLM* multi_;
   std::list<OSTreeObject::ptr> query_queue_;
-  std::list<OSTreeObject::ptr> upload_queue_;
+  /**
+   * Pending uploads, smallest first. Small objects are mostly metadata and
+   * complete quickly, so sending them first unblocks their parents and keeps
+   * many requests in flight while large objects are still queued.
+   */
+  std::multimap<uintmax_t, OSTreeObject::ptr> upload_queue_;
   RunMode mode_;
   bool stopped_;
 };
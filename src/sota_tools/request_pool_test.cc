@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "garage_common.h"
+#include "ostree_dir_repo.h"
+#include "ostree_object.h"
+#include "request_pool.h"
+
+/* Queued uploads are dispatched smallest first, whatever the order they were
+ * queued in. */
+TEST(request_pool, upload_smallest_first) {
+  OSTreeDirRepo repo("tests/sota_tools/repo");
+  // 94, 48, 12 and 41 bytes.
+  const std::vector<std::string> names{"16/ef2f2629dc9263fdf3c0f032563a2d757623bbc11cf99df25c3c3f258dccbe.commit",
+                                       "a1/f4f81612ce959883f58e83789f6c7d97b0b55b801b2a09955235f40b0f2dfb.filez",
+                                       "2a/28dac42b76c2015ee3c41cc4183bb8b5c790fd21fa5cfa0802c6e11fd0edbe.dirmeta",
+                                       "3c/064a2f3853b9158b82184311eca9d9d55fcd4788243546fbd98358763ef6fc.dirtree"};
+  TreehubServer server;
+  // A dry run dispatches uploads without sending them. The concurrency limit
+  // starts at one, so every loop dispatches exactly one upload.
+  RequestPool pool(server, 1, RunMode::kDryRun);
+  std::vector<OSTreeObject::ptr> objects;
+  for (const auto &name : names) {
+    objects.emplace_back(new OSTreeObject(repo, name));
+    pool.AddUpload(objects.back());
+  }
+
+  std::vector<uintmax_t> dispatched;
+  uintmax_t total = 0;
+  while (!pool.is_idle()) {
+    pool.Loop();
+    dispatched.push_back(pool.total_object_size() - total);
+    total = pool.total_object_size();
+  }
+  EXPECT_EQ(dispatched, (std::vector<uintmax_t>{12, 41, 48, 94}));
+  EXPECT_EQ(pool.put_requests_made(), 4);
+}
+
+#ifndef __NO_MAIN__
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+#endif
+
+// vim: set tabstop=2 shiftwidth=2 expandtab:
@@ -0,0 +1,110 @@
+#include "request_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+RequestStats::RequestStats(const clock::time_point start_time)
+    : start_time_(start_time), last_report_time_(start_time) {}
+
+void RequestStats::RequestCompleted(const CurrentOp operation, const clock::duration latency, const bool succeeded) {
+  RequestTypeStats& stats = (operation == CurrentOp::kOstreeObjectUploading) ? put_ : head_;
+  stats.count++;
+  if (!succeeded) {
+    stats.failed++;
+  }
+  stats.latencies.push_back(latency);
+}
+
+void RequestStats::ObjectUploaded(const uintmax_t size) {
+  objects_uploaded_++;
+  bytes_uploaded_ += size;
+}
+
+void RequestStats::ObjectPresent() { objects_present_++; }
+
+void RequestStats::UpdateConcurrency(const int in_flight, const int concurrency_limit) {
+  in_flight_ = in_flight;
+  max_in_flight_ = std::max(max_in_flight_, in_flight);
+  concurrency_limit_ = concurrency_limit;
+  max_concurrency_limit_ = std::max(max_concurrency_limit_, concurrency_limit);
+}
+
+std::string RequestStats::ProgressReport(const clock::time_point now) {
+  const double interval = std::chrono::duration<double>(now - last_report_time_).count();
+  const double objects_per_sec =
+      interval > 0 ? static_cast<double>(objects_uploaded_ - last_report_objects_) / interval : 0.0;
+  const double kbytes_per_sec =
+      interval > 0 ? static_cast<double>(bytes_uploaded_ - last_report_bytes_) / 1024.0 / interval : 0.0;
+  last_report_time_ = now;
+  last_report_objects_ = objects_uploaded_;
+  last_report_bytes_ = bytes_uploaded_;
+
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(1);
+  out << "Uploaded " << objects_uploaded_ << " objects (" << bytes_uploaded_ << " bytes), " << objects_present_
+      << " already present; " << objects_per_sec << " objects/s, " << kbytes_per_sec << " KiB/s; " << in_flight_
+      << " requests in flight, concurrency limit " << concurrency_limit_ << "; " << retries() << " retries";
+  out << head_.LatencyReport("HEAD") << put_.LatencyReport("PUT");
+  return out.str();
+}
+
+Json::Value RequestStats::ToJson(const clock::time_point now) const {
+  const double duration = std::chrono::duration<double>(now - start_time_).count();
+  Json::Value res;
+  res["duration_s"] = duration;
+  res["objects_uploaded"] = static_cast<Json::UInt64>(objects_uploaded_);
+  res["objects_present"] = static_cast<Json::UInt64>(objects_present_);
+  res["bytes_uploaded"] = static_cast<Json::UInt64>(bytes_uploaded_);
+  res["objects_per_s"] = duration > 0 ? static_cast<double>(objects_uploaded_) / duration : 0.0;
+  res["bytes_per_s"] = duration > 0 ? static_cast<double>(bytes_uploaded_) / duration : 0.0;
+  res["max_in_flight"] = max_in_flight_;
+  res["concurrency_limit"] = concurrency_limit_;
+  res["max_concurrency_limit"] = max_concurrency_limit_;
+  res["retries"] = retries();
+  res["requests"]["head"] = head_.ToJson();
+  res["requests"]["put"] = put_.ToJson();
+  return res;
+}
+
+Json::Value RequestStats::RequestTypeStats::ToJson() const {
+  Json::Value res;
+  res["count"] = count;
+  res["retries"] = failed;
+  const std::vector<double> ms = PercentilesMs(latencies, {50, 90, 99, 100});
+  res["latency_ms"]["p50"] = ms[0];
+  res["latency_ms"]["p90"] = ms[1];
+  res["latency_ms"]["p99"] = ms[2];
+  res["latency_ms"]["max"] = ms[3];
+  return res;
+}
+
+std::string RequestStats::RequestTypeStats::LatencyReport(const std::string& name) const {
+  if (latencies.empty()) {
+    return "";
+  }
+  const std::vector<double> ms = PercentilesMs(latencies, {50, 90, 99});
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(1);
+  out << "; " << name << " latency p50/p90/p99 " << ms[0] << "/" << ms[1] << "/" << ms[2] << " ms";
+  return out.str();
+}
+
+std::vector<double> RequestStats::PercentilesMs(std::vector<clock::duration> samples,
+                                                const std::vector<double>& percentiles) {
+  std::vector<double> res(percentiles.size(), 0.0);
+  if (samples.empty()) {
+    return res;
+  }
+  std::sort(samples.begin(), samples.end());
+  for (size_t i = 0; i < percentiles.size(); ++i) {
+    // Nearest-rank: the smallest sample such that `percentile` % of the samples are no larger.
+    auto rank = static_cast<size_t>(std::ceil(percentiles[i] / 100.0 * static_cast<double>(samples.size())));
+    rank = std::min(std::max(rank, static_cast<size_t>(1)), samples.size());
+    res[i] = std::chrono::duration<double, std::milli>(samples[rank - 1]).count();
+  }
+  return res;
+}
+
+// vim: set tabstop=2 shiftwidth=2 expandtab:
@@ -0,0 +1,84 @@
+#ifndef SOTA_CLIENT_TOOLS_REQUEST_STATS_H_
+#define SOTA_CLIENT_TOOLS_REQUEST_STATS_H_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "json/json.h"
+
+#include "ostree_object.h"
+
+/**
+ * Throughput, concurrency and latency statistics for the requests made by a
+ * RequestPool. RequestPool feeds it with completed requests and uploaded
+ * objects; it is queried for periodic one-line progress reports and for a
+ * machine-readable summary at the end of the run.
+ */
+class RequestStats {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  explicit RequestStats(clock::time_point start_time = clock::now());
+
+  /**
+   * A HEAD (presence check) or PUT (upload) request has finished. Failed
+   * requests are always retried by the pool, so they are reported as retries.
+   */
+  void RequestCompleted(CurrentOp operation, clock::duration latency, bool succeeded);
+  void ObjectUploaded(uintmax_t size);
+  void ObjectPresent();
+  /** Record the number of requests in flight and the current limit from the RateController. */
+  void UpdateConcurrency(int in_flight, int concurrency_limit);
+
+  /**
+   * One line describing the progress so far. Rates are computed over the
+   * interval since the previous call. Latencies are given for HEAD and PUT
+   * requests separately.
+   */
+  std::string ProgressReport(clock::time_point now);
+
+  /** Summary of the whole run. Latencies are in milliseconds. */
+  Json::Value ToJson(clock::time_point now = clock::now()) const;
+
+  uintmax_t objects_uploaded() const { return objects_uploaded_; }
+  uintmax_t bytes_uploaded() const { return bytes_uploaded_; }
+  int retries() const { return head_.failed + put_.failed; }
+
+ private:
+  struct RequestTypeStats {
+    int count{0};
+    int failed{0};
+    std::vector<clock::duration> latencies;
+
+    Json::Value ToJson() const;
+    /** " <name> latency p50/p90/p99 ... ms" for the progress report, or nothing if there were no requests. */
+    std::string LatencyReport(const std::string& name) const;
+  };
+
+  /**
+   * Nearest-rank percentiles of `samples` in milliseconds, in the order of
+   * `percentiles`; 0 if there are no samples. The samples are copied and sorted
+   * once for all the percentiles.
+   */
+  static std::vector<double> PercentilesMs(std::vector<clock::duration> samples,
+                                           const std::vector<double>& percentiles);
+
+  const clock::time_point start_time_;
+  RequestTypeStats head_;
+  RequestTypeStats put_;
+  uintmax_t objects_uploaded_{0};
+  uintmax_t objects_present_{0};
+  uintmax_t bytes_uploaded_{0};
+  int in_flight_{0};
+  int max_in_flight_{0};
+  int concurrency_limit_{0};
+  int max_concurrency_limit_{0};
+
+  clock::time_point last_report_time_;
+  uintmax_t last_report_objects_{0};
+  uintmax_t last_report_bytes_{0};
+};
+
+// vim: set tabstop=2 shiftwidth=2 expandtab:
+#endif  // SOTA_CLIENT_TOOLS_REQUEST_STATS_H_
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include "request_stats.h"
+
+/* Latency percentiles are computed per request type. */
+TEST(request_stats, latency_percentiles) {
+  const RequestStats::clock::time_point start = RequestStats::clock::now();
+  RequestStats dut(start);
+  for (int i = 1; i <= 100; i++) {
+    dut.RequestCompleted(CurrentOp::kOstreeObjectUploading, std::chrono::milliseconds(i), true);
+  }
+  dut.RequestCompleted(CurrentOp::kOstreeObjectPresenceCheck, std::chrono::milliseconds(7), true);
+
+  const Json::Value json = dut.ToJson(start + std::chrono::seconds(1));
+  EXPECT_EQ(json["requests"]["put"]["count"].asInt(), 100);
+  EXPECT_DOUBLE_EQ(json["requests"]["put"]["latency_ms"]["p50"].asDouble(), 50.0);
+  EXPECT_DOUBLE_EQ(json["requests"]["put"]["latency_ms"]["p90"].asDouble(), 90.0);
+  EXPECT_DOUBLE_EQ(json["requests"]["put"]["latency_ms"]["p99"].asDouble(), 99.0);
+  EXPECT_DOUBLE_EQ(json["requests"]["put"]["latency_ms"]["max"].asDouble(), 100.0);
+  EXPECT_EQ(json["requests"]["head"]["count"].asInt(), 1);
+  EXPECT_DOUBLE_EQ(json["requests"]["head"]["latency_ms"]["p99"].asDouble(), 7.0);
+
+  // The progress report gives the latencies of both request types.
+  const std::string report = dut.ProgressReport(start + std::chrono::seconds(1));
+  EXPECT_NE(report.find("; HEAD latency p50/p90/p99 7.0/7.0/7.0 ms"), std::string::npos) << report;
+  EXPECT_NE(report.find("; PUT latency p50/p90/p99 50.0/90.0/99.0 ms"), std::string::npos) << report;
+}
+
+/* Failed requests are counted as retries of their request type. */
+TEST(request_stats, retries) {
+  RequestStats dut;
+  dut.RequestCompleted(CurrentOp::kOstreeObjectPresenceCheck, std::chrono::milliseconds(1), false);
+  dut.RequestCompleted(CurrentOp::kOstreeObjectUploading, std::chrono::milliseconds(1), false);
+  dut.RequestCompleted(CurrentOp::kOstreeObjectUploading, std::chrono::milliseconds(1), false);
+  dut.RequestCompleted(CurrentOp::kOstreeObjectUploading, std::chrono::milliseconds(1), true);
+  EXPECT_EQ(dut.retries(), 3);
+
+  const Json::Value json = dut.ToJson();
+  EXPECT_EQ(json["retries"].asInt(), 3);
+  EXPECT_EQ(json["requests"]["head"]["retries"].asInt(), 1);
+  EXPECT_EQ(json["requests"]["put"]["retries"].asInt(), 2);
+}
+
+/* Throughput is reported over the whole run and since the last progress report. */
+TEST(request_stats, throughput) {
+  const RequestStats::clock::time_point start = RequestStats::clock::now();
+  RequestStats dut(start);
+  for (int i = 0; i < 20; i++) {
+    dut.ObjectUploaded(1024);
+  }
+  dut.ObjectPresent();
+  dut.UpdateConcurrency(4, 8);
+  dut.UpdateConcurrency(2, 6);
+
+  const std::string report = dut.ProgressReport(start + std::chrono::seconds(10));
+  EXPECT_NE(report.find("Uploaded 20 objects (20480 bytes), 1 already present"), std::string::npos) << report;
+  EXPECT_NE(report.find("2.0 objects/s, 2.0 KiB/s"), std::string::npos) << report;
+  EXPECT_NE(report.find("2 requests in flight, concurrency limit 6"), std::string::npos) << report;
+
+  // Nothing happened since the last report.
+  const std::string idle_report = dut.ProgressReport(start + std::chrono::seconds(20));
+  EXPECT_NE(idle_report.find("0.0 objects/s, 0.0 KiB/s"), std::string::npos) << idle_report;
+
+  const Json::Value json = dut.ToJson(start + std::chrono::seconds(20));
+  EXPECT_EQ(json["objects_uploaded"].asUInt64(), 20);
+  EXPECT_EQ(json["objects_present"].asUInt64(), 1);
+  EXPECT_EQ(json["bytes_uploaded"].asUInt64(), 20480);
+  EXPECT_DOUBLE_EQ(json["objects_per_s"].asDouble(), 1.0);
+  EXPECT_DOUBLE_EQ(json["bytes_per_s"].asDouble(), 1024.0);
+  EXPECT_EQ(json["max_in_flight"].asInt(), 4);
+  EXPECT_EQ(json["concurrency_limit"].asInt(), 6);
+  EXPECT_EQ(json["max_concurrency_limit"].asInt(), 8);
+}
+
+#ifndef __NO_MAIN__
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+#endif
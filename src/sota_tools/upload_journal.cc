@@ -0,0 +1,74 @@
+#include "upload_journal.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <utility>
+
+#include "logging/logging.h"
+
+namespace {
+const std::string kHeaderPrefix = "garage-push journal v1 ";
+
+// Object names look like "xx/<62 more hex digits>.<type>", as built by
+// OSTreeRepo::GetObject(). Anything else, e.g. a line cut short by a crash, is
+// ignored.
+bool IsObjectName(const std::string& name) {
+  return name.size() > 66 && name[2] == '/' && name[65] == '.' &&
+         std::all_of(name.begin(), name.begin() + 2, ::isxdigit) &&
+         std::all_of(name.begin() + 3, name.begin() + 65, ::isxdigit);
+}
+}  // namespace
+
+UploadJournal::UploadJournal(boost::filesystem::path path, const std::string& server) : path_(std::move(path)) {
+  const std::string header = kHeaderPrefix + server;
+  bool resume = false;
+  {
+    std::ifstream in(path_.c_str());
+    std::string line;
+    if (in.good() && std::getline(in, line)) {
+      if (line == header) {
+        resume = true;
+        while (std::getline(in, line)) {
+          if (IsObjectName(line)) {
+            objects_.insert(line);
+          }
+        }
+      } else {
+        LOG_WARNING << "Ignoring journal " << path_ << " from a different server";
+      }
+    }
+  }
+  resumed_ = objects_.size();
+
+  file_.open(path_.c_str(), resume ? std::ios::app : std::ios::trunc);
+  if (!file_.good()) {
+    throw std::runtime_error("Could not open journal " + path_.string());
+  }
+  if (resume) {
+    // Terminate a line that may have been cut short by a crash.
+    file_ << '\n';
+  } else {
+    file_ << header << '\n';
+  }
+  file_.flush();
+}
+
+void UploadJournal::Record(const std::string& object_name) {
+  if (!objects_.insert(object_name).second) {
+    return;
+  }
+  file_ << object_name << '\n';
+  file_.flush();
+}
+
+void UploadJournal::Remove() {
+  file_.close();
+  boost::system::error_code ec;
+  boost::filesystem::remove(path_, ec);
+  if (ec) {
+    LOG_WARNING << "Could not remove journal " << path_ << ": " << ec.message();
+  }
+}
+
+// vim: set tabstop=2 shiftwidth=2 expandtab:
@@ -0,0 +1,42 @@
+#ifndef SOTA_CLIENT_TOOLS_UPLOAD_JOURNAL_H_
+#define SOTA_CLIENT_TOOLS_UPLOAD_JOURNAL_H_
+
+#include <fstream>
+#include <string>
+#include <unordered_set>
+
+#include <boost/filesystem.hpp>
+
+/**
+ * Local record of the objects known to be present on a Treehub server, so
+ * that an interrupted garage-push can be restarted without querying every
+ * object again.
+ *
+ * The file starts with a header line identifying the server; each following
+ * line is the name of one object that was uploaded or found to be present. A
+ * journal written for another server is discarded. Lines are appended and
+ * flushed as objects are confirmed, so a crash loses at most the objects in
+ * flight, which are queried again on the next run.
+ */
+class UploadJournal {
+ public:
+  UploadJournal(boost::filesystem::path path, const std::string& server);
+  UploadJournal(const UploadJournal&) = delete;
+  UploadJournal& operator=(const UploadJournal&) = delete;
+
+  bool Contains(const std::string& object_name) const { return objects_.count(object_name) != 0; }
+  void Record(const std::string& object_name);
+  /** Number of objects loaded from a previous session. */
+  size_t resumed() const { return resumed_; }
+  /** The push completed: the journal is no longer needed. */
+  void Remove();
+
+ private:
+  const boost::filesystem::path path_;
+  std::unordered_set<std::string> objects_;
+  std::ofstream file_;
+  size_t resumed_{0};
+};
+
+// vim: set tabstop=2 shiftwidth=2 expandtab:
+#endif  // SOTA_CLIENT_TOOLS_UPLOAD_JOURNAL_H_
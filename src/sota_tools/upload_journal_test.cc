@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "upload_journal.h"
+#include "utilities/utils.h"
+
+const std::string kObject1 = "16/ef2f2629dc9263fdf3c0f032563a2d757623bbc11cf99df25c3c3f258dccbe.commit";
+const std::string kObject2 = "2a/28dac42b76c2015ee3c41cc4183bb8b5c790fd21fa5cfa0802c6e11fd0edbe.dirmeta";
+
+/* Objects recorded in a journal are known to a later session for the same server. */
+TEST(upload_journal, resume) {
+  TemporaryDirectory temp_dir;
+  const boost::filesystem::path path = temp_dir / "journal";
+  {
+    UploadJournal journal(path, "https://treehub.example.com");
+    EXPECT_EQ(journal.resumed(), 0);
+    EXPECT_FALSE(journal.Contains(kObject1));
+    journal.Record(kObject1);
+    journal.Record(kObject2);
+    journal.Record(kObject1);
+    EXPECT_TRUE(journal.Contains(kObject1));
+  }
+  UploadJournal journal(path, "https://treehub.example.com");
+  EXPECT_EQ(journal.resumed(), 2);
+  EXPECT_TRUE(journal.Contains(kObject1));
+  EXPECT_TRUE(journal.Contains(kObject2));
+}
+
+/* A journal written for another server is discarded. */
+TEST(upload_journal, other_server) {
+  TemporaryDirectory temp_dir;
+  const boost::filesystem::path path = temp_dir / "journal";
+  {
+    UploadJournal journal(path, "https://treehub.example.com");
+    journal.Record(kObject1);
+  }
+  {
+    UploadJournal journal(path, "https://other.example.com");
+    EXPECT_EQ(journal.resumed(), 0);
+    EXPECT_FALSE(journal.Contains(kObject1));
+  }
+  UploadJournal journal(path, "https://treehub.example.com");
+  EXPECT_EQ(journal.resumed(), 0);
+}
+
+/* A line cut short by a crash is ignored, and later records are still readable. */
+TEST(upload_journal, truncated_line) {
+  TemporaryDirectory temp_dir;
+  const boost::filesystem::path path = temp_dir / "journal";
+  Utils::writeFile(path, "garage-push journal v1 https://treehub.example.com\n" + kObject1 + "\n" +
+                             kObject2.substr(0, 40));
+  {
+    UploadJournal journal(path, "https://treehub.example.com");
+    EXPECT_EQ(journal.resumed(), 1);
+    EXPECT_FALSE(journal.Contains(kObject2));
+    journal.Record(kObject2);
+  }
+  UploadJournal journal(path, "https://treehub.example.com");
+  EXPECT_EQ(journal.resumed(), 2);
+  EXPECT_TRUE(journal.Contains(kObject2));
+}
+
+/* The journal is deleted once the upload is complete. */
+TEST(upload_journal, remove) {
+  TemporaryDirectory temp_dir;
+  const boost::filesystem::path path = temp_dir / "journal";
+  UploadJournal journal(path, "https://treehub.example.com");
+  EXPECT_TRUE(boost::filesystem::exists(path));
+  journal.Remove();
+  EXPECT_FALSE(boost::filesystem::exists(path));
+}
+
+#ifndef __NO_MAIN__
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+#endif
+
+// vim: set tabstop=2 shiftwidth=2 expandtab:
@@ -6,8 +6,14 @@ void DirectorRepo::addTarget(const std::string &target_name, const Json::Value &
   const boost::filesystem::path staging = path_ / DirectorRepo::dir / "staging/targets.json";
 
   Json::Value director_targets;
+  Json::Value ecus(Json::objectValue);
   if (boost::filesystem::exists(staging)) {
     director_targets = Utils::parseJSONFile(staging);
+    // The same image can be assigned to several ECUs before the targets are signed.
+    const Json::Value &staged = director_targets["targets"][target_name];
+    if (staged.isObject() && staged["hashes"] == target["hashes"]) {
+      ecus = staged["custom"]["ecuIdentifiers"];
+    }
   } else if (boost::filesystem::exists(current)) {
     director_targets = Utils::parseJSONFile(current)["signed"];
   } else {
@@ -19,7 +25,8 @@ void DirectorRepo::addTarget(const std::string &target_name, const Json::Value &
   }
   director_targets["targets"][target_name] = target;
   director_targets["targets"][target_name]["custom"].removeMember("hardwareIds");
-  director_targets["targets"][target_name]["custom"]["ecuIdentifiers"][ecu_serial]["hardwareId"] = hardware_id;
+  ecus[ecu_serial]["hardwareId"] = hardware_id;
+  director_targets["targets"][target_name]["custom"]["ecuIdentifiers"] = ecus;
   if (!url.empty()) {
     director_targets["targets"][target_name]["custom"]["uri"] = url;
   } else {
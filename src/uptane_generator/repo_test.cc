@@ -209,10 +209,10 @@ TEST(uptane_generator, delegation) {
   {
     auto test_delegate = Utils::parseJSONFile(temp_dir.Path() / ImageRepo::dir / "delegations/test_delegate.json");
     Uptane::Targets delegate_targets(test_delegate);
-    EXPECT_EQ(delegate_targets.targets.size(), 1);
-    EXPECT_EQ(delegate_targets.targets[0].filename(), "tests/test_data/firmware.txt");
-    EXPECT_EQ(delegate_targets.targets[0].length(), 17);
-    EXPECT_EQ(delegate_targets.targets[0].sha256Hash(),
+    EXPECT_EQ(delegate_targets.targets().size(), 1);
+    EXPECT_EQ(delegate_targets.targets()[0].filename(), "tests/test_data/firmware.txt");
+    EXPECT_EQ(delegate_targets.targets()[0].length(), 17);
+    EXPECT_EQ(delegate_targets.targets()[0].sha256Hash(),
               "d8e9caba8c1697fcbade1057f9c2488044192ff76bb64d4aba2c20e53dc33033");
   }
   cmd = generate_repo_exec + " image " + temp_dir.Path().string() + " --keytype " + keytype_stream.str() +
@@ -225,10 +225,10 @@ TEST(uptane_generator, delegation) {
   {
     auto test_delegate = Utils::parseJSONFile(temp_dir.Path() / ImageRepo::dir / "delegations/test_delegate.json");
     Uptane::Targets delegate_targets(test_delegate);
-    EXPECT_EQ(delegate_targets.targets.size(), 2);
-    EXPECT_EQ(delegate_targets.targets[1].filename(), "tests/test_data/firmware2.txt");
-    EXPECT_EQ(delegate_targets.targets[1].length(), 17);
-    EXPECT_EQ(delegate_targets.targets[1].sha256Hash(),
+    EXPECT_EQ(delegate_targets.targets().size(), 2);
+    EXPECT_EQ(delegate_targets.targets()[1].filename(), "tests/test_data/firmware2.txt");
+    EXPECT_EQ(delegate_targets.targets()[1].length(), 17);
+    EXPECT_EQ(delegate_targets.targets()[1].sha256Hash(),
               "d8e9caba8c1697fcbade1057f9c2488044192ff76bb64d4aba2c20e53dc33033");
   }
   check_repo(temp_dir);
@@ -265,10 +265,10 @@ TEST(uptane_generator, delegation_revoke) {
   {
     auto test_delegate = Utils::parseJSONFile(temp_dir.Path() / ImageRepo::dir / "delegations/test_delegate.json");
     Uptane::Targets delegate_targets(test_delegate);
-    EXPECT_EQ(delegate_targets.targets.size(), 1);
-    EXPECT_EQ(delegate_targets.targets[0].filename(), "tests/test_data/firmware.txt");
-    EXPECT_EQ(delegate_targets.targets[0].length(), 17);
-    EXPECT_EQ(delegate_targets.targets[0].sha256Hash(),
+    EXPECT_EQ(delegate_targets.targets().size(), 1);
+    EXPECT_EQ(delegate_targets.targets()[0].filename(), "tests/test_data/firmware.txt");
+    EXPECT_EQ(delegate_targets.targets()[0].length(), 17);
+    EXPECT_EQ(delegate_targets.targets()[0].sha256Hash(),
               "d8e9caba8c1697fcbade1057f9c2488044192ff76bb64d4aba2c20e53dc33033");
   }
   cmd = generate_repo_exec + " image " + temp_dir.Path().string() + " --keytype " + keytype_stream.str() +
@@ -294,19 +294,19 @@ TEST(uptane_generator, delegation_revoke) {
   {
     auto test_delegate = Utils::parseJSONFile(temp_dir.Path() / ImageRepo::dir / "delegations/test_delegate.json");
     Uptane::Targets delegate_targets(test_delegate);
-    EXPECT_EQ(delegate_targets.targets.size(), 2);
-    EXPECT_EQ(delegate_targets.targets[1].filename(), "tests/test_data/firmware2.txt");
-    EXPECT_EQ(delegate_targets.targets[1].length(), 17);
-    EXPECT_EQ(delegate_targets.targets[1].sha256Hash(),
+    EXPECT_EQ(delegate_targets.targets().size(), 2);
+    EXPECT_EQ(delegate_targets.targets()[1].filename(), "tests/test_data/firmware2.txt");
+    EXPECT_EQ(delegate_targets.targets()[1].length(), 17);
+    EXPECT_EQ(delegate_targets.targets()[1].sha256Hash(),
               "d8e9caba8c1697fcbade1057f9c2488044192ff76bb64d4aba2c20e53dc33033");
   }
   {
     auto signed_targets = Utils::parseJSONFile(temp_dir.Path() / DirectorRepo::dir / "targets.json");
     Uptane::Targets director_targets(signed_targets);
-    EXPECT_EQ(director_targets.targets.size(), 1);
-    EXPECT_EQ(director_targets.targets[0].filename(), "tests/test_data/firmware.txt");
-    EXPECT_EQ(director_targets.targets[0].length(), 17);
-    EXPECT_EQ(director_targets.targets[0].sha256Hash(),
+    EXPECT_EQ(director_targets.targets().size(), 1);
+    EXPECT_EQ(director_targets.targets()[0].filename(), "tests/test_data/firmware.txt");
+    EXPECT_EQ(director_targets.targets()[0].length(), 17);
+    EXPECT_EQ(director_targets.targets()[0].sha256Hash(),
               "d8e9caba8c1697fcbade1057f9c2488044192ff76bb64d4aba2c20e53dc33033");
   }
   check_repo(temp_dir);
@@ -324,7 +324,7 @@ TEST(uptane_generator, delegation_revoke) {
   EXPECT_EQ(new_targets["signed"]["version"].asUInt(), 3);
   auto signed_targets = Utils::parseJSONFile(temp_dir.Path() / DirectorRepo::dir / "targets.json");
   Uptane::Targets director_targets(signed_targets);
-  EXPECT_EQ(director_targets.targets.size(), 0);
+  EXPECT_EQ(director_targets.targets().size(), 0);
 }
 
 /*
@@ -8,6 +8,7 @@
 #include <boost/filesystem.hpp>
 
 #include "crypto/crypto.h"
+#include "crypto/signer.h"
 #include "logging/logging.h"
 #include "uptane/manifest.h"
 #include "uptane/tuf.h"
@@ -43,6 +44,7 @@ ManagedSecondary::ManagedSecondary(Primary::ManagedSecondaryConfig sconfig_in)
     // do not store keys yet, wait until SotaUptaneClient performed device initialization
   }
   public_key_ = PublicKey(public_key_string, sconfig.key_type);
+  signer_ = std_::make_unique<Signer>(sconfig.key_type, nullptr, private_key);
   Initialize();
 }
 
@@ -149,10 +151,9 @@ data::InstallationResult ManagedSecondary::sendFirmware(const Uptane::Target &ta
 }
 
 data::InstallationResult ManagedSecondary::install(const Uptane::Target &target) {
-  auto str = secondary_provider_->getTargetFileHandle(target);
+  auto str = secondary_provider_->getTargetStream(target);
   std::ofstream out_file(sconfig.firmware_path.string(), std::ios::binary);
-  out_file << str.rdbuf();
-  str.close();
+  out_file << str->rdbuf();
   out_file.close();
 
   Utils::writeFile(sconfig.target_name_path, target.filename());
@@ -173,9 +174,9 @@ Uptane::Manifest ManagedSecondary::getManifest() const {
 
   Json::Value signed_ecu_version;
 
-  std::string b64sig = Utils::toBase64(Crypto::RSAPSSSign(nullptr, private_key, Utils::jsonToCanonicalStr(manifest)));
+  std::string b64sig = Utils::toBase64(signer_->sign(Utils::jsonToCanonicalStr(manifest)));
   Json::Value signature;
-  signature["method"] = "rsassa-pss";
+  signature["method"] = signer_->method();
   signature["sig"] = b64sig;
 
   signature["keyid"] = public_key_.KeyId();
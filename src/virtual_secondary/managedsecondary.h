@@ -12,6 +12,8 @@
 #include "libaktualizr/types.h"
 #include "primary/secondary_config.h"
 
+class Signer;
+
 namespace Primary {
 
 struct MetaPack;
@@ -85,6 +87,7 @@ class ManagedSecondary : public SecondaryInterface {
 
   PublicKey public_key_;
   std::string private_key;
+  std::unique_ptr<Signer> signer_;
   std::unique_ptr<MetaPack> current_meta;
   std::unique_ptr<Uptane::MetaBundle> meta_bundle_;
 };
@@ -27,8 +27,12 @@ class TreehubServerHandler(BaseHTTPRequestHandler):
         path = os.path.join(repo_path, self.path[1:])
         if os.path.exists(path):
             self.send_response_only(200)
+        elif args.retry_after:
+            self.send_response_only(503)
         else:
             self.send_response_only(404)
+        if args.retry_after:
+            self.send_header('Retry-After', str(args.retry_after))
         self.end_headers()
 
     def do_GET(self):
@@ -165,6 +169,8 @@ if __name__ == "__main__":
     parser.add_argument('-f', '--fail', type=int, help='fail every nth request')
     parser.add_argument('-s', '--sleep', type=float,
                         help='sleep for n.n seconds for every GET request')
+    parser.add_argument('-r', '--retry-after', type=int,
+                        help='send Retry-After with every HEAD response, and 503 for missing objects')
     parser.add_argument('-t', '--tls', action='store_true',
                         help='require TLS from clients')
     args = parser.parse_args()
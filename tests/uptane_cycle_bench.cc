@@ -0,0 +1,455 @@
+/*
+ * Run one Uptane update cycle against a local fake server and write how long
+ * each phase took, the peak memory use of the Primary and how many bytes were
+ * transferred to a JSON file.
+ *
+ * The repository is generated with uptane-generator on every run and served by
+ * tests/fake_http_server/fake_test_server.py, so no network access is needed.
+ * IP Secondaries are aktualizr-secondary processes listening on localhost.
+ * Run it from the source directory.
+ */
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/process.hpp>
+#include <boost/program_options.hpp>
+
+#include "http/httpclient.h"
+#include "ipuptanesecondary.h"
+#include "libaktualizr/aktualizr.h"
+#include "libaktualizr/config.h"
+#include "libaktualizr/events.h"
+#include "logging/logging.h"
+#include "storage/invstorage.h"
+#include "test_utils.h"
+#include "uptane_repo.h"
+#include "utilities/utils.h"
+#include "virtualsecondary.h"
+
+namespace po = boost::program_options;
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const std::string kHardwareId = "bench_hw";
+const std::string kPrimarySerial = "bench-primary";
+
+double toMs(Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+/* Wall time from the first start to the last end of a set of possibly concurrent operations. */
+class Span {
+ public:
+  void add(Clock::time_point start, Clock::time_point end) {
+    std::lock_guard<std::mutex> lock(m_);
+    if (empty_ || start < start_) {
+      start_ = start;
+    }
+    if (empty_ || end_ < end) {
+      end_ = end;
+    }
+    empty_ = false;
+  }
+  double ms() const {
+    std::lock_guard<std::mutex> lock(m_);
+    return empty_ ? 0. : toMs(end_ - start_);
+  }
+
+ private:
+  mutable std::mutex m_;
+  bool empty_{true};
+  Clock::time_point start_;
+  Clock::time_point end_;
+};
+
+/* Counts the time spent in, and the bytes exchanged by, the requests to the server. */
+class CountingHttpClient : public HttpClient {
+ public:
+  using HttpClient::post;
+  using HttpClient::put;
+
+  HttpResponse get(const std::string &url, int64_t maxsize) override {
+    const auto start = Clock::now();
+    HttpResponse response = HttpClient::get(url, maxsize);
+    get_time_ += (Clock::now() - start).count();
+    received_ += response.body.size();
+    return response;
+  }
+  HttpResponse post(const std::string &url, const std::string &content_type, const std::string &data) override {
+    sent_ += data.size();
+    return HttpClient::post(url, content_type, data);
+  }
+  HttpResponse put(const std::string &url, const std::string &content_type, const std::string &data) override {
+    sent_ += data.size();
+    return HttpClient::put(url, content_type, data);
+  }
+
+  Clock::duration getTime() const { return Clock::duration(get_time_.load()); }
+  uint64_t received() const { return received_; }
+  uint64_t sent() const { return sent_; }
+
+ private:
+  std::atomic<Clock::rep> get_time_{0};
+  std::atomic<uint64_t> received_{0};
+  std::atomic<uint64_t> sent_{0};
+};
+
+struct SecondarySpans {
+  Span metadata;
+  Span firmware;
+  Span install;
+  std::atomic<uint64_t> firmware_bytes{0};
+};
+
+/* Times the calls the Primary makes to a Secondary. */
+class TimedSecondary : public SecondaryInterface {
+ public:
+  TimedSecondary(SecondaryInterface::Ptr secondary, SecondarySpans &spans)
+      : secondary_(std::move(secondary)), spans_(spans) {}
+
+  void init(std::shared_ptr<SecondaryProvider> secondary_provider_in) override {
+    secondary_->init(std::move(secondary_provider_in));
+  }
+  std::string Type() const override { return secondary_->Type(); }
+  Uptane::EcuSerial getSerial() const override { return secondary_->getSerial(); }
+  Uptane::HardwareIdentifier getHwId() const override { return secondary_->getHwId(); }
+  PublicKey getPublicKey() const override { return secondary_->getPublicKey(); }
+  Uptane::Manifest getManifest() const override { return secondary_->getManifest(); }
+  bool ping() const override { return secondary_->ping(); }
+  int32_t getRootVersion(bool director) const override { return secondary_->getRootVersion(director); }
+
+  data::InstallationResult putMetadata(const Uptane::Target &target) override {
+    const auto start = Clock::now();
+    data::InstallationResult result = secondary_->putMetadata(target);
+    spans_.metadata.add(start, Clock::now());
+    return result;
+  }
+  data::InstallationResult putRoot(const std::string &root, bool director) override {
+    const auto start = Clock::now();
+    data::InstallationResult result = secondary_->putRoot(root, director);
+    spans_.metadata.add(start, Clock::now());
+    return result;
+  }
+  data::InstallationResult sendFirmware(const Uptane::Target &target) override {
+    const auto start = Clock::now();
+    data::InstallationResult result = secondary_->sendFirmware(target);
+    spans_.firmware.add(start, Clock::now());
+    if (result.isSuccess()) {
+      spans_.firmware_bytes += target.length();
+    }
+    return result;
+  }
+  data::InstallationResult install(const Uptane::Target &target) override {
+    const auto start = Clock::now();
+    data::InstallationResult result = secondary_->install(target);
+    spans_.install.add(start, Clock::now());
+    return result;
+  }
+
+ private:
+  SecondaryInterface::Ptr secondary_;
+  SecondarySpans &spans_;
+};
+
+class BenchAktualizr : public Aktualizr {
+ public:
+  BenchAktualizr(Config &config, std::shared_ptr<INvStorage> storage, std::shared_ptr<HttpInterface> http)
+      : Aktualizr(config, std::move(storage), std::move(http)) {}
+};
+
+/* Image content does not depend on anything but its index, so that runs are comparable. */
+void writeImage(const boost::filesystem::path &path, uint64_t size, unsigned index) {
+  std::mt19937 generator(index);
+  std::string content(size, '\0');
+  std::generate(content.begin(), content.end(), [&generator]() { return static_cast<char>(generator()); });
+  Utils::writeFile(path, content);
+}
+
+std::string imageName(unsigned index, unsigned delegations) {
+  const std::string name = "image-" + std::to_string(index) + ".bin";
+  if (delegations == 0) {
+    return name;
+  }
+  return "delegation-" + std::to_string(index % delegations) + "/" + name;
+}
+
+void generateRepo(const boost::filesystem::path &repo_dir, const boost::filesystem::path &images_dir,
+                  unsigned targets, unsigned delegations, uint64_t image_size,
+                  const std::vector<std::string> &ecu_serials) {
+  UptaneRepo repo(repo_dir, "", "");
+  repo.generateRepo(KeyType::kED25519);
+  for (unsigned i = 0; i < delegations; ++i) {
+    const std::string name = "delegation-" + std::to_string(i);
+    repo.addDelegation(Uptane::Role::Delegation(name), Uptane::Role::Targets(), name + "/*", false, KeyType::kED25519);
+  }
+  for (unsigned i = 0; i < targets; ++i) {
+    const boost::filesystem::path image = images_dir / ("image-" + std::to_string(i) + ".bin");
+    writeImage(image, image_size, i);
+    Delegation delegation;
+    if (delegations != 0) {
+      delegation = Delegation(repo_dir, "delegation-" + std::to_string(i % delegations));
+    }
+    repo.addImage(image, imageName(i, delegations), kHardwareId, "", delegation);
+  }
+  for (size_t i = 0; i < ecu_serials.size(); ++i) {
+    repo.addTarget(imageName(static_cast<unsigned>(i % targets), delegations), kHardwareId, ecu_serials[i], "");
+  }
+  repo.signTargets();
+}
+
+boost::process::child startIpSecondary(const boost::filesystem::path &exec, const boost::filesystem::path &dir,
+                                       const std::string &serial, in_port_t port) {
+  Utils::createDirectories(dir, S_IRWXU);
+  std::stringstream config;
+  config << "[uptane]\n"
+         << "ecu_serial = \"" << serial << "\"\n"
+         << "ecu_hardware_id = \"" << kHardwareId << "\"\n"
+         << "key_type = \"ED25519\"\n\n"
+         << "[network]\n"
+         << "port = " << port << "\n\n"
+         << "[storage]\n"
+         << "path = \"" << dir.string() << "\"\n\n"
+         << "[pacman]\n"
+         << "type = \"none\"\n\n"
+         << "[bootloader]\n"
+         << "reboot_sentinel_dir = \"" << dir.string() << "\"\n";
+  Utils::writeFile(dir / "config.toml", config.str());
+  return boost::process::child(exec.string(), "-c", (dir / "config.toml").string(),
+                               boost::process::std_out > boost::process::null,
+                               boost::process::std_err > boost::process::null);
+}
+
+SecondaryInterface::Ptr connectIpSecondary(in_port_t port) {
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    auto secondary = Uptane::IpUptaneSecondary::connectAndCreate("127.0.0.1", port);
+    if (secondary != nullptr) {
+      return secondary;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  throw std::runtime_error("IP Secondary on port " + std::to_string(port) + " did not come up");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  po::options_description desc("aktualizr-cycle-bench command line options");
+  // clang-format off
+  desc.add_options()
+    ("help,h", "print usage")
+    ("targets", po::value<unsigned>()->default_value(4), "number of images in the Image repository")
+    ("image-size", po::value<uint64_t>()->default_value(1024 * 1024), "size of each image in bytes")
+    ("delegations", po::value<unsigned>()->default_value(0), "number of delegated roles the images are spread over")
+    ("virtual-secondaries", po::value<unsigned>()->default_value(2), "number of virtual Secondaries")
+    ("ip-secondaries", po::value<unsigned>()->default_value(0), "number of IP Secondaries")
+    ("secondary-exec", po::value<boost::filesystem::path>(), "path to aktualizr-secondary, needed for IP Secondaries")
+    ("output,o", po::value<boost::filesystem::path>()->required(), "file to write the results to")
+    ("loglevel", po::value<int>()->default_value(4), "log level 0-5 (trace, debug, info, warning, error, fatal)");
+  // clang-format on
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help") != 0) {
+      std::cout << desc << "\n";
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  } catch (const po::error &e) {
+    std::cerr << e.what() << "\n" << desc << "\n";
+    return EXIT_FAILURE;
+  }
+
+  logger_init();
+  logger_set_threshold(static_cast<boost::log::trivial::severity_level>(vm["loglevel"].as<int>()));
+
+  const unsigned targets = std::max(vm["targets"].as<unsigned>(), 1U);
+  const uint64_t image_size = vm["image-size"].as<uint64_t>();
+  const unsigned delegations = vm["delegations"].as<unsigned>();
+  const unsigned virtual_secondaries = vm["virtual-secondaries"].as<unsigned>();
+  const unsigned ip_secondaries = vm["ip-secondaries"].as<unsigned>();
+  if (ip_secondaries != 0 && vm.count("secondary-exec") == 0) {
+    std::cerr << "--secondary-exec is needed for IP Secondaries\n";
+    return EXIT_FAILURE;
+  }
+
+  TemporaryDirectory temp_dir("cycle-bench");
+  std::vector<std::string> ecu_serials{kPrimarySerial};
+  for (unsigned i = 0; i < virtual_secondaries; ++i) {
+    ecu_serials.push_back("virtual-secondary-" + std::to_string(i));
+  }
+  for (unsigned i = 0; i < ip_secondaries; ++i) {
+    ecu_serials.push_back("ip-secondary-" + std::to_string(i));
+  }
+
+  const auto generate_start = Clock::now();
+  Utils::createDirectories(temp_dir / "images", S_IRWXU);
+  generateRepo(temp_dir / "repo", temp_dir / "images", targets, delegations, image_size, ecu_serials);
+  const double generate_ms = toMs(Clock::now() - generate_start);
+
+  const std::string port = TestUtils::getFreePort();
+  const std::string server = "http://127.0.0.1:" + port;
+  boost::process::child server_process("tests/fake_http_server/fake_test_server.py", port, "-m",
+                                       (temp_dir / "repo").string(), "-s", boost::filesystem::current_path().string(),
+                                       boost::process::std_out > boost::process::null,
+                                       boost::process::std_err > boost::process::null);
+  TestUtils::waitForServer(server + "/");
+
+  std::vector<boost::process::child> secondary_processes;
+  std::vector<in_port_t> secondary_ports;
+  for (unsigned i = 0; i < ip_secondaries; ++i) {
+    const in_port_t secondary_port = ntohs(TestUtils::getFreePortAsInt());
+    secondary_processes.push_back(startIpSecondary(vm["secondary-exec"].as<boost::filesystem::path>(),
+                                                   temp_dir / ("ip-secondary-" + std::to_string(i)),
+                                                   "ip-secondary-" + std::to_string(i), secondary_port));
+    secondary_ports.push_back(secondary_port);
+  }
+
+  Config conf;
+  conf.pacman.type = PACKAGE_MANAGER_NONE;
+  conf.pacman.images_path = temp_dir / "primary" / "images";
+  conf.provision.device_id = "bench-device";
+  conf.provision.ecu_registration_endpoint = server + "/director/ecus";
+  conf.provision.server = server;
+  conf.provision.provision_path = "tests/test_data/cred.zip";
+  conf.provision.mode = ProvisionMode::kSharedCredReuse;
+  conf.provision.primary_ecu_serial = kPrimarySerial;
+  conf.provision.primary_ecu_hardware_id = kHardwareId;
+  conf.tls.server = server;
+  conf.uptane.director_server = server + "/director";
+  conf.uptane.repo_server = server + "/repo";
+  conf.uptane.key_type = KeyType::kED25519;
+  conf.storage.path = temp_dir / "primary";
+  conf.bootloader.reboot_sentinel_dir = temp_dir / "primary";
+  conf.logger.loglevel = vm["loglevel"].as<int>();
+  conf.postUpdateValues();
+
+  auto http = std::make_shared<CountingHttpClient>();
+  SecondarySpans secondary_spans;
+  Span primary_install;
+  Clock::time_point check_end;
+  Clock::time_point download_end;
+  Clock::time_point install_start;
+  Clock::time_point install_end;
+  Clock::time_point manifest_end;
+  Clock::duration check_get_time{};
+  uint64_t metadata_received = 0;
+  std::atomic<uint64_t> images_downloaded{0};
+  bool success = false;
+
+  Clock::time_point cycle_start;
+  Clock::time_point cycle_end;
+  {
+    BenchAktualizr aktualizr(conf, INvStorage::newStorage(conf.storage), http);
+    for (unsigned i = 0; i < virtual_secondaries; ++i) {
+      Primary::VirtualSecondaryConfig sconf;
+      sconf.partial_verifying = false;
+      sconf.ecu_serial = "virtual-secondary-" + std::to_string(i);
+      sconf.ecu_hardware_id = kHardwareId;
+      sconf.full_client_dir = temp_dir / sconf.ecu_serial;
+      sconf.ecu_private_key = "sec.priv";
+      sconf.ecu_public_key = "sec.pub";
+      sconf.key_type = KeyType::kED25519;
+      sconf.firmware_path = sconf.full_client_dir / "firmware.bin";
+      sconf.target_name_path = sconf.full_client_dir / "firmware_name.txt";
+      sconf.metadata_path = sconf.full_client_dir / "metadata";
+      auto secondary = std::make_shared<Primary::VirtualSecondary>(sconf);
+      aktualizr.AddSecondary(std::make_shared<TimedSecondary>(secondary, secondary_spans));
+    }
+    for (const in_port_t secondary_port : secondary_ports) {
+      aktualizr.AddSecondary(std::make_shared<TimedSecondary>(connectIpSecondary(secondary_port), secondary_spans));
+    }
+
+    // Events are delivered synchronously, some of them from the threads that download and install.
+    auto on_event = [&](const std::shared_ptr<event::BaseEvent> &event) {
+      const auto now = Clock::now();
+      if (event->isTypeOf<event::UpdateCheckComplete>()) {
+        check_end = now;
+        check_get_time = http->getTime();
+        metadata_received = http->received();
+      } else if (event->isTypeOf<event::DownloadTargetComplete>()) {
+        const auto &download = static_cast<const event::DownloadTargetComplete &>(*event);
+        if (download.success) {
+          images_downloaded += download.update.length();
+        }
+      } else if (event->isTypeOf<event::AllDownloadsComplete>()) {
+        download_end = now;
+      } else if (event->isTypeOf<event::InstallStarted>()) {
+        if (static_cast<const event::InstallStarted &>(*event).serial.ToString() == kPrimarySerial) {
+          install_start = now;
+        }
+      } else if (event->isTypeOf<event::InstallTargetComplete>()) {
+        if (static_cast<const event::InstallTargetComplete &>(*event).serial.ToString() == kPrimarySerial) {
+          primary_install.add(install_start, now);
+        }
+      } else if (event->isTypeOf<event::AllInstallsComplete>()) {
+        install_end = now;
+        success = static_cast<const event::AllInstallsComplete &>(*event).result.dev_report.success;
+      } else if (event->isTypeOf<event::PutManifestComplete>()) {
+        if (install_end != Clock::time_point()) {
+          manifest_end = now;
+        }
+      }
+    };
+    boost::signals2::scoped_connection connection(aktualizr.SetSignalHandler(on_event));
+
+    aktualizr.Initialize();
+    // Registration and provisioning are not part of the cycle.
+    const Clock::duration setup_get_time = http->getTime();
+    const uint64_t setup_received = http->received();
+    const uint64_t setup_sent = http->sent();
+    cycle_start = Clock::now();
+    aktualizr.UptaneCycle();
+    cycle_end = Clock::now();
+    check_get_time -= setup_get_time;
+    metadata_received -= setup_received;
+
+    const double check_ms = toMs(check_end - cycle_start);
+    const double fetch_ms = toMs(check_get_time);
+
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    Json::Value results;
+    results["parameters"]["targets"] = targets;
+    results["parameters"]["image_size"] = static_cast<Json::UInt64>(image_size);
+    results["parameters"]["delegations"] = delegations;
+    results["parameters"]["virtual_secondaries"] = virtual_secondaries;
+    results["parameters"]["ip_secondaries"] = ip_secondaries;
+    results["success"] = success;
+    results["repo_generation_ms"] = generate_ms;
+    results["phases_ms"]["metadata_fetch"] = fetch_ms;
+    results["phases_ms"]["metadata_verification"] = std::max(check_ms - fetch_ms, 0.);
+    results["phases_ms"]["download"] = toMs(download_end - check_end);
+    results["phases_ms"]["metadata_push"] = secondary_spans.metadata.ms();
+    results["phases_ms"]["firmware_send"] = secondary_spans.firmware.ms();
+    results["phases_ms"]["install"] = std::max(primary_install.ms(), secondary_spans.install.ms());
+    results["phases_ms"]["manifest_upload"] =
+        manifest_end != Clock::time_point() ? toMs(manifest_end - install_end) : 0.;
+    results["phases_ms"]["total"] = toMs(cycle_end - cycle_start);
+    results["peak_rss_kib"] = static_cast<Json::Int64>(usage.ru_maxrss);
+    results["bytes"]["metadata_received"] = static_cast<Json::UInt64>(metadata_received);
+    results["bytes"]["images_downloaded"] = static_cast<Json::UInt64>(images_downloaded.load());
+    results["bytes"]["sent_to_server"] = static_cast<Json::UInt64>(http->sent() - setup_sent);
+    results["bytes"]["firmware_to_secondaries"] = static_cast<Json::UInt64>(secondary_spans.firmware_bytes.load());
+
+    Utils::writeFile(vm["output"].as<boost::filesystem::path>(), results);
+  }
+
+  for (auto &secondary_process : secondary_processes) {
+    secondary_process.terminate();
+  }
+  server_process.terminate();
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}